@@ -0,0 +1,73 @@
+# graphicat_add_shaders(<target> NAME <header>
+#                       [NAMESPACE <namespace>]
+#                       [INCLUDE_DIRECTORIES <dir>...]
+#                       [DEFINES <NAME[=VALUE]>...]
+#                       [ASSIGN_LOCATIONS]
+#                       [PROGRAMS <name>=<file>,<file>...]
+#                       SHADERS <file>...)
+#
+# Preprocesses the shaders at build time and generates <header>.hpp, which embeds each of them as a gc::EmbeddedShader named after
+# the file (basic.vert -> <namespace>::basic_vert) with its hash already computed, plus <namespace>::uniforms and
+# <namespace>::locations for the uniforms they declare. The stage comes from the extension (.vert .frag .geom .tesc .tese .comp).
+#
+# Each PROGRAMS entry adds a struct <namespace>::<name> with a gc::Uniform<T, Location> field per uniform in its files (given by file
+# name), constructed from the linked gc::Shader, and a sources() helper to create it from. ASSIGN_LOCATIONS gives uniforms without
+# layout(location = N) one, consistently across every shader in the call, and embeds the rewritten source.
+#
+# If glslangValidator is found (or GRAPHICAT_GLSLANG_VALIDATOR points at it) the expanded sources are validated as part of the build.
+
+find_program(GRAPHICAT_GLSLANG_VALIDATOR glslangValidator)
+option(GRAPHICAT_VALIDATE_SHADERS "Validate embedded shaders with glslangValidator when it is available" ON)
+
+function(graphicat_add_shaders target)
+    cmake_parse_arguments(PARSE_ARGV 1 ARG "ASSIGN_LOCATIONS" "NAME;NAMESPACE" "SHADERS;INCLUDE_DIRECTORIES;DEFINES;PROGRAMS")
+
+    if (NOT ARG_NAME)
+        message(FATAL_ERROR "graphicat_add_shaders: NAME is required")
+    endif ()
+    if (NOT ARG_SHADERS)
+        message(FATAL_ERROR "graphicat_add_shaders: no SHADERS given")
+    endif ()
+    if (NOT ARG_NAMESPACE)
+        set(ARG_NAMESPACE ${ARG_NAME})
+    endif ()
+
+    set(output_dir ${CMAKE_CURRENT_BINARY_DIR}/graphicat_shaders/${target})
+    set(header ${output_dir}/${ARG_NAME}.hpp)
+
+    set(args --output ${header} --depfile ${header}.d --namespace ${ARG_NAMESPACE})
+    foreach (dir IN LISTS ARG_INCLUDE_DIRECTORIES)
+        cmake_path(ABSOLUTE_PATH dir BASE_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR})
+        list(APPEND args --include-dir ${dir})
+    endforeach ()
+    foreach (define IN LISTS ARG_DEFINES)
+        list(APPEND args --define ${define})
+    endforeach ()
+    if (ARG_ASSIGN_LOCATIONS)
+        list(APPEND args --assign-locations)
+    endif ()
+    foreach (program IN LISTS ARG_PROGRAMS)
+        list(APPEND args --program ${program})
+    endforeach ()
+    if (GRAPHICAT_VALIDATE_SHADERS AND GRAPHICAT_GLSLANG_VALIDATOR)
+        list(APPEND args --validator ${GRAPHICAT_GLSLANG_VALIDATOR})
+    endif ()
+
+    set(shaders)
+    foreach (shader IN LISTS ARG_SHADERS)
+        cmake_path(ABSOLUTE_PATH shader BASE_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR})
+        list(APPEND shaders ${shader})
+    endforeach ()
+
+    add_custom_command(
+            OUTPUT ${header}
+            COMMAND graphicat_shader_embed ${args} ${shaders}
+            DEPENDS graphicat_shader_embed ${shaders}
+            DEPFILE ${header}.d
+            COMMENT "Embedding shaders for ${target}"
+            VERBATIM
+    )
+
+    target_sources(${target} PRIVATE ${header})
+    target_include_directories(${target} PRIVATE ${output_dir})
+endfunction()
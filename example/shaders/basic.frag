@@ -0,0 +1,10 @@
+#version 460 core
+
+in vec2 fUV;
+in vec4 fColor;
+
+out vec4 colorOut;
+
+void main() {
+    colorOut = fColor;
+}
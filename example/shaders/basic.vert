@@ -0,0 +1,16 @@
+#version 460 core
+
+in vec3 posIn;
+in vec2 uvIn;
+in vec4 colorIn;
+
+out vec2 fUV;
+out vec4 fColor;
+
+uniform mat4 uTransform;
+
+void main() {
+    gl_Position = uTransform * vec4(posIn, 1.0);
+    fUV = uvIn;
+    fColor = colorIn;
+}
@@ -6,8 +6,10 @@
 #include <glad/gl.h>
 #include "graphicat/graphics/utils.hpp"
 #include "graphicat/graphics/shader.hpp"
+#include "graphicat/graphics/shader_profiler.hpp"
 #include "graphicat/graphics/vertex_array.hpp"
 #include "graphicat/graphics/buffer.hpp"
+#include "example_shaders.hpp"
 
 int main() {
     gc::GlobalState::init();
@@ -17,29 +19,10 @@ int main() {
 
     auto window = std::make_unique<gc::Window>(window_properties);
 
-    std::string vsh = "#version 460 core\n"
-                      "in vec3 posIn;"
-                      "in vec2 uvIn;"
-                      "in vec4 colorIn;"
-                      "out vec2 fUV;"
-                      "out vec4 fColor;"
-                      "uniform mat4 uTransform;"
-                      "void main() {"
-                      "  gl_Position = uTransform * vec4(posIn, 1.0);"
-                      "  fUV = uvIn;"
-                      "  fColor = colorIn;"
-                      "}";
-
-    std::string fsh = "#version 460 core\n"
-                      "in vec2 fUV;"
-                      "in vec4 fColor;"
-                      "out vec4 colorOut;"
-                      "void main() {"
-                      "  colorOut = fColor;"
-                      "}";
-
-
-    auto shader = gc::Shader::create({{gc::ShaderType::Vertex, vsh}, {gc::ShaderType::Fragment, fsh}});
+    // Off by default; turned on before the first compile so log_report below has something to show.
+    gc::ShaderProfiler::set_enabled(true);
+    auto shader = gc::Shader::create(example_shaders::basic::sources());
+    example_shaders::basic uniforms(*shader);
 
     auto vao = gc::VertexArray::create();
 
@@ -53,13 +36,15 @@ int main() {
 
     vao->vertex_buffer(vbo, { { 3, "posIn" }, { 2, "uvIn" }, { 4, "colorIn" } });
 
+    gc::ShaderProfiler::log_report();
+
     while (window->is_open()) {
         glfwPollEvents();
 
         gc::clear({1.0f, 0.0f, 0.0f});
 
         shader->bind();
-        shader->uniform_mat4f("uTransform", glm::mat4(1.0f));
+        uniforms.uTransform.set(glm::mat4(1.0f));
 
         vao->bind(shader);
         glDrawArrays(GL_TRIANGLES, 0, 3);
@@ -1,6 +1,15 @@
 #include "graphicat.hpp"
 
 #include "graphicat/os/window.hpp"
+#include "graphicat/graphics/barrier_tracker.hpp"
+#include "graphicat/graphics/debug_draw.hpp"
+#include "graphicat/graphics/program_cache.hpp"
+#include "graphicat/graphics/shader_compiler.hpp"
+#include "graphicat/graphics/state_cache.hpp"
+#include "graphicat/util/job_system.hpp"
+#include "graphicat/util/task.hpp"
+#include <algorithm>
+#include <thread>
 
 namespace gc {
 
@@ -18,8 +27,47 @@ namespace gc {
 
     GlobalState::GlobalState(const GraphicatProperties &properties) {
         gc::WindowSystem::init();
+
+        barrier_tracker = std::make_unique<BarrierTracker>();
+        state_cache = std::make_unique<StateCache>(properties.validate_state_cache);
+        if (properties.debug_draw_lines != 0) debug_draw = std::make_unique<DebugDraw>(properties.debug_draw_lines);
+
+        unsigned int hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        job_system = std::make_unique<JobSystem>(properties.job_threads.value_or(std::max(hardware_threads - 1, 1u)));
+        gl_executor = std::make_unique<GLExecutor>();
+
+        if (properties.program_cache_path)
+            program_cache = std::make_unique<ProgramCache>(*properties.program_cache_path);
     }
 
-    GlobalState::~GlobalState() { gc::WindowSystem::terminate(); }
+    GlobalState::~GlobalState() {
+        // Workers may still be running jobs that use everything else.
+        job_system.reset();
+        // Destroys coroutines still waiting for the GL thread, which may own GL objects.
+        gl_executor.reset();
+        // The compiler owns a GLFW window, so it has to go before GLFW does.
+        shader_compiler.reset();
+        program_cache.reset();
+
+        gc::WindowSystem::terminate();
+    }
+
+    ProgramCache *GlobalState::get_program_cache() const noexcept { return program_cache.get(); }
+
+    BarrierTracker *GlobalState::get_barrier_tracker() const noexcept { return barrier_tracker.get(); }
+
+    StateCache *GlobalState::get_state_cache() const noexcept { return state_cache.get(); }
+
+    DebugDraw *GlobalState::get_debug_draw() const noexcept { return debug_draw.get(); }
+
+    JobSystem *GlobalState::get_job_system() const noexcept { return job_system.get(); }
+
+    GLExecutor *GlobalState::get_gl_executor() const noexcept { return gl_executor.get(); }
+
+    ShaderCompiler *GlobalState::get_shader_compiler() {
+        if (!shader_compiler)
+            shader_compiler = std::make_unique<ShaderCompiler>();
+        return shader_compiler.get();
+    }
 
 } // namespace gc
\ No newline at end of file
@@ -2,13 +2,43 @@
 
 #include <glad/gl.h>
 #include <glm/glm.hpp>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <optional>
 
 namespace gc {
-    struct GraphicatProperties {};
+    class BarrierTracker;
+    class DebugDraw;
+    class GLExecutor;
+    class JobSystem;
+    class ProgramCache;
+    class ShaderCompiler;
+    class StateCache;
+
+    struct GraphicatProperties {
+        // Where linked program binaries are cached between runs. Leave empty to always compile from source.
+        std::optional<std::filesystem::path> program_cache_path;
+        // Check the state cache against glGet* on every bind. Slow; for tracking down binds made behind its back.
+        bool validate_state_cache = false;
+        // Lines each thread can have queued through gc::debug_draw between renders. 0 turns debug drawing off.
+        std::size_t debug_draw_lines = 16 * 1024;
+        // Worker threads of the JobSystem. Defaults to one less than the hardware threads, leaving one for the thread that calls
+        // GlobalState::init, but at least 1. 0 runs every job on whichever thread waits for it, or inline for JobSystem::submit.
+        std::optional<unsigned int> job_threads;
+    };
 
     class GlobalState {
         inline static GlobalState *s_global_state;
 
+        std::unique_ptr<ProgramCache> program_cache;
+        std::unique_ptr<ShaderCompiler> shader_compiler;
+        std::unique_ptr<BarrierTracker> barrier_tracker;
+        std::unique_ptr<StateCache> state_cache;
+        std::unique_ptr<DebugDraw> debug_draw;
+        std::unique_ptr<JobSystem> job_system;
+        std::unique_ptr<GLExecutor> gl_executor;
+
         GlobalState(const GraphicatProperties &properties = {});
 
     public : ~GlobalState();
@@ -17,7 +47,16 @@ namespace gc {
         static void terminate();
 
         static GlobalState *get();
+
+        [[nodiscard]] ProgramCache *get_program_cache() const noexcept;
+        [[nodiscard]] BarrierTracker *get_barrier_tracker() const noexcept;
+        [[nodiscard]] StateCache *get_state_cache() const noexcept;
+        [[nodiscard]] DebugDraw *get_debug_draw() const noexcept;
+        [[nodiscard]] JobSystem *get_job_system() const noexcept;
+        [[nodiscard]] GLExecutor *get_gl_executor() const noexcept;
+        // Created on first use, which has to happen on the GL thread with a context current.
+        [[nodiscard]] ShaderCompiler *get_shader_compiler();
     };
 
 
-} // namespace gc
\ No newline at end of file
+} // namespace gc
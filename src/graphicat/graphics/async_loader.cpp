@@ -0,0 +1,60 @@
+#include "async_loader.hpp"
+#include "shader_compiler.hpp"
+#include <algorithm>
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+namespace gc {
+
+    Task<std::vector<std::byte>> read_file_async(std::filesystem::path path) {
+        co_await switch_to_jobs();
+
+        std::ifstream f(path, std::ios::ate | std::ios::in | std::ios::binary);
+        if (!f) {
+            spdlog::error("Could not open {}", path.string());
+            co_return std::vector<std::byte>{};
+        }
+
+        std::vector<std::byte> data(static_cast<std::size_t>(f.tellg()));
+        f.seekg(0);
+        if (!f.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()))) {
+            spdlog::error("Could not read {}", path.string());
+            data.clear();
+        }
+        co_return data;
+    }
+
+    Task<std::shared_ptr<Shader>> create_shader_async(std::vector<ShaderSource> sources) {
+        co_await switch_to_gl();
+        std::unique_ptr<PendingShader> pending = Shader::create_async(sources);
+
+        // With parallel compile (or the compile thread) the build finishes on its own; look in once a frame instead of blocking.
+        while (!pending->is_ready()) co_await yield_to_next_frame();
+        co_return pending->get();
+    }
+
+    Task<std::shared_ptr<Shader>> load_shader_async(std::vector<std::pair<ShaderType, std::filesystem::path>> sources) {
+        co_await switch_to_jobs();
+        std::vector<ShaderSource> loaded = detail::read_sources(sources);
+        co_return co_await create_shader_async(std::move(loaded));
+    }
+
+    Task<std::shared_ptr<Buffer>> upload_buffer_async(std::span<const std::byte> data, BufferUsage usage) {
+        co_await switch_to_gl();
+        if (data.size() <= async_upload_chunk) co_return Buffer::load_shared(data.size(), data.data(), usage);
+
+        std::shared_ptr<Buffer> buffer = Buffer::allocate_shared(data.size(), usage);
+        for (std::size_t offset = 0; offset < data.size(); offset += async_upload_chunk) {
+            if (offset != 0) co_await yield_to_next_frame();
+            buffer->update(offset, std::min(async_upload_chunk, data.size() - offset), data.data() + offset);
+        }
+        co_return buffer;
+    }
+
+    Task<std::shared_ptr<Buffer>> load_buffer_async(std::filesystem::path path, BufferUsage usage) {
+        std::vector<std::byte> data = co_await read_file_async(std::move(path));
+        if (data.empty()) co_return nullptr;
+        co_return co_await upload_buffer_async(data, usage);
+    }
+
+} // gc
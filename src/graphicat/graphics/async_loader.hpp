@@ -0,0 +1,55 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/buffer.hpp"
+#include "graphicat/graphics/shader.hpp"
+#include "graphicat/util/task.hpp"
+#include <concepts>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace gc {
+
+    // Awaitable versions of the resource loaders. File reads and decoding run on the JobSystem; the GL calls resume on the GL
+    // thread through GLExecutor::run(), and long ones are spread over several frames. Start them with spawn():
+    //
+    //     gc::Future<std::shared_ptr<gc::Shader>> shader = gc::spawn(gc::load_shader_async({
+    //         {gc::ShaderType::Vertex, "mesh.vert"},
+    //         {gc::ShaderType::Fragment, "mesh.frag"},
+    //     }));
+    //
+    // or co_await them from a Task of your own, which is how several loads share one loading screen:
+    //
+    //     gc::Task<Level> load_level() {
+    //         auto shader = co_await gc::load_shader_async({...});
+    //         auto vertices = co_await gc::load_buffer_async("level.bin");
+    //         co_return Level{shader, vertices};
+    //     }
+    //
+    // Failures are logged and give nullptr (or, for shaders, a shader with handle 0, like Shader::create).
+
+    // Bytes uploaded per GL resume by upload_buffer_async, so a big buffer doesn't eat a whole frame's budget at once.
+    inline constexpr std::size_t async_upload_chunk = 4 * 1024 * 1024;
+
+    // The whole file, read on a job. Empty if it can't be read.
+    Task<std::vector<std::byte>> read_file_async(std::filesystem::path path);
+
+    Task<std::shared_ptr<Shader>> create_shader_async(std::vector<ShaderSource> sources);
+    Task<std::shared_ptr<Shader>> load_shader_async(std::vector<std::pair<ShaderType, std::filesystem::path>> sources);
+
+    // `data` has to stay alive until the task finishes, so co_await it straight away.
+    Task<std::shared_ptr<Buffer>> upload_buffer_async(std::span<const std::byte> data, BufferUsage usage = BufferUsage::StaticDraw);
+    Task<std::shared_ptr<Buffer>> load_buffer_async(std::filesystem::path path, BufferUsage usage = BufferUsage::StaticDraw);
+
+    // Runs `decode` on a job and uploads the std::vector it returns.
+    template<std::invocable F> Task<std::shared_ptr<Buffer>> load_buffer_async(F decode, BufferUsage usage = BufferUsage::StaticDraw) {
+        co_await switch_to_jobs();
+        auto data = decode();
+        co_return co_await upload_buffer_async(std::as_bytes(std::span(data)), usage);
+    }
+
+} // gc
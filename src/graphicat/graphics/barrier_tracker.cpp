@@ -0,0 +1,94 @@
+#include "barrier_tracker.hpp"
+#include <algorithm>
+
+namespace gc {
+
+    static constexpr std::array<BufferAccess, 10> accesses = {
+        BufferAccess::VertexAttrib, BufferAccess::ElementArray, BufferAccess::Uniform, BufferAccess::TextureFetch, BufferAccess::Command,
+        BufferAccess::Update, BufferAccess::ClientMapped, BufferAccess::AtomicCounter, BufferAccess::ShaderStorage, BufferAccess::Query,
+    };
+
+    std::size_t BarrierTracker::access_index(BufferAccess access) {
+        return std::find(accesses.begin(), accesses.end(), access) - accesses.begin();
+    }
+
+    void BarrierTracker::write(unsigned int buffer) {
+        if (buffer == 0) return;
+        writes[buffer] = ++epoch;
+    }
+
+    void BarrierTracker::read(unsigned int buffer, BufferAccess access) {
+        if (buffer == 0) return;
+
+        auto it = writes.find(buffer);
+        if (it == writes.end()) return;
+
+        std::size_t i = access_index(access);
+        if (it->second > barrier_epochs[i]) {
+            pending |= static_cast<GLbitfield>(access);
+        } else {
+            stats.elided++;
+        }
+    }
+
+    void BarrierTracker::flush() {
+        if (pending == 0) return;
+
+        glMemoryBarrier(pending);
+        stats.barriers++;
+
+        for (std::size_t i = 0; i < access_count; i++) {
+            if (pending & static_cast<GLbitfield>(accesses[i])) barrier_epochs[i] = epoch;
+        }
+        pending = 0;
+
+        // Once every bit has caught up with the writes, nothing about them needs remembering.
+        bool all_covered = true;
+        for (auto e : barrier_epochs) all_covered = all_covered && e == epoch;
+        if (all_covered) writes.clear();
+    }
+
+    void BarrierTracker::barrier_all() {
+        if (writes.empty() && pending == 0) return;
+
+        glMemoryBarrier(GL_ALL_BARRIER_BITS);
+        stats.barriers++;
+
+        barrier_epochs.fill(epoch);
+        pending = 0;
+        writes.clear();
+    }
+
+    void BarrierTracker::forget(unsigned int buffer) {
+        writes.erase(buffer);
+        std::replace(uniform_bindings.begin(), uniform_bindings.end(), buffer, 0u);
+        std::replace(storage_bindings.begin(), storage_bindings.end(), buffer, 0u);
+    }
+
+    void BarrierTracker::set_binding(BufferTarget target, unsigned int index, unsigned int buffer) {
+        if (index >= max_bindings) return;
+        if (target == BufferTarget::Uniform) uniform_bindings[index] = buffer;
+        else if (target == BufferTarget::ShaderStorage) storage_bindings[index] = buffer;
+    }
+
+    unsigned int BarrierTracker::get_binding(BufferTarget target, unsigned int index) const noexcept {
+        if (index >= max_bindings) return 0;
+        if (target == BufferTarget::Uniform) return uniform_bindings[index];
+        if (target == BufferTarget::ShaderStorage) return storage_bindings[index];
+        return 0;
+    }
+
+    const BarrierStats &BarrierTracker::get_stats() const noexcept {
+        return stats;
+    }
+
+    void BarrierTracker::reset_stats() noexcept {
+        stats = {};
+    }
+
+    BarrierTracker *BarrierTracker::get() {
+        GlobalState *state = GlobalState::get();
+        return state ? state->get_barrier_tracker() : nullptr;
+    }
+
+} // gc
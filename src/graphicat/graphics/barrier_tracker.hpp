@@ -0,0 +1,77 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/buffer.hpp"
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+namespace gc {
+
+    // How a buffer is consumed after a shader wrote to it. Each maps to the glMemoryBarrier bit that makes the write visible to
+    // that kind of read.
+    enum class BufferAccess : GLbitfield {
+        VertexAttrib = GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT,
+        ElementArray = GL_ELEMENT_ARRAY_BARRIER_BIT,
+        Uniform = GL_UNIFORM_BARRIER_BIT,
+        TextureFetch = GL_TEXTURE_FETCH_BARRIER_BIT,
+        Command = GL_COMMAND_BARRIER_BIT,
+        Update = GL_BUFFER_UPDATE_BARRIER_BIT,
+        ClientMapped = GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT,
+        AtomicCounter = GL_ATOMIC_COUNTER_BARRIER_BIT,
+        ShaderStorage = GL_SHADER_STORAGE_BARRIER_BIT,
+        Query = GL_QUERY_BUFFER_BARRIER_BIT,
+    };
+
+    struct BarrierStats {
+        std::uint64_t barriers = 0;
+        // Reads of a written buffer that an earlier barrier already covered.
+        std::uint64_t elided = 0;
+    };
+
+    // Remembers which buffers shaders have written since the last barrier that covers each kind of read, so a read only pays for
+    // the bits it actually needs, and only once. Every barrier bit has an epoch: the write counter at the time it was last issued.
+    // A buffer written after that epoch needs the bit before it is read that way again.
+    //
+    // Shader::dispatch, Shader::bind, VertexArray::bind and Buffer::update report to it; storage bindings go through
+    // Buffer::bind_base/bind_range. Work done with raw GL calls has to be reported by hand.
+    class BarrierTracker {
+        static constexpr std::size_t access_count = 10; // one per BufferAccess
+        static constexpr std::size_t max_bindings = 64;
+
+        std::unordered_map<unsigned int, std::uint64_t> writes;
+        std::array<std::uint64_t, access_count> barrier_epochs{};
+        std::array<unsigned int, max_bindings> uniform_bindings{};
+        std::array<unsigned int, max_bindings> storage_bindings{};
+        std::uint64_t epoch = 0;
+        GLbitfield pending = 0;
+        BarrierStats stats;
+
+        static std::size_t access_index(BufferAccess access);
+
+    public:
+        // A shader wrote to the buffer (storage block, image store, atomic counter...).
+        void write(unsigned int buffer);
+
+        // Queues whatever bit the read needs; it is only issued by flush(), so several reads before a draw share one barrier.
+        void read(unsigned int buffer, BufferAccess access);
+        void flush();
+
+        // Issues and clears everything outstanding, for when the tracker can't see what comes next.
+        void barrier_all();
+
+        // Called by Buffer when its name is deleted so a later buffer reusing it doesn't inherit the write.
+        void forget(unsigned int buffer);
+
+        // Which buffer is bound at each uniform and storage block binding, so a program's blocks can be traced back to buffers.
+        void set_binding(BufferTarget target, unsigned int index, unsigned int buffer);
+        [[nodiscard]] unsigned int get_binding(BufferTarget target, unsigned int index) const noexcept;
+
+        [[nodiscard]] const BarrierStats &get_stats() const noexcept;
+        void reset_stats() noexcept;
+
+        // nullptr if there is no GlobalState, in which case nothing is tracked.
+        static BarrierTracker *get();
+    };
+
+} // gc
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <glm/glm.hpp>
+
+namespace gc {
+
+    // Layout tags for interface blocks. Std140 is what uniform blocks use, Std430 is the tighter layout storage blocks default to.
+    struct Std140 {};
+    struct Std430 {};
+
+    // Wraps an element so that a C++ array of it has the 16 byte stride std140 gives arrays of scalars and vec2s.
+    template<typename T> struct alignas(16) Std140Padded {
+        T value;
+    };
+
+    struct MemberLayout {
+        std::size_t alignment;
+        std::size_t size;
+    };
+
+    struct BlockMember {
+        std::size_t offset;
+        std::size_t cpp_size;
+        MemberLayout std140;
+        MemberLayout std430;
+    };
+
+    // Specialized by GC_BLOCK_LAYOUT with the members of a struct in declaration order.
+    template<typename T> struct block_members;
+
+    namespace detail {
+        template<typename T> inline constexpr bool always_false = false;
+
+        template<typename T> concept registered_block = requires { block_members<T>::value; };
+
+        constexpr std::size_t round_up(std::size_t value, std::size_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        template<typename T> struct glm_vec : std::false_type {};
+        template<glm::length_t N, typename T, glm::qualifier Q> struct glm_vec<glm::vec<N, T, Q>> : std::true_type {
+            static constexpr std::size_t length = N;
+            using value_type = T;
+        };
+
+        template<typename T> struct glm_mat : std::false_type {};
+        template<glm::length_t C, glm::length_t R, typename T, glm::qualifier Q> struct glm_mat<glm::mat<C, R, T, Q>> : std::true_type {
+            static constexpr std::size_t columns = C;
+            using column_type = glm::vec<R, T, Q>;
+        };
+
+        template<typename T> struct fixed_array : std::false_type {};
+        template<typename T, std::size_t N> struct fixed_array<std::array<T, N>> : std::true_type {
+            static constexpr std::size_t length = N;
+            using value_type = T;
+        };
+        template<typename T, std::size_t N> struct fixed_array<T[N]> : std::true_type {
+            static constexpr std::size_t length = N;
+            using value_type = T;
+        };
+
+        template<typename T> struct padded : std::false_type {};
+        template<typename T> struct padded<Std140Padded<T>> : std::true_type {
+            using value_type = T;
+        };
+    } // detail
+
+    template<typename Layout, typename T> constexpr MemberLayout member_layout();
+
+    template<typename Layout> constexpr MemberLayout layout_of(const BlockMember &member) {
+        if constexpr (std::is_same_v<Layout, Std140>) return member.std140;
+        else return member.std430;
+    }
+
+    // Alignment and size the whole struct takes up when it is nested in a block, or used as an array element.
+    template<typename Layout, typename T> constexpr MemberLayout struct_layout() {
+        std::size_t alignment = 4, end = 0;
+        for (const auto &member : block_members<T>::value) {
+            MemberLayout l = layout_of<Layout>(member);
+            alignment = std::max(alignment, l.alignment);
+            end = detail::round_up(end, l.alignment) + l.size;
+        }
+        if constexpr (std::is_same_v<Layout, Std140>) alignment = detail::round_up(alignment, 16);
+        return {alignment, detail::round_up(end, alignment)};
+    }
+
+    template<typename Layout, typename T> constexpr MemberLayout member_layout() {
+        constexpr bool std140 = std::is_same_v<Layout, Std140>;
+
+        if constexpr (std::is_same_v<T, float> || std::is_same_v<T, std::int32_t> || std::is_same_v<T, std::uint32_t>) {
+            return {4, 4};
+        } else if constexpr (std::is_same_v<T, double>) {
+            return {8, 8};
+        } else if constexpr (detail::glm_vec<T>::value) {
+            constexpr std::size_t n = detail::glm_vec<T>::length;
+            constexpr std::size_t component = member_layout<Layout, typename detail::glm_vec<T>::value_type>().size;
+            return {(n == 3 ? 4 : n) * component, n * component};
+        } else if constexpr (detail::glm_mat<T>::value) {
+            // A matrix is laid out like an array of its column vectors.
+            constexpr MemberLayout column = member_layout<Layout, typename detail::glm_mat<T>::column_type>();
+            constexpr std::size_t stride = std140 ? detail::round_up(column.alignment, 16) : column.alignment;
+            return {stride, stride * detail::glm_mat<T>::columns};
+        } else if constexpr (detail::fixed_array<T>::value) {
+            constexpr MemberLayout element = member_layout<Layout, typename detail::fixed_array<T>::value_type>();
+            constexpr std::size_t alignment = std140 ? detail::round_up(element.alignment, 16) : element.alignment;
+            constexpr std::size_t stride = detail::round_up(element.size, alignment);
+            return {alignment, stride * detail::fixed_array<T>::length};
+        } else if constexpr (detail::padded<T>::value) {
+            return member_layout<Layout, typename detail::padded<T>::value_type>();
+        } else if constexpr (detail::registered_block<T>) {
+            return struct_layout<Layout, T>();
+        } else {
+            static_assert(detail::always_false<T>, "Type has no GLSL block equivalent (bool and 8/16-bit types are not allowed; nested structs need GC_BLOCK_LAYOUT)");
+            return {};
+        }
+    }
+
+    template<typename T> constexpr BlockMember describe_member(std::size_t offset) {
+        return {offset, sizeof(T), member_layout<Std140, T>(), member_layout<Std430, T>()};
+    }
+
+    inline constexpr std::size_t no_mismatch = static_cast<std::size_t>(-1);
+
+    // Index of the first member whose C++ offset or size differs from what the layout rules would place there, or no_mismatch.
+    // One past the last member means they all match but sizeof(T) doesn't cover the struct's padded size, so arrays of T would
+    // have the wrong stride; add trailing padding members. Arrays of scalars need Std140Padded under std140, and a GLSL mat3 maps
+    // to glm::mat3x4 since its columns are padded to vec4.
+    template<typename Layout, typename T> constexpr std::size_t block_layout_mismatch() {
+        std::size_t offset = 0, i = 0;
+        for (const auto &member : block_members<T>::value) {
+            MemberLayout l = layout_of<Layout>(member);
+            offset = detail::round_up(offset, l.alignment);
+            if (member.offset != offset || member.cpp_size != l.size) return i;
+            offset += l.size;
+            i++;
+        }
+        if (sizeof(T) != struct_layout<Layout, T>().size) return i;
+        return no_mismatch;
+    }
+
+    template<typename Layout, typename T> inline constexpr bool block_layout_matches = block_layout_mismatch<Layout, T>() == no_mismatch;
+
+} // gc
+
+#define GC_DETAIL_PARENS ()
+#define GC_DETAIL_EXPAND(...) GC_DETAIL_EXPAND3(GC_DETAIL_EXPAND3(GC_DETAIL_EXPAND3(GC_DETAIL_EXPAND3(__VA_ARGS__))))
+#define GC_DETAIL_EXPAND3(...) GC_DETAIL_EXPAND2(GC_DETAIL_EXPAND2(GC_DETAIL_EXPAND2(GC_DETAIL_EXPAND2(__VA_ARGS__))))
+#define GC_DETAIL_EXPAND2(...) GC_DETAIL_EXPAND1(GC_DETAIL_EXPAND1(GC_DETAIL_EXPAND1(GC_DETAIL_EXPAND1(__VA_ARGS__))))
+#define GC_DETAIL_EXPAND1(...) __VA_ARGS__
+#define GC_DETAIL_FOR_EACH(macro, type, ...) __VA_OPT__(GC_DETAIL_EXPAND(GC_DETAIL_FOR_EACH_HELPER(macro, type, __VA_ARGS__)))
+#define GC_DETAIL_FOR_EACH_HELPER(macro, type, member, ...) \
+    macro(type, member) __VA_OPT__(GC_DETAIL_FOR_EACH_AGAIN GC_DETAIL_PARENS(macro, type, __VA_ARGS__))
+#define GC_DETAIL_FOR_EACH_AGAIN() GC_DETAIL_FOR_EACH_HELPER
+#define GC_DETAIL_BLOCK_MEMBER(type, member) gc::describe_member<decltype(type::member)>(offsetof(type, member)),
+
+// Describes the members of a struct, in declaration order, so UniformBlock/StorageBlock can check it against std140/std430 at compile
+// time. Use at global scope:
+//
+//     struct Material { glm::vec4 color; float roughness; float metallic; glm::vec2 padding; };
+//     GC_BLOCK_LAYOUT(Material, color, roughness, metallic, padding)
+#define GC_BLOCK_LAYOUT(type, ...)                                                                                                      \
+    template<> struct gc::block_members<type> {                                                                                         \
+        static_assert(std::is_standard_layout_v<type> && std::is_trivially_copyable_v<type>, #type " must be a plain struct");      \
+        static constexpr gc::BlockMember value[] = {GC_DETAIL_FOR_EACH(GC_DETAIL_BLOCK_MEMBER, type, __VA_ARGS__)};                  \
+    };
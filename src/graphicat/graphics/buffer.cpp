@@ -1,4 +1,6 @@
 #include "buffer.hpp"
+#include "barrier_tracker.hpp"
+#include "state_cache.hpp"
 
 namespace gc {
 
@@ -7,8 +9,11 @@ namespace gc {
     }
 
     Buffer::~Buffer() {
-        if (owned)
+        if (owned) {
+            if (BarrierTracker *tracker = BarrierTracker::get()) tracker->forget(handle);
+            if (StateCache *cache = StateCache::get()) cache->forget_buffer(handle);
             glDeleteBuffers(1, &handle);
+        }
     }
 
     static unsigned int raw_buffer_create() {
@@ -29,6 +34,14 @@ namespace gc {
         return raw_load_buffer(size, nullptr, usage);
     }
 
+    static unsigned int raw_storage_buffer(size_t size, GLbitfield flags, const void* data) {
+        unsigned int b = raw_buffer_create();
+
+        glNamedBufferStorage(b, static_cast<GLsizeiptr>(size), data, flags);
+
+        return b;
+    }
+
 
 
     std::unique_ptr<Buffer> Buffer::wrap(unsigned int handle, bool take_ownership) {
@@ -47,6 +60,10 @@ namespace gc {
         return wrap(raw_load_buffer(size, data, usage), true);
     }
 
+    std::unique_ptr<Buffer> Buffer::storage(size_t size, GLbitfield flags, const void *data) {
+        return wrap(raw_storage_buffer(size, flags, data), true);
+    }
+
     std::shared_ptr<Buffer> Buffer::wrap_shared(unsigned int handle, bool take_ownership) {
         return std::shared_ptr<Buffer>(new Buffer(handle, take_ownership));
     }
@@ -63,8 +80,42 @@ namespace gc {
         return wrap_shared(raw_load_buffer(size, data, usage), true);
     }
 
+    std::shared_ptr<Buffer> Buffer::storage_shared(size_t size, GLbitfield flags, const void *data) {
+        return wrap_shared(raw_storage_buffer(size, flags, data), true);
+    }
+
     void Buffer::bind(BufferTarget target) const {
-        glBindBuffer(static_cast<GLenum>(target), handle);
+        bind_buffer(static_cast<GLenum>(target), handle);
+    }
+
+    void Buffer::bind_base(BufferTarget target, unsigned int index) const {
+        if (BarrierTracker *tracker = BarrierTracker::get()) tracker->set_binding(target, index, handle);
+        bind_buffer_base(static_cast<GLenum>(target), index, handle);
+    }
+
+    void Buffer::bind_range(BufferTarget target, unsigned int index, size_t offset, size_t size) const {
+        if (BarrierTracker *tracker = BarrierTracker::get()) tracker->set_binding(target, index, handle);
+        bind_buffer_range(static_cast<GLenum>(target), index, handle, offset, size);
+    }
+
+    void Buffer::update(size_t offset, size_t size, const void *data) const {
+        if (BarrierTracker *tracker = BarrierTracker::get()) {
+            tracker->read(handle, BufferAccess::Update);
+            tracker->flush();
+        }
+        glNamedBufferSubData(handle, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+    }
+
+    void *Buffer::map_range(size_t offset, size_t size, GLbitfield access) const {
+        if (BarrierTracker *tracker = BarrierTracker::get()) {
+            tracker->read(handle, BufferAccess::ClientMapped);
+            tracker->flush();
+        }
+        return glMapNamedBufferRange(handle, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), access);
+    }
+
+    void Buffer::unmap() const {
+        glUnmapNamedBuffer(handle);
     }
 
     unsigned int Buffer::get_handle() const noexcept {
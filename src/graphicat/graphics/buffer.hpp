@@ -24,6 +24,8 @@ namespace gc {
     enum class BufferTarget : GLenum {
         Array = GL_ARRAY_BUFFER,
         ElementArray = GL_ELEMENT_ARRAY_BUFFER,
+        Uniform = GL_UNIFORM_BUFFER,
+        ShaderStorage = GL_SHADER_STORAGE_BUFFER,
     };
 
     class Buffer {
@@ -56,7 +58,19 @@ namespace gc {
             return load_shared(data.size() * sizeof(T), data.data(), usage);
         };
 
+        // Immutable storage. Flags are glBufferStorage bits, e.g. GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT for a
+        // buffer that stays mapped.
+        static std::unique_ptr<Buffer> storage(size_t size, GLbitfield flags, const void* data = nullptr);
+        static std::shared_ptr<Buffer> storage_shared(size_t size, GLbitfield flags, const void* data = nullptr);
+
         void bind(BufferTarget target) const;
+        void bind_base(BufferTarget target, unsigned int index) const;
+        void bind_range(BufferTarget target, unsigned int index, size_t offset, size_t size) const;
+
+        void update(size_t offset, size_t size, const void* data) const;
+
+        [[nodiscard]] void* map_range(size_t offset, size_t size, GLbitfield access) const;
+        void unmap() const;
 
         [[nodiscard]] unsigned int get_handle() const noexcept;
     };
@@ -0,0 +1,419 @@
+#include "command_list.hpp"
+#include "shader.hpp"
+#include "vertex_array.hpp"
+#include "draw_batcher.hpp"
+#include "draw_indirect.hpp"
+#include "render_state.hpp"
+#include "state_cache.hpp"
+#include <algorithm>
+
+namespace gc {
+
+    std::uint64_t SortKey::quantize_depth(float depth) {
+        return static_cast<std::uint64_t>(std::clamp(depth, 0.0f, 1.0f) * static_cast<float>((1u << depth_bits) - 1));
+    }
+
+    static std::uint64_t field(std::uint64_t value, unsigned int bits) {
+        return value & ((std::uint64_t(1) << bits) - 1);
+    }
+
+    std::uint64_t SortKey::opaque(unsigned int pass, const RenderState &state, const Shader &shader, const VertexArray &vertex_array,
+                                  unsigned int material, float depth) {
+        std::uint64_t key = field(pass, pass_bits);
+        key = key << render_state_bits | field(state.get_id(), render_state_bits);
+        key = key << program_bits | field(shader.get_handle(), program_bits);
+        key = key << vertex_array_bits | field(vertex_array.get_handle(), vertex_array_bits);
+        key = key << material_bits | field(material, material_bits);
+        key = key << depth_bits | quantize_depth(depth);
+        return key;
+    }
+
+    std::uint64_t SortKey::blended(unsigned int pass, float depth, const RenderState &state, const Shader &shader,
+                                   const VertexArray &vertex_array, unsigned int material) {
+        // Far first, so invert the depth.
+        std::uint64_t key = field(pass, pass_bits);
+        key = key << depth_bits | (field(~quantize_depth(depth), depth_bits));
+        key = key << render_state_bits | field(state.get_id(), render_state_bits);
+        key = key << program_bits | field(shader.get_handle(), program_bits);
+        key = key << vertex_array_bits | field(vertex_array.get_handle(), vertex_array_bits);
+        key = key << material_bits | field(material, material_bits);
+        return key;
+    }
+
+    CommandList::CommandList(std::size_t block_size) : allocator(block_size) {
+    }
+
+    void CommandList::begin(std::uint64_t key) {
+        if (!items.empty() && key < items.back().key) sorted = false;
+        items.push_back({key, static_cast<std::uint32_t>(items.size()), nullptr});
+        tail = nullptr;
+    }
+
+    void CommandList::set_render_state(const RenderState &state) {
+        push<packets::RenderState>(PacketType::RenderState)->state = &state;
+    }
+
+    void CommandList::bind_program(const Shader &shader) {
+        push<packets::Program>(PacketType::Program)->shader = &shader;
+    }
+
+    void CommandList::bind_vertex_array(const VertexArray &vertex_array) {
+        push<packets::VertexArray>(PacketType::VertexArray)->vertex_array = &vertex_array;
+    }
+
+    void CommandList::bind_buffer_base(BufferTarget target, unsigned int index, const Buffer &buffer) {
+        auto *packet = push<packets::BufferBinding>(PacketType::BufferBase);
+        packet->buffer = &buffer;
+        packet->target = target;
+        packet->index = index;
+        packet->offset = 0;
+        packet->size = 0;
+    }
+
+    void CommandList::bind_buffer_range(BufferTarget target, unsigned int index, const Buffer &buffer, std::size_t offset, std::size_t size) {
+        auto *packet = push<packets::BufferBinding>(PacketType::BufferRange);
+        packet->buffer = &buffer;
+        packet->target = target;
+        packet->index = index;
+        packet->offset = offset;
+        packet->size = size;
+    }
+
+    void CommandList::bind_texture(unsigned int unit, unsigned int texture) {
+        auto *packet = push<packets::Texture>(PacketType::Texture);
+        packet->unit = unit;
+        packet->texture = texture;
+    }
+
+    void CommandList::draw_arrays(GLenum mode, std::int32_t first, std::int32_t count, std::int32_t instances, std::uint32_t base_instance) {
+        auto *packet = push<packets::DrawArrays>(PacketType::DrawArrays);
+        packet->mode = mode;
+        packet->first = first;
+        packet->count = count;
+        packet->instances = instances;
+        packet->base_instance = base_instance;
+    }
+
+    void CommandList::draw_elements(GLenum mode, std::int32_t count, GLenum index_type, std::size_t offset, std::int32_t instances,
+                                    std::int32_t base_vertex, std::uint32_t base_instance) {
+        auto *packet = push<packets::DrawElements>(PacketType::DrawElements);
+        packet->mode = mode;
+        packet->index_type = index_type;
+        packet->count = count;
+        packet->offset = offset;
+        packet->instances = instances;
+        packet->base_vertex = base_vertex;
+        packet->base_instance = base_instance;
+    }
+
+    void CommandList::draw_arrays_indirect(const Buffer &commands, std::size_t offset, std::uint32_t draw_count, GLenum mode) {
+        auto *packet = push<packets::DrawIndirect>(PacketType::DrawArraysIndirect);
+        packet->commands = &commands;
+        packet->mode = mode;
+        packet->index_type = 0;
+        packet->offset = offset;
+        packet->draw_count = draw_count;
+    }
+
+    void CommandList::draw_elements_indirect(const Buffer &commands, std::size_t offset, std::uint32_t draw_count, GLenum mode,
+                                             GLenum index_type) {
+        auto *packet = push<packets::DrawIndirect>(PacketType::DrawElementsIndirect);
+        packet->commands = &commands;
+        packet->mode = mode;
+        packet->index_type = index_type;
+        packet->offset = offset;
+        packet->draw_count = draw_count;
+    }
+
+    void CommandList::finish() {
+        if (sorted) return;
+
+        // Sequence numbers go up with recording order, so sorting on both keeps equal keys stable without stable_sort's buffer.
+        std::sort(items.begin(), items.end(), [](const CommandItem &a, const CommandItem &b) {
+            return a.key != b.key ? a.key < b.key : a.sequence < b.sequence;
+        });
+        sorted = true;
+    }
+
+    void CommandList::reset() {
+        items.clear();
+        allocator.reset();
+        tail = nullptr;
+        sorted = true;
+    }
+
+    CommandListStats CommandList::execute(std::initializer_list<CommandList *> lists, DrawBatcher *batcher) {
+        return execute(std::vector<CommandList *>(lists), batcher);
+    }
+
+    CommandListStats CommandList::execute(const std::vector<CommandList *> &lists, DrawBatcher *batcher) {
+        std::size_t total = 0;
+        for (auto *list : lists) {
+            list->finish();
+            total += list->items.size();
+        }
+
+        // k-way merge. There is one list per recording thread, so a linear scan over the heads beats a heap.
+        std::vector<const CommandItem *> merged;
+        merged.reserve(total);
+        std::vector<std::size_t> heads(lists.size(), 0);
+        while (merged.size() < total) {
+            std::size_t best = lists.size();
+            for (std::size_t i = 0; i < lists.size(); i++) {
+                if (heads[i] == lists[i]->items.size()) continue;
+                if (best == lists.size() || lists[i]->items[heads[i]].key < lists[best]->items[heads[best]].key) best = i;
+            }
+            merged.push_back(&lists[best]->items[heads[best]++]);
+        }
+
+        CommandListStats stats;
+        execute_items(merged.data(), merged.size(), batcher, stats);
+        return stats;
+    }
+
+    namespace {
+        struct PlaybackState {
+            const RenderState *render_state = nullptr;
+            const Shader *program = nullptr;
+            const VertexArray *vertex_array = nullptr;
+
+            bool operator==(const PlaybackState &) const = default;
+        };
+    }
+
+    static void execute_packet(const Packet *packet, PlaybackState &state, CommandListStats &stats) {
+        stats.packets++;
+
+        switch (packet->type) {
+        case PacketType::RenderState: {
+            auto *p = static_cast<const packets::RenderState *>(packet);
+            if (p->state == state.render_state) {
+                stats.redundant_binds++;
+                break;
+            }
+            p->state->bind();
+            state.render_state = p->state;
+            stats.render_state_binds++;
+            break;
+        }
+        case PacketType::Program: {
+            auto *p = static_cast<const packets::Program *>(packet);
+            if (p->shader == state.program) {
+                stats.redundant_binds++;
+                break;
+            }
+            p->shader->bind();
+            state.program = p->shader;
+            stats.program_binds++;
+            break;
+        }
+        case PacketType::VertexArray: {
+            auto *p = static_cast<const packets::VertexArray *>(packet);
+            if (p->vertex_array == state.vertex_array) {
+                stats.redundant_binds++;
+                break;
+            }
+            p->vertex_array->bind();
+            state.vertex_array = p->vertex_array;
+            stats.vertex_array_binds++;
+            break;
+        }
+        case PacketType::BufferBase:
+        case PacketType::BufferRange: {
+            auto *p = static_cast<const packets::BufferBinding *>(packet);
+            if (packet->type == PacketType::BufferBase)
+                p->buffer->bind_base(p->target, p->index);
+            else
+                p->buffer->bind_range(p->target, p->index, p->offset, p->size);
+
+            // Binding the program again is what makes it wait on writes to the new buffer, so don't skip the next one.
+            state.program = nullptr;
+            break;
+        }
+        case PacketType::Texture: {
+            auto *p = static_cast<const packets::Texture *>(packet);
+            bind_texture_unit(p->unit, p->texture);
+            break;
+        }
+        case PacketType::Uniform: {
+            auto *p = static_cast<const packets::Uniform *>(packet);
+            p->apply(*p->shader, p->location, p->value);
+            break;
+        }
+        case PacketType::DrawArrays: {
+            auto *p = static_cast<const packets::DrawArrays *>(packet);
+            glDrawArraysInstancedBaseInstance(p->mode, p->first, p->count, p->instances, p->base_instance);
+            stats.draws++;
+            stats.draw_calls++;
+            break;
+        }
+        case PacketType::DrawElements: {
+            auto *p = static_cast<const packets::DrawElements *>(packet);
+            glDrawElementsInstancedBaseVertexBaseInstance(p->mode, p->count, p->index_type, reinterpret_cast<const void *>(p->offset),
+                                                          p->instances, p->base_vertex, p->base_instance);
+            stats.draws++;
+            stats.draw_calls++;
+            break;
+        }
+        case PacketType::DrawArraysIndirect: {
+            auto *p = static_cast<const packets::DrawIndirect *>(packet);
+            multi_draw_arrays_indirect(*p->commands, p->offset, p->draw_count, p->mode);
+            stats.draws++;
+            stats.draw_calls++;
+            break;
+        }
+        case PacketType::DrawElementsIndirect: {
+            auto *p = static_cast<const packets::DrawIndirect *>(packet);
+            multi_draw_elements_indirect(*p->commands, p->offset, p->draw_count, p->mode, p->index_type);
+            stats.draws++;
+            stats.draw_calls++;
+            break;
+        }
+        }
+    }
+
+    static std::size_t index_size(GLenum type) {
+        switch (type) {
+        case GL_UNSIGNED_BYTE: return 1;
+        case GL_UNSIGNED_SHORT: return 2;
+        default: return 4;
+        }
+    }
+
+    // The draw of an item that only sets a render state, program and/or vertex array and then draws, with `state` updated to what the binds
+    // leave bound. nullptr for anything else, since other state would have to change between the draws of a fused run.
+    static const Packet *fusible_draw(const CommandItem &item, PlaybackState &state) {
+        const Packet *draw = nullptr;
+        for (const Packet *packet = item.head; packet; packet = packet->next) {
+            if (draw) return nullptr;
+
+            switch (packet->type) {
+            case PacketType::RenderState:
+                state.render_state = static_cast<const packets::RenderState *>(packet)->state;
+                break;
+            case PacketType::Program:
+                state.program = static_cast<const packets::Program *>(packet)->shader;
+                break;
+            case PacketType::VertexArray:
+                state.vertex_array = static_cast<const packets::VertexArray *>(packet)->vertex_array;
+                break;
+            case PacketType::DrawArrays:
+                draw = packet;
+                break;
+            case PacketType::DrawElements: {
+                // The command addresses indices by element, not byte.
+                auto *p = static_cast<const packets::DrawElements *>(packet);
+                if (p->offset % index_size(p->index_type) != 0) return nullptr;
+                draw = packet;
+                break;
+            }
+            default:
+                return nullptr;
+            }
+        }
+        return draw;
+    }
+
+    static bool same_draw_kind(const Packet *a, const Packet *b) {
+        if (a->type != b->type) return false;
+
+        if (a->type == PacketType::DrawArrays)
+            return static_cast<const packets::DrawArrays *>(a)->mode == static_cast<const packets::DrawArrays *>(b)->mode;
+
+        auto *ea = static_cast<const packets::DrawElements *>(a);
+        auto *eb = static_cast<const packets::DrawElements *>(b);
+        return ea->mode == eb->mode && ea->index_type == eb->index_type;
+    }
+
+    static void write_command(const Packet *draw, std::byte *out) {
+        if (draw->type == PacketType::DrawArrays) {
+            auto *p = static_cast<const packets::DrawArrays *>(draw);
+            DrawArraysIndirectCommand command{static_cast<std::uint32_t>(p->count), static_cast<std::uint32_t>(p->instances),
+                                              static_cast<std::uint32_t>(p->first), p->base_instance};
+            std::memcpy(out, &command, sizeof(command));
+        } else {
+            auto *p = static_cast<const packets::DrawElements *>(draw);
+            DrawElementsIndirectCommand command{static_cast<std::uint32_t>(p->count), static_cast<std::uint32_t>(p->instances),
+                                                static_cast<std::uint32_t>(p->offset / index_size(p->index_type)), p->base_vertex,
+                                                p->base_instance};
+            std::memcpy(out, &command, sizeof(command));
+        }
+    }
+
+    void CommandList::execute_items(const CommandItem *const *items, std::size_t count, DrawBatcher *batcher, CommandListStats &stats) {
+        PlaybackState state;
+
+        for (std::size_t i = 0; i < count;) {
+            if (batcher) {
+                PlaybackState run_state = state;
+                const Packet *first = fusible_draw(*items[i], run_state);
+
+                std::size_t end = i + 1;
+                if (first) {
+                    for (; end < count; end++) {
+                        PlaybackState next_state = run_state;
+                        const Packet *draw = fusible_draw(*items[end], next_state);
+                        if (!draw || next_state != run_state || !same_draw_kind(first, draw)) break;
+                    }
+                }
+
+                std::size_t run = end - i;
+                bool elements = first && first->type == PacketType::DrawElements;
+                std::size_t stride = elements ? sizeof(DrawElementsIndirectCommand) : sizeof(DrawArraysIndirectCommand);
+
+                StreamAllocation commands{nullptr, 0, 0};
+                if (first && run >= batcher->get_min_run()) commands = batcher->allocate(static_cast<std::uint32_t>(run), stride);
+
+                if (commands.data) {
+                    // The draw is always an item's last packet. Only the first item's binds can change anything; the rest bind the
+                    // same render state, program and vertex array again.
+                    for (std::size_t k = 0; k < run; k++) {
+                        for (const Packet *packet = items[i + k]->head; packet; packet = packet->next) {
+                            if (!packet->next) {
+                                write_command(packet, commands.data + k * stride);
+                                stats.packets++;
+                            } else if (k == 0) {
+                                execute_packet(packet, state, stats);
+                            } else {
+                                stats.packets++;
+                                stats.redundant_binds++;
+                            }
+                        }
+                    }
+
+                    if (elements) {
+                        auto *p = static_cast<const packets::DrawElements *>(first);
+                        multi_draw_elements_indirect(batcher->get_buffer(), commands.offset, static_cast<std::uint32_t>(run), p->mode,
+                                                     p->index_type);
+                    } else {
+                        auto *p = static_cast<const packets::DrawArrays *>(first);
+                        multi_draw_arrays_indirect(batcher->get_buffer(), commands.offset, static_cast<std::uint32_t>(run), p->mode);
+                    }
+
+                    stats.items += run;
+                    stats.draws += run;
+                    stats.draw_calls++;
+                    stats.fused_runs++;
+                    stats.fused_draws += run;
+                    i = end;
+                    continue;
+                }
+            }
+
+            stats.items++;
+            for (const Packet *packet = items[i]->head; packet; packet = packet->next) {
+                execute_packet(packet, state, stats);
+            }
+            i++;
+        }
+    }
+
+    const std::vector<CommandItem> &CommandList::get_items() const noexcept {
+        return items;
+    }
+
+    std::size_t CommandList::get_memory_used() const noexcept {
+        return allocator.get_used();
+    }
+
+} // gc
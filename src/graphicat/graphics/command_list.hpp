@@ -0,0 +1,233 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/buffer.hpp"
+#include "graphicat/graphics/uniform.hpp"
+#include "graphicat/util/linear_allocator.hpp"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace gc {
+
+    class DrawBatcher;
+    class RenderState;
+    class Shader;
+    class VertexArray;
+
+    // Packs what a draw needs into 64 bits so sorting the keys groups draws by state. From the top: pass (6 bits), then render
+    // state (8), program (12), vertex array (10), material (12) and depth (16) for opaque draws, or depth right after the pass for
+    // blended ones so they come out back to front. Render state ids, handles and material ids are truncated to their field; a
+    // collision only costs a rebind.
+    struct SortKey {
+        static constexpr unsigned int pass_bits = 6;
+        static constexpr unsigned int render_state_bits = 8;
+        static constexpr unsigned int program_bits = 12;
+        static constexpr unsigned int vertex_array_bits = 10;
+        static constexpr unsigned int material_bits = 12;
+        static constexpr unsigned int depth_bits = 16;
+
+        // `depth` is view depth normalized to [0, 1]; front to back, so near opaque geometry occludes early.
+        static std::uint64_t opaque(unsigned int pass, const RenderState &state, const Shader &shader, const VertexArray &vertex_array,
+                                    unsigned int material, float depth);
+        static std::uint64_t blended(unsigned int pass, float depth, const RenderState &state, const Shader &shader,
+                                     const VertexArray &vertex_array, unsigned int material);
+
+        static std::uint64_t quantize_depth(float depth);
+    };
+
+    enum class PacketType : std::uint8_t {
+        RenderState,
+        Program,
+        VertexArray,
+        BufferBase,
+        BufferRange,
+        Texture,
+        Uniform,
+        DrawArrays,
+        DrawElements,
+        DrawArraysIndirect,
+        DrawElementsIndirect,
+    };
+
+    struct Packet {
+        PacketType type;
+        const Packet *next = nullptr;
+    };
+
+    namespace packets {
+        struct RenderState : Packet {
+            const gc::RenderState *state;
+        };
+
+        struct Program : Packet {
+            const Shader *shader;
+        };
+
+        struct VertexArray : Packet {
+            const gc::VertexArray *vertex_array;
+        };
+
+        struct BufferBinding : Packet {
+            const Buffer *buffer;
+            BufferTarget target;
+            unsigned int index;
+            std::size_t offset;
+            std::size_t size;
+        };
+
+        struct Texture : Packet {
+            unsigned int unit;
+            unsigned int texture;
+        };
+
+        // The value is stored right after the packet.
+        struct Uniform : Packet {
+            const Shader *shader;
+            int location;
+            void (*apply)(const Shader &shader, int location, const void *value);
+            const void *value;
+        };
+
+        struct DrawArrays : Packet {
+            GLenum mode;
+            std::int32_t first;
+            std::int32_t count;
+            std::int32_t instances;
+            std::uint32_t base_instance;
+        };
+
+        struct DrawElements : Packet {
+            GLenum mode;
+            GLenum index_type;
+            std::int32_t count;
+            std::size_t offset;
+            std::int32_t instances;
+            std::int32_t base_vertex;
+            std::uint32_t base_instance;
+        };
+
+        struct DrawIndirect : Packet {
+            const Buffer *commands;
+            GLenum mode;
+            GLenum index_type;
+            std::size_t offset;
+            std::uint32_t draw_count;
+        };
+    } // packets
+
+    struct CommandItem {
+        std::uint64_t key;
+        // Recording order, so items with equal keys play back in the order they were recorded.
+        std::uint32_t sequence;
+        const Packet *head;
+    };
+
+    struct CommandListStats {
+        std::uint64_t items = 0;
+        std::uint64_t packets = 0;
+        // Draws as recorded, and the draw calls that reached GL once runs were fused. An indirect draw counts as one of each.
+        std::uint64_t draws = 0;
+        std::uint64_t draw_calls = 0;
+        // Multi-draws made out of runs of compatible draws, and how many draws went into them.
+        std::uint64_t fused_runs = 0;
+        std::uint64_t fused_draws = 0;
+        std::uint64_t program_binds = 0;
+        std::uint64_t vertex_array_binds = 0;
+        std::uint64_t render_state_binds = 0;
+        // Render state, program and vertex array binds dropped because the previous item had already bound the same one.
+        std::uint64_t redundant_binds = 0;
+    };
+
+    // Draws and the state they need, recorded off the GL thread and played back on it. Each recording thread owns its own list,
+    // so recording takes no locks; packets go into the list's LinearAllocator, which keeps its memory between frames.
+    //
+    //     // on a worker
+    //     list.begin(gc::SortKey::opaque(0, *state, *shader, *vao, material_id, depth));
+    //     list.set_render_state(*state);
+    //     list.bind_program(*shader);
+    //     list.bind_vertex_array(*vao);
+    //     list.uniform(*shader, 0, model_matrix);
+    //     list.draw_elements(GL_TRIANGLES, index_count, GL_UNSIGNED_INT);
+    //     list.finish();
+    //
+    //     // on the GL thread, once every worker is done
+    //     gc::CommandList::execute({&list_a, &list_b});
+    //
+    // Everything a list points to (render states, shaders, vertex arrays, buffers) has to stay alive until it has been executed.
+    class CommandList {
+        LinearAllocator allocator;
+        std::vector<CommandItem> items;
+        Packet *tail = nullptr;
+        bool sorted = true;
+
+        template<typename T> T *push(PacketType type) {
+            if (items.empty()) begin(0);
+
+            T *packet = allocator.create<T>();
+            packet->type = type;
+
+            if (tail)
+                tail->next = packet;
+            else if (!items.empty() && !items.back().head)
+                items.back().head = packet;
+            tail = packet;
+            return packet;
+        }
+
+        static void execute_items(const CommandItem *const *items, std::size_t count, DrawBatcher *batcher, CommandListStats &stats);
+
+    public:
+        explicit CommandList(std::size_t block_size = 64 * 1024);
+
+        // Starts a draw item. Every packet up to the next begin() belongs to it and is played back together, in order.
+        void begin(std::uint64_t key);
+
+        void set_render_state(const RenderState &state);
+        void bind_program(const Shader &shader);
+        void bind_vertex_array(const VertexArray &vertex_array);
+        void bind_buffer_base(BufferTarget target, unsigned int index, const Buffer &buffer);
+        void bind_buffer_range(BufferTarget target, unsigned int index, const Buffer &buffer, std::size_t offset, std::size_t size);
+        void bind_texture(unsigned int unit, unsigned int texture);
+
+        // Copied into the list, so `value` can go away after recording. Goes through the shader's location overloads at playback.
+        template<detail::uniform_value T> void uniform(const Shader &shader, int location, const T &value) {
+            auto *packet = push<packets::Uniform>(PacketType::Uniform);
+            void *copy = allocator.allocate(sizeof(T), alignof(T));
+            std::memcpy(copy, &value, sizeof(T));
+
+            packet->shader = &shader;
+            packet->location = location;
+            packet->apply = [](const Shader &s, int l, const void *v) {
+                T t;
+                std::memcpy(&t, v, sizeof(T));
+                detail::set_uniform(s, l, t);
+            };
+            packet->value = copy;
+        }
+
+        void draw_arrays(GLenum mode, std::int32_t first, std::int32_t count, std::int32_t instances = 1, std::uint32_t base_instance = 0);
+        void draw_elements(GLenum mode, std::int32_t count, GLenum index_type = GL_UNSIGNED_INT, std::size_t offset = 0,
+                           std::int32_t instances = 1, std::int32_t base_vertex = 0, std::uint32_t base_instance = 0);
+        void draw_arrays_indirect(const Buffer &commands, std::size_t offset, std::uint32_t draw_count, GLenum mode = GL_TRIANGLES);
+        void draw_elements_indirect(const Buffer &commands, std::size_t offset, std::uint32_t draw_count, GLenum mode = GL_TRIANGLES,
+                                    GLenum index_type = GL_UNSIGNED_INT);
+
+        // Sorts the items by key. Meant to be called by the recording thread when it is done, so the sort runs in parallel with the
+        // other workers; execute() sorts anything that wasn't.
+        void finish();
+
+        // Forgets every item and rewinds the allocator, keeping its memory. Call once the list has been executed.
+        void reset();
+
+        // Merges the lists by key and plays them back. Must be called on the GL thread, after every list is done recording. Lists
+        // are left as they are, so they can be executed again (e.g. for static geometry) until they are reset. With a batcher,
+        // runs of compatible draws are fused into multi-draws (see DrawBatcher).
+        static CommandListStats execute(const std::vector<CommandList *> &lists, DrawBatcher *batcher = nullptr);
+        static CommandListStats execute(std::initializer_list<CommandList *> lists, DrawBatcher *batcher = nullptr);
+
+        [[nodiscard]] const std::vector<CommandItem> &get_items() const noexcept;
+        [[nodiscard]] std::size_t get_memory_used() const noexcept;
+    };
+
+} // gc
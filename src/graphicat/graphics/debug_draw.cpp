@@ -0,0 +1,488 @@
+#include "debug_draw.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <spdlog/spdlog.h>
+
+namespace gc {
+
+    DebugLineRing::DebugLineRing(std::size_t capacity)
+        : lines(std::make_unique<DebugLine[]>(std::bit_ceil(std::max<std::size_t>(capacity, 1)))),
+          mask(std::bit_ceil(std::max<std::size_t>(capacity, 1)) - 1) {
+    }
+
+    namespace detail {
+        struct DebugRingPool {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<DebugLineRing>> rings;
+            // Rings whose thread has exited.
+            std::vector<DebugLineRing *> free;
+        };
+    } // detail
+
+    namespace {
+        struct ThreadRing {
+            std::uint64_t generation = 0;
+            DebugLineRing *ring = nullptr;
+            std::weak_ptr<detail::DebugRingPool> pool;
+
+            // Hands the ring back when the thread exits, unless its DebugDraw is already gone.
+            ~ThreadRing() {
+                release();
+            }
+
+            void release() {
+                if (auto owner = pool.lock()) {
+                    std::lock_guard lock(owner->mutex);
+                    owner->free.push_back(ring);
+                }
+                ring = nullptr;
+                pool.reset();
+            }
+        };
+
+        // Generations are never reused, so a DebugDraw created at a freed one's address can't pick up its dangling rings.
+        thread_local ThreadRing t_ring;
+    }
+
+    DebugDraw::DebugDraw(std::size_t ring_capacity)
+        : ring_capacity(ring_capacity), generation(s_next_generation.fetch_add(1, std::memory_order_relaxed)),
+          pool(std::make_shared<detail::DebugRingPool>()) {
+    }
+
+    DebugDraw::~DebugDraw() = default;
+
+    DebugDraw *DebugDraw::get() {
+        GlobalState *state = GlobalState::get();
+        return state ? state->get_debug_draw() : nullptr;
+    }
+
+    DebugLineRing &DebugDraw::get_thread_ring() {
+        if (t_ring.generation == generation) return *t_ring.ring;
+
+        // A ring from an earlier DebugDraw that is still alive goes back to it.
+        if (t_ring.ring) t_ring.release();
+
+        DebugLineRing *ring;
+        {
+            std::lock_guard lock(pool->mutex);
+            if (!pool->free.empty()) {
+                // Taking it under the lock orders this thread's writes after everything the previous owner wrote.
+                ring = pool->free.back();
+                pool->free.pop_back();
+            } else {
+                pool->rings.push_back(std::make_unique<DebugLineRing>(ring_capacity));
+                ring = pool->rings.back().get();
+            }
+        }
+
+        t_ring.generation = generation;
+        t_ring.ring = ring;
+        t_ring.pool = pool;
+        return *ring;
+    }
+
+    std::size_t DebugDraw::drain(std::vector<DebugLine> &out, std::size_t max) {
+        std::size_t lost = 0;
+
+        std::lock_guard lock(pool->mutex);
+        for (auto &ring : pool->rings) {
+            std::size_t end = ring->head.load(std::memory_order_acquire);
+            std::size_t begin = ring->tail.load(std::memory_order_relaxed);
+            for (std::size_t i = begin; i != end; i++) {
+                if (out.size() < max)
+                    out.push_back(ring->at(i));
+                else
+                    lost++;
+            }
+            ring->tail.store(end, std::memory_order_release);
+        }
+        return lost + dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    void DebugDraw::add_dropped(std::size_t count) noexcept {
+        dropped.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    namespace debug_draw {
+
+        // Reserves `count` lines in the calling thread's ring up front, so a shape is queued whole or not at all.
+        class Lines {
+            DebugLineRing *ring = nullptr;
+            std::size_t next = 0;
+            std::uint32_t color;
+            DebugDrawOptions options;
+
+        public:
+            Lines(std::size_t count, const glm::vec4 &color, DebugDrawOptions options)
+                : color(pack_rgba8(color)), options(options) {
+                DebugDraw *draw = DebugDraw::get();
+                if (!draw || count == 0) return;
+
+                DebugLineRing &thread_ring = draw->get_thread_ring();
+                next = thread_ring.reserve(count);
+                if (next == DebugLineRing::npos)
+                    draw->add_dropped(count);
+                else
+                    ring = &thread_ring;
+            }
+
+            ~Lines() {
+                if (ring) ring->commit(next);
+            }
+
+            Lines(const Lines &) = delete;
+            Lines &operator=(const Lines &) = delete;
+
+            explicit operator bool() const noexcept {
+                return ring != nullptr;
+            }
+
+            void set_color(const glm::vec4 &value) {
+                color = pack_rgba8(value);
+            }
+
+            void add(const glm::vec3 &a, const glm::vec3 &b, glm::vec2 offset_a = glm::vec2(0.0f), glm::vec2 offset_b = glm::vec2(0.0f)) {
+                ring->at(next++) = {a, b, offset_a, offset_b, color, std::max<std::uint16_t>(options.frames, 1), options.depth_test};
+            }
+        };
+
+        void line(const glm::vec3 &a, const glm::vec3 &b, const glm::vec4 &color, DebugDrawOptions options) {
+            Lines lines(1, color, options);
+            if (lines) lines.add(a, b);
+        }
+
+        static constexpr int box_edges[12][2] = {
+            {0, 1}, {1, 3}, {3, 2}, {2, 0}, // z = min
+            {4, 5}, {5, 7}, {7, 6}, {6, 4}, // z = max
+            {0, 4}, {1, 5}, {2, 6}, {3, 7},
+        };
+
+        // Corner i has bit 0 for x, bit 1 for y and bit 2 for z set at the max end.
+        static void add_box(Lines &lines, const std::array<glm::vec3, 8> &corners) {
+            for (const auto &edge : box_edges) lines.add(corners[edge[0]], corners[edge[1]]);
+        }
+
+        void box(const glm::vec3 &min, const glm::vec3 &max, const glm::vec4 &color, DebugDrawOptions options) {
+            Lines lines(12, color, options);
+            if (!lines) return;
+
+            std::array<glm::vec3, 8> corners;
+            for (int i = 0; i < 8; i++) corners[i] = {(i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z};
+            add_box(lines, corners);
+        }
+
+        void box(const glm::mat4 &transform, const glm::vec4 &color, DebugDrawOptions options) {
+            Lines lines(12, color, options);
+            if (!lines) return;
+
+            std::array<glm::vec3, 8> corners;
+            for (int i = 0; i < 8; i++) {
+                glm::vec4 corner = transform * glm::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 1.0f);
+                corners[i] = glm::vec3(corner) / corner.w;
+            }
+            add_box(lines, corners);
+        }
+
+        static constexpr int circle_segments = 24;
+
+        static const std::array<glm::vec2, circle_segments> &unit_circle() {
+            static const std::array<glm::vec2, circle_segments> points = [] {
+                std::array<glm::vec2, circle_segments> result;
+                for (int i = 0; i < circle_segments; i++) {
+                    float angle = 6.28318530718f * static_cast<float>(i) / circle_segments;
+                    result[i] = {std::cos(angle), std::sin(angle)};
+                }
+                return result;
+            }();
+            return points;
+        }
+
+        void sphere(const glm::vec3 &center, float radius, const glm::vec4 &color, DebugDrawOptions options) {
+            Lines lines(circle_segments * 3, color, options);
+            if (!lines) return;
+
+            const auto &circle = unit_circle();
+            for (int i = 0; i < circle_segments; i++) {
+                glm::vec2 p = circle[i] * radius;
+                glm::vec2 q = circle[(i + 1) % circle_segments] * radius;
+                lines.add(center + glm::vec3(p.x, p.y, 0.0f), center + glm::vec3(q.x, q.y, 0.0f));
+                lines.add(center + glm::vec3(p.x, 0.0f, p.y), center + glm::vec3(q.x, 0.0f, q.y));
+                lines.add(center + glm::vec3(0.0f, p.x, p.y), center + glm::vec3(0.0f, q.x, q.y));
+            }
+        }
+
+        void axes(const glm::mat4 &transform, float length, DebugDrawOptions options) {
+            Lines lines(3, glm::vec4(1.0f), options);
+            if (!lines) return;
+
+            glm::vec3 origin(transform[3]);
+            for (int axis = 0; axis < 3; axis++) {
+                glm::vec4 color(0.0f, 0.0f, 0.0f, 1.0f);
+                color[axis] = 1.0f;
+                lines.set_color(color);
+                lines.add(origin, origin + glm::normalize(glm::vec3(transform[axis])) * length);
+            }
+        }
+
+        // A 16-segment display on a 3x3 grid of points, x and y from 0 to 2 with y up.
+        enum Segment : std::uint16_t {
+            T1 = 1 << 0, T2 = 1 << 1,   // top
+            R1 = 1 << 2, R2 = 1 << 3,   // right, upper and lower
+            B1 = 1 << 4, B2 = 1 << 5,   // bottom
+            L1 = 1 << 6, L2 = 1 << 7,   // left, upper and lower
+            M1 = 1 << 8, M2 = 1 << 9,   // middle
+            V1 = 1 << 10, V2 = 1 << 11, // center vertical, upper and lower
+            D1 = 1 << 12, D2 = 1 << 13, // diagonals into the center from the top left and top right
+            D3 = 1 << 14, D4 = 1 << 15, // and from the bottom left and bottom right
+
+            T = T1 | T2, R = R1 | R2, B = B1 | B2, L = L1 | L2, M = M1 | M2, V = V1 | V2,
+        };
+
+        static constexpr std::uint8_t segment_points[16][4] = {
+            {0, 2, 1, 2}, {1, 2, 2, 2}, {2, 2, 2, 1}, {2, 1, 2, 0},
+            {0, 0, 1, 0}, {1, 0, 2, 0}, {0, 2, 0, 1}, {0, 1, 0, 0},
+            {0, 1, 1, 1}, {1, 1, 2, 1}, {1, 2, 1, 1}, {1, 1, 1, 0},
+            {0, 2, 1, 1}, {2, 2, 1, 1}, {0, 0, 1, 1}, {2, 0, 1, 1},
+        };
+
+        static std::uint16_t glyph(char c) {
+            if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+            switch (c) {
+                case '0': return T | B | L | R | D2 | D3;
+                case '1': return R;
+                case '2': return T | R1 | M | L2 | B;
+                case '3': return T | R | M2 | B;
+                case '4': return L1 | M | R;
+                case '5': case 'S': return T | L1 | M | R2 | B;
+                case '6': return T | L | M | R2 | B;
+                case '7': return T | R;
+                case '8': return T | B | L | R | M;
+                case '9': return T | L1 | M | R | B;
+                case 'A': return T | L | R | M;
+                case 'B': return T | B | R | M2 | V;
+                case 'C': case '[': return T | L | B;
+                case 'D': return T | B | R | V;
+                case 'E': return T | L | B | M1;
+                case 'F': return T | L | M1;
+                case 'G': return T | L | B | R2 | M2;
+                case 'H': return L | R | M;
+                case 'I': return T | B | V;
+                case 'J': return R | B | L2;
+                case 'K': return L | M1 | D2 | D4;
+                case 'L': return L | B;
+                case 'M': return L | R | D1 | D2;
+                case 'N': return L | R | D1 | D4;
+                case 'O': return T | B | L | R;
+                case 'P': return T | L | R1 | M;
+                case 'Q': return T | B | L | R | D4;
+                case 'R': return T | L | R1 | M | D4;
+                case 'T': return T | V;
+                case 'U': return L | R | B;
+                case 'V': return L | D3 | D2;
+                case 'W': return L | R | D3 | D4;
+                case 'X': return D1 | D2 | D3 | D4;
+                case 'Y': return D1 | D2 | V2;
+                case 'Z': return T | D2 | D3 | B;
+                case ']': return T | R | B;
+                case '-': return M;
+                case '+': return M | V;
+                case '=': return M | B;
+                case '_': return B;
+                case '.': return B1;
+                case ',': return D3;
+                case ':': case '|': return V;
+                case '/': return D2 | D3;
+                case '\\': return D1 | D4;
+                case '<': case '(': return D2 | D4;
+                case '>': case ')': return D1 | D3;
+                case '*': return D1 | D2 | D3 | D4 | M | V;
+                case '\'': return V1;
+                case '"': return L1 | V1;
+                case '?': return T | R1 | M2 | V2;
+                case '!': return V1;
+                default: return 0;
+            }
+        }
+
+        void text(const glm::vec3 &position, std::string_view text, const glm::vec4 &color, float height, DebugDrawOptions options) {
+            std::size_t count = 0;
+            for (char c : text) count += std::popcount(glyph(c));
+
+            Lines lines(count, color, options);
+            if (!lines) return;
+
+            // Glyphs are 0.6 of the height wide, with a gap of 0.25 between them and 0.5 between lines.
+            float unit_x = height * 0.3f;
+            float unit_y = height * 0.5f;
+            glm::vec2 cursor(0.0f);
+            for (char c : text) {
+                if (c == '\n') {
+                    cursor = {0.0f, cursor.y - height * 1.5f};
+                    continue;
+                }
+
+                std::uint16_t segments = glyph(c);
+                for (int s = 0; s < 16; s++) {
+                    if (!(segments & (1 << s))) continue;
+                    const auto &p = segment_points[s];
+                    lines.add(position, position, cursor + glm::vec2(p[0] * unit_x, p[1] * unit_y),
+                              cursor + glm::vec2(p[2] * unit_x, p[3] * unit_y));
+                }
+                cursor.x += height * 0.85f;
+            }
+        }
+
+    } // debug_draw
+
+    struct DebugVertex {
+        glm::vec3 position;
+        std::uint32_t color;
+        glm::vec2 offset;
+        // To 32 bytes, so every vertex offset in the stream is a whole vertex index.
+        float padding[2];
+    };
+
+    static_assert(sizeof(DebugVertex) == 32);
+
+    static constexpr const char *vertex_source = R"(#version 450
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec4 color;
+layout(location = 2) in vec2 offset;
+
+layout(location = 0) uniform mat4 view_projection;
+layout(location = 1) uniform vec2 viewport;
+
+layout(location = 0) out vec4 v_color;
+
+void main() {
+    vec4 clip = view_projection * vec4(position, 1.0);
+    clip.xy += offset * 2.0 / viewport * clip.w;
+    gl_Position = clip;
+    v_color = color;
+}
+)";
+
+    static constexpr const char *fragment_source = R"(#version 450
+layout(location = 0) in vec4 v_color;
+layout(location = 0) out vec4 frag_color;
+
+void main() {
+    frag_color = v_color;
+}
+)";
+
+    static constexpr int view_projection_location = 0;
+    static constexpr int viewport_location = 1;
+
+    DebugDrawRenderer::DebugDrawRenderer(std::unique_ptr<Shader> shader, std::unique_ptr<StreamBuffer> vertices,
+                                         std::unique_ptr<VertexArray> vertex_array, std::size_t max_lines)
+        : shader(std::move(shader)), vertices(std::move(vertices)), vertex_array(std::move(vertex_array)), max_lines(max_lines) {
+        RenderStateDesc desc;
+        desc.blend = BlendState::alpha();
+        desc.depth = {.test = true, .write = false, .func = GL_LEQUAL};
+        depth_tested = RenderState::get(desc);
+        desc.depth = {.test = false, .write = false};
+        on_top = RenderState::get(desc);
+
+        pending.reserve(max_lines);
+        retained.reserve(max_lines);
+    }
+
+    std::unique_ptr<DebugDrawRenderer> DebugDrawRenderer::create(std::size_t max_lines, unsigned int frames) {
+        max_lines = std::max<std::size_t>(max_lines, 1);
+
+        ShaderSource vertex{ShaderType::Vertex, vertex_source};
+        vertex.name = "debug_draw.vert";
+        ShaderSource fragment{ShaderType::Fragment, fragment_source};
+        fragment.name = "debug_draw.frag";
+        auto shader = Shader::create({vertex, fragment});
+        if (!shader) {
+            spdlog::error("Failed to build the debug draw shaders");
+            return nullptr;
+        }
+
+        auto vertices = StreamBuffer::create(sizeof(DebugVertex) * 2 * max_lines, frames);
+        if (!vertices) return nullptr;
+
+        auto vertex_array = VertexArray::create();
+        vertex_array->vertex_buffer(&vertices->get_buffer(), {
+            {3, offsetof(DebugVertex, position), "position"},
+            {4, offsetof(DebugVertex, color), "color", GL_UNSIGNED_BYTE, true},
+            {2, offsetof(DebugVertex, offset), "offset"},
+        }, sizeof(DebugVertex));
+
+        return std::unique_ptr<DebugDrawRenderer>(new DebugDrawRenderer(std::move(shader), std::move(vertices), std::move(vertex_array),
+                                                                        max_lines));
+    }
+
+    void DebugDrawRenderer::render(const glm::mat4 &view_projection, glm::vec2 viewport) {
+        if (DebugDraw *draw = DebugDraw::get()) stats.dropped += draw->drain(pending, max_lines - std::min(retained.size(), max_lines));
+
+        std::size_t total = retained.size() + pending.size();
+        if (total != 0) {
+            StreamAllocation allocation = vertices->allocate(total * 2 * sizeof(DebugVertex), sizeof(DebugVertex));
+            if (allocation.data) {
+                auto *out = reinterpret_cast<DebugVertex *>(allocation.data);
+                std::size_t written = 0;
+                auto write = [&](bool depth_test) {
+                    std::size_t first = written;
+                    for (const auto *lines : {&retained, &pending}) {
+                        for (const DebugLine &line : *lines) {
+                            if (line.depth_test != depth_test) continue;
+                            out[written++] = {line.a, line.color, line.offset_a, {}};
+                            out[written++] = {line.b, line.color, line.offset_b, {}};
+                        }
+                    }
+                    return written - first;
+                };
+                std::size_t depth_tested_vertices = write(true);
+                std::size_t on_top_vertices = write(false);
+
+                shader->bind();
+                shader->uniform_mat4f(view_projection_location, view_projection);
+                shader->uniform_2f(viewport_location, glm::max(viewport, glm::vec2(1.0f)));
+                vertex_array->bind();
+
+                auto first = static_cast<GLint>(allocation.offset / sizeof(DebugVertex));
+                if (depth_tested_vertices) {
+                    depth_tested->bind();
+                    glDrawArrays(GL_LINES, first, static_cast<GLsizei>(depth_tested_vertices));
+                    stats.draw_calls++;
+                }
+                if (on_top_vertices) {
+                    on_top->bind();
+                    glDrawArrays(GL_LINES, first + static_cast<GLint>(depth_tested_vertices), static_cast<GLsizei>(on_top_vertices));
+                    stats.draw_calls++;
+                }
+                stats.lines += total;
+            } else {
+                stats.dropped += total;
+            }
+        }
+
+        // Age what was kept, then keep the new lines that asked for more than this frame.
+        std::erase_if(retained, [](DebugLine &line) { return --line.frames == 0; });
+        for (DebugLine &line : pending) {
+            if (line.frames > 1 && retained.size() < max_lines) {
+                line.frames--;
+                retained.push_back(line);
+            }
+        }
+        pending.clear();
+
+        vertices->next_frame();
+    }
+
+    const DebugDrawStats &DebugDrawRenderer::get_stats() const noexcept {
+        return stats;
+    }
+
+    void DebugDrawRenderer::reset_stats() noexcept {
+        stats = {};
+    }
+
+} // gc
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/buffer.hpp"
+#include "graphicat/graphics/render_state.hpp"
+#include "graphicat/graphics/shader.hpp"
+#include "graphicat/graphics/stream_buffer.hpp"
+#include "graphicat/graphics/vertex_array.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace gc {
+
+    struct DebugDrawOptions {
+        // Hidden behind geometry already in the depth buffer; otherwise drawn on top of everything.
+        bool depth_test = true;
+        // How many renders the shape stays for. 0 counts as 1.
+        std::uint16_t frames = 1;
+    };
+
+    struct DebugLine {
+        glm::vec3 a;
+        glm::vec3 b;
+        // Added on screen, in pixels, after projection; how text keeps its size and faces the camera.
+        glm::vec2 offset_a;
+        glm::vec2 offset_b;
+        std::uint32_t color; // RGBA, R in the lowest byte
+        std::uint16_t frames;
+        bool depth_test;
+    };
+
+    // One thread's queued lines. Only that thread writes and only DebugDraw::drain reads, so neither side needs a lock: the writer
+    // publishes with a release store of head, the reader frees space with a release store of tail.
+    class DebugLineRing {
+        std::unique_ptr<DebugLine[]> lines;
+        std::size_t mask;
+        alignas(64) std::atomic<std::size_t> head = 0;
+        alignas(64) std::atomic<std::size_t> tail = 0;
+
+        friend class DebugDraw;
+
+    public:
+        // Rounded up to a power of two.
+        explicit DebugLineRing(std::size_t capacity);
+
+        // Index of the first of `count` free lines, or npos if they don't fit; fill them with at() and publish with commit().
+        [[nodiscard]] std::size_t reserve(std::size_t count) const noexcept {
+            std::size_t h = head.load(std::memory_order_relaxed);
+            return h + count - tail.load(std::memory_order_acquire) <= mask + 1 ? h : npos;
+        }
+
+        [[nodiscard]] DebugLine &at(std::size_t index) noexcept {
+            return lines[index & mask];
+        }
+
+        void commit(std::size_t end) noexcept {
+            head.store(end, std::memory_order_release);
+        }
+
+        static constexpr std::size_t npos = ~std::size_t(0);
+    };
+
+    // Collects what the gc::debug_draw functions queue, from any number of threads. Each thread gets its own DebugLineRing the first
+    // time it draws (the only time a lock is taken), so a call costs a thread_local lookup and a few stores, and never allocates.
+    // When a ring is full the shape is dropped and counted. GlobalState owns one, sized by GraphicatProperties::debug_draw_lines;
+    // DebugDrawRenderer empties it.
+    namespace detail {
+        struct DebugRingPool;
+    } // detail
+
+    class DebugDraw {
+        std::size_t ring_capacity;
+        std::uint64_t generation;
+        // Shared with the threads holding rings, so one exiting after the DebugDraw is gone doesn't touch freed memory.
+        std::shared_ptr<detail::DebugRingPool> pool;
+        std::atomic<std::size_t> dropped = 0;
+
+        inline static std::atomic<std::uint64_t> s_next_generation = 1;
+
+    public:
+        explicit DebugDraw(std::size_t ring_capacity);
+        ~DebugDraw();
+
+        DebugDraw(const DebugDraw &) = delete;
+        DebugDraw &operator=(const DebugDraw &) = delete;
+
+        static DebugDraw *get();
+
+        // The calling thread's ring, taken on first use. When the thread exits its ring goes back to a free list, lines still
+        // queued in it included, and the next new thread takes it over; short-lived threads don't add up.
+        DebugLineRing &get_thread_ring();
+
+        // Moves every queued line into `out`, up to `max` lines in total; the rest are dropped. Returns how many lines were dropped
+        // since the last drain, counting those that found their ring full.
+        std::size_t drain(std::vector<DebugLine> &out, std::size_t max);
+
+        // For shapes that didn't fit in their ring.
+        void add_dropped(std::size_t count) noexcept;
+    };
+
+    // Queue shapes for the next DebugDrawRenderer::render(). Safe from any thread, and no-ops when there is no GlobalState or it
+    // was created with debug_draw_lines = 0.
+    namespace debug_draw {
+        void line(const glm::vec3 &a, const glm::vec3 &b, const glm::vec4 &color = glm::vec4(1.0f), DebugDrawOptions options = {});
+        void box(const glm::vec3 &min, const glm::vec3 &max, const glm::vec4 &color = glm::vec4(1.0f), DebugDrawOptions options = {});
+        // The cube from -1 to 1 through `transform`, with the perspective divide, so an inverse view projection draws a frustum.
+        void box(const glm::mat4 &transform, const glm::vec4 &color = glm::vec4(1.0f), DebugDrawOptions options = {});
+        // Three circles, one around each axis.
+        void sphere(const glm::vec3 &center, float radius, const glm::vec4 &color = glm::vec4(1.0f), DebugDrawOptions options = {});
+        // Red, green and blue lines along the transform's x, y and z axes.
+        void axes(const glm::mat4 &transform, float length = 1.0f, DebugDrawOptions options = {});
+        // Stroked 16-segment glyphs anchored at `position` and `height` pixels tall, facing the camera. Letters come out upper
+        // case; characters without a glyph leave a gap. '\n' starts a new line.
+        void text(const glm::vec3 &position, std::string_view text, const glm::vec4 &color = glm::vec4(1.0f), float height = 12.0f,
+                  DebugDrawOptions options = {});
+    } // debug_draw
+
+    struct DebugDrawStats {
+        std::uint64_t lines = 0;
+        std::uint64_t draw_calls = 0;
+        // Lines that didn't fit in a thread's ring or in the frame.
+        std::uint64_t dropped = 0;
+    };
+
+    // Draws what gc::debug_draw queued: depth tested lines first, then the ones on top, one glDrawArrays(GL_LINES) each, from a
+    // persistently mapped ring. Lines asked to stay for several frames are kept here and drawn again by the following renders.
+    //
+    //     auto debug = gc::DebugDrawRenderer::create();
+    //     ...
+    //     gc::debug_draw::box(bounds.min, bounds.max, {0.0f, 1.0f, 0.0f, 1.0f});   // from any thread
+    //     ...
+    //     debug->render(projection * view, window_size);   // once per frame, on the GL thread
+    //
+    // render() leaves its own program, vertex array and render state (alpha blending, no depth writes) bound.
+    class DebugDrawRenderer {
+        std::unique_ptr<Shader> shader;
+        std::unique_ptr<StreamBuffer> vertices;
+        std::unique_ptr<VertexArray> vertex_array;
+        std::shared_ptr<const RenderState> depth_tested;
+        std::shared_ptr<const RenderState> on_top;
+        std::size_t max_lines;
+
+        std::vector<DebugLine> pending;
+        std::vector<DebugLine> retained;
+        DebugDrawStats stats;
+
+        DebugDrawRenderer(std::unique_ptr<Shader> shader, std::unique_ptr<StreamBuffer> vertices, std::unique_ptr<VertexArray> vertex_array,
+                          std::size_t max_lines);
+
+    public:
+        // Room for `max_lines` lines per frame, new and kept together. nullptr if the shaders fail to build or the ring can't be
+        // mapped.
+        static std::unique_ptr<DebugDrawRenderer> create(std::size_t max_lines = 64 * 1024, unsigned int frames = 3);
+
+        // `viewport` is the framebuffer size in pixels, which text is sized against.
+        void render(const glm::mat4 &view_projection, glm::vec2 viewport);
+
+        [[nodiscard]] const DebugDrawStats &get_stats() const noexcept;
+        void reset_stats() noexcept;
+    };
+
+} // gc
@@ -0,0 +1,40 @@
+#include "draw_batcher.hpp"
+#include "draw_indirect.hpp"
+#include <algorithm>
+
+namespace gc {
+
+    DrawBatcher::DrawBatcher(std::unique_ptr<StreamBuffer> commands, std::uint32_t min_run)
+        : commands(std::move(commands)), min_run(min_run) {
+    }
+
+    std::unique_ptr<DrawBatcher> DrawBatcher::create(std::uint32_t max_draws, unsigned int frames, std::uint32_t min_run) {
+        // Sized for the larger command so a frame holds max_draws of either kind.
+        auto commands = StreamBuffer::create(sizeof(DrawElementsIndirectCommand) * max_draws, frames);
+        if (!commands) return nullptr;
+
+        return std::unique_ptr<DrawBatcher>(new DrawBatcher(std::move(commands), std::max(min_run, 2u)));
+    }
+
+    StreamAllocation DrawBatcher::allocate(std::uint32_t draws, std::size_t stride) {
+        // Indirect commands only need 4 byte alignment.
+        return commands->allocate(draws * stride, 4);
+    }
+
+    void DrawBatcher::next_frame() {
+        commands->next_frame();
+    }
+
+    std::uint32_t DrawBatcher::get_min_run() const noexcept {
+        return min_run;
+    }
+
+    const Buffer &DrawBatcher::get_buffer() const noexcept {
+        return commands->get_buffer();
+    }
+
+    const StreamBuffer &DrawBatcher::get_stream() const noexcept {
+        return *commands;
+    }
+
+} // gc
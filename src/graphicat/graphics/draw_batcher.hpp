@@ -0,0 +1,38 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/stream_buffer.hpp"
+#include <cstdint>
+#include <memory>
+
+namespace gc {
+
+    // Where CommandList::execute writes the indirect commands of draws it fuses. Runs of consecutive items (after sorting) that
+    // bind the same program and vertex array and differ only in what they draw become one glMultiDraw*Indirect, with the commands
+    // streamed through a persistently mapped ring.
+    //
+    // Inside a fused run gl_DrawID counts up from 0, where a lone draw always sees 0, so per-draw data should be looked up with
+    // gl_BaseInstance (see PerDrawData) rather than gl_DrawID. Items that set uniforms, buffers or textures are never fused.
+    class DrawBatcher {
+        std::unique_ptr<StreamBuffer> commands;
+        std::uint32_t min_run;
+
+        DrawBatcher(std::unique_ptr<StreamBuffer> commands, std::uint32_t min_run);
+
+    public:
+        // `max_draws` is how many fused draws fit in a frame; once it's used up, the rest are drawn one by one. Runs shorter than
+        // `min_run` aren't worth a command upload and are drawn one by one too.
+        static std::unique_ptr<DrawBatcher> create(std::uint32_t max_draws, unsigned int frames = 3, std::uint32_t min_run = 2);
+
+        // Room for `draws` commands of `stride` bytes, or data == nullptr if this frame is full.
+        StreamAllocation allocate(std::uint32_t draws, std::size_t stride);
+
+        // Call once per frame, after the last execute.
+        void next_frame();
+
+        [[nodiscard]] std::uint32_t get_min_run() const noexcept;
+        [[nodiscard]] const Buffer &get_buffer() const noexcept;
+        [[nodiscard]] const StreamBuffer &get_stream() const noexcept;
+    };
+
+} // gc
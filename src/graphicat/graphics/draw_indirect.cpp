@@ -0,0 +1,50 @@
+#include "draw_indirect.hpp"
+#include "barrier_tracker.hpp"
+#include "state_cache.hpp"
+
+namespace gc {
+
+    static void bind_commands(const Buffer &commands) {
+        if (BarrierTracker *tracker = BarrierTracker::get()) {
+            tracker->read(commands.get_handle(), BufferAccess::Command);
+            tracker->flush();
+        }
+        bind_buffer(GL_DRAW_INDIRECT_BUFFER, commands.get_handle());
+    }
+
+    void multi_draw_elements_indirect(const Buffer &commands, size_t offset, std::uint32_t draw_count, GLenum mode, GLenum index_type) {
+        if (draw_count == 0) return;
+        bind_commands(commands);
+        glMultiDrawElementsIndirect(mode, index_type, reinterpret_cast<const void *>(offset), static_cast<GLsizei>(draw_count),
+                                    sizeof(DrawElementsIndirectCommand));
+    }
+
+    void multi_draw_elements_indirect_count(const Buffer &commands, size_t offset, const Buffer &count, size_t count_offset,
+                                            std::uint32_t max_draw_count, GLenum mode, GLenum index_type) {
+        if (max_draw_count == 0) return;
+        if (BarrierTracker *tracker = BarrierTracker::get()) tracker->read(count.get_handle(), BufferAccess::Command);
+        bind_commands(commands); // flushes the count read along with the command read
+
+        bind_buffer(GL_PARAMETER_BUFFER, count.get_handle());
+
+        if (GLAD_GL_VERSION_4_6)
+            glMultiDrawElementsIndirectCount(mode, index_type, reinterpret_cast<const void *>(offset), static_cast<GLintptr>(count_offset),
+                                             static_cast<GLsizei>(max_draw_count), sizeof(DrawElementsIndirectCommand));
+        else
+            glMultiDrawElementsIndirectCountARB(mode, index_type, reinterpret_cast<const void *>(offset),
+                                                static_cast<GLintptr>(count_offset), static_cast<GLsizei>(max_draw_count),
+                                                sizeof(DrawElementsIndirectCommand));
+    }
+
+    bool has_indirect_count() {
+        return GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_indirect_parameters;
+    }
+
+    void multi_draw_arrays_indirect(const Buffer &commands, size_t offset, std::uint32_t draw_count, GLenum mode) {
+        if (draw_count == 0) return;
+        bind_commands(commands);
+        glMultiDrawArraysIndirect(mode, reinterpret_cast<const void *>(offset), static_cast<GLsizei>(draw_count),
+                                  sizeof(DrawArraysIndirectCommand));
+    }
+
+} // gc
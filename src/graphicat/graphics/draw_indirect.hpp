@@ -0,0 +1,41 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/buffer.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace gc {
+
+    // Layouts glMultiDraw*Indirect reads from GL_DRAW_INDIRECT_BUFFER.
+    struct DrawElementsIndirectCommand {
+        std::uint32_t count;
+        std::uint32_t instance_count;
+        std::uint32_t first_index;
+        std::int32_t base_vertex;
+        std::uint32_t base_instance;
+    };
+
+    struct DrawArraysIndirectCommand {
+        std::uint32_t count;
+        std::uint32_t instance_count;
+        std::uint32_t first;
+        std::uint32_t base_instance;
+    };
+
+    static_assert(sizeof(DrawElementsIndirectCommand) == 20 && sizeof(DrawArraysIndirectCommand) == 16);
+
+    // Draws `draw_count` tightly packed commands starting at `offset` in `commands` with the currently bound program and vertex
+    // array. Waits on a compute pass that wrote the commands, if there was one.
+    void multi_draw_elements_indirect(const Buffer &commands, size_t offset, std::uint32_t draw_count, GLenum mode = GL_TRIANGLES,
+                                      GLenum index_type = GL_UNSIGNED_INT);
+    void multi_draw_arrays_indirect(const Buffer &commands, size_t offset, std::uint32_t draw_count, GLenum mode = GL_TRIANGLES);
+
+    // Like multi_draw_elements_indirect, but the number of commands is a uint at `count_offset` in `count`, capped at
+    // `max_draw_count`, so a compute pass can decide it. Needs GL 4.6 or ARB_indirect_parameters; see has_indirect_count().
+    void multi_draw_elements_indirect_count(const Buffer &commands, size_t offset, const Buffer &count, size_t count_offset,
+                                            std::uint32_t max_draw_count, GLenum mode = GL_TRIANGLES, GLenum index_type = GL_UNSIGNED_INT);
+
+    [[nodiscard]] bool has_indirect_count();
+
+} // gc
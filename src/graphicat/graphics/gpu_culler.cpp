@@ -0,0 +1,299 @@
+#include "gpu_culler.hpp"
+#include "barrier_tracker.hpp"
+#include "draw_indirect.hpp"
+#include "state_cache.hpp"
+#include "uniform_block.hpp"
+#include <algorithm>
+#include <bit>
+#include <spdlog/spdlog.h>
+
+namespace gc {
+
+    // Explicit uniform locations, so neither program needs reflection to be set up.
+    static constexpr int instance_count_location = 0;
+    static constexpr int planes_location = 1; // 6 of them
+    static constexpr int occlusion_location = 7;
+    static constexpr int hi_z_view_projection_location = 8;
+    static constexpr int hi_z_size_location = 9;
+    static constexpr int hi_z_levels_location = 10;
+    static constexpr int source_level_location = 0;
+
+    static constexpr const char *cull_source = R"(#version 450
+layout(local_size_x = 64) in;
+
+struct Instance { vec4 sphere; uint mesh; uint padding0, padding1, padding2; };
+struct Mesh { uint count; uint first_index; int base_vertex; };
+struct Command { uint count; uint instance_count; uint first_index; int base_vertex; uint base_instance; };
+
+// No explicit bindings: Shader assigns these by name (see get_block_binding), and cull() binds the buffers to the same names.
+layout(std430) readonly buffer CullInstances { Instance instances[]; };
+layout(std430) readonly buffer CullMeshes { Mesh meshes[]; };
+layout(std430) writeonly buffer CullCommands { Command commands[]; };
+layout(std430) buffer CullCount { uint visible_count; };
+
+layout(location = 0) uniform uint instance_count;
+layout(location = 1) uniform vec4 planes[6];
+layout(location = 7) uniform uint occlusion;
+layout(location = 8) uniform mat4 hi_z_view_projection;
+layout(location = 9) uniform vec2 hi_z_size;
+layout(location = 10) uniform int hi_z_levels;
+layout(binding = 0) uniform sampler2D hi_z;
+
+shared uint group_count;
+shared uint group_base;
+
+bool occluded(vec4 sphere) {
+    vec3 lo = sphere.xyz - sphere.w;
+    vec3 hi = sphere.xyz + sphere.w;
+
+    vec2 rect_min = vec2(1.0);
+    vec2 rect_max = vec2(0.0);
+    float nearest = 1.0;
+    for (int i = 0; i < 8; i++) {
+        vec3 corner = vec3((i & 1) != 0 ? hi.x : lo.x, (i & 2) != 0 ? hi.y : lo.y, (i & 4) != 0 ? hi.z : lo.z);
+        vec4 clip = hi_z_view_projection * vec4(corner, 1.0);
+        // Reaches behind the camera; the projected rectangle means nothing.
+        if (clip.w <= 0.0) return false;
+
+        vec3 ndc = clip.xyz / clip.w;
+        rect_min = min(rect_min, ndc.xy * 0.5 + 0.5);
+        rect_max = max(rect_max, ndc.xy * 0.5 + 0.5);
+        nearest = min(nearest, ndc.z * 0.5 + 0.5);
+    }
+    rect_min = clamp(rect_min, 0.0, 1.0);
+    rect_max = clamp(rect_max, 0.0, 1.0);
+
+    // The level where the rectangle is at most a texel wide, so it touches at most 2x2 texels.
+    vec2 extent = (rect_max - rect_min) * hi_z_size;
+    int level = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), 0, hi_z_levels - 1);
+    ivec2 size = textureSize(hi_z, level);
+    ivec2 a = clamp(ivec2(rect_min * vec2(size)), ivec2(0), size - 1);
+    ivec2 b = clamp(ivec2(rect_max * vec2(size)), ivec2(0), size - 1);
+
+    float farthest = 0.0;
+    for (int y = a.y; y <= b.y; y++) {
+        for (int x = a.x; x <= b.x; x++) farthest = max(farthest, texelFetch(hi_z, ivec2(x, y), level).r);
+    }
+    return nearest > farthest;
+}
+
+void main() {
+    if (gl_LocalInvocationIndex == 0) group_count = 0;
+    barrier();
+
+    uint index = gl_GlobalInvocationID.x;
+    bool visible = index < instance_count;
+    vec4 sphere = vec4(0.0);
+    uint mesh = 0;
+    if (visible) {
+        sphere = instances[index].sphere;
+        mesh = instances[index].mesh;
+        for (int i = 0; i < 6; i++) {
+            if (dot(planes[i].xyz, sphere.xyz) + planes[i].w < -sphere.w) visible = false;
+        }
+        if (visible && occlusion != 0) visible = !occluded(sphere);
+    }
+
+    // Compact within the group first, so there is one global atomic per group rather than per survivor.
+    uint slot = 0;
+    if (visible) slot = atomicAdd(group_count, 1);
+    barrier();
+    if (gl_LocalInvocationIndex == 0 && group_count != 0) group_base = atomicAdd(visible_count, group_count);
+    barrier();
+
+    if (visible) {
+        Mesh m = meshes[mesh];
+        commands[group_base + slot] = Command(m.count, 1u, m.first_index, m.base_vertex, index);
+    }
+}
+)";
+
+    static constexpr const char *reduce_source = R"(#version 450
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D source;
+layout(binding = 0, r32f) uniform writeonly image2D destination;
+layout(location = 0) uniform int source_level;
+
+void main() {
+    ivec2 destination_size = imageSize(destination);
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(p, destination_size))) return;
+
+    // Every source texel the destination texel overlaps, which is 3 wide instead of 2 where the source size is odd.
+    ivec2 source_size = textureSize(source, source_level);
+    ivec2 lo = p * source_size / destination_size;
+    ivec2 hi = min(((p + 1) * source_size + destination_size - 1) / destination_size, source_size);
+
+    float depth = 0.0;
+    for (int y = lo.y; y < hi.y; y++) {
+        for (int x = lo.x; x < hi.x; x++) depth = max(depth, texelFetch(source, ivec2(x, y), source_level).r);
+    }
+    imageStore(destination, p, vec4(depth));
+}
+)";
+
+    GpuCuller::GpuCuller(std::unique_ptr<Shader> cull_program, std::unique_ptr<Shader> reduce_program, std::unique_ptr<Buffer> commands,
+                         std::unique_ptr<Buffer> count, std::uint32_t capacity)
+        : cull_program(std::move(cull_program)), reduce_program(std::move(reduce_program)), commands(std::move(commands)),
+          count(std::move(count)), capacity(capacity), indirect_count(has_indirect_count()) {
+        // Texel fetches still need a complete texture, which a single level depth texture with the default filter isn't.
+        glCreateSamplers(1, &sampler);
+        glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    }
+
+    GpuCuller::~GpuCuller() {
+        destroy_hi_z();
+        glDeleteSamplers(1, &sampler);
+    }
+
+    void GpuCuller::destroy_hi_z() {
+        if (!hi_z) return;
+        if (StateCache *cache = StateCache::get()) cache->forget_texture(hi_z);
+        glDeleteTextures(1, &hi_z);
+        hi_z = 0;
+        hi_z_valid = false;
+    }
+
+    std::unique_ptr<GpuCuller> GpuCuller::create(std::uint32_t max_instances) {
+        ShaderSource cull{ShaderType::Compute, cull_source};
+        cull.name = "gpu_culler_cull.comp";
+        ShaderSource reduce{ShaderType::Compute, reduce_source};
+        reduce.name = "gpu_culler_reduce.comp";
+
+        auto cull_program = Shader::create({cull});
+        auto reduce_program = Shader::create({reduce});
+        if (!cull_program || !reduce_program) {
+            spdlog::error("Failed to build the GPU culling shaders");
+            return nullptr;
+        }
+
+        auto commands = Buffer::allocate(sizeof(DrawElementsIndirectCommand) * std::max(max_instances, 1u), BufferUsage::DynamicCopy);
+        std::uint32_t zero = 0;
+        auto count = Buffer::load(sizeof(zero), &zero, BufferUsage::DynamicCopy);
+
+        return std::unique_ptr<GpuCuller>(new GpuCuller(std::move(cull_program), std::move(reduce_program), std::move(commands),
+                                                        std::move(count), max_instances));
+    }
+
+    void GpuCuller::build_hi_z(unsigned int depth_texture, glm::uvec2 size, const glm::mat4 &view_projection) {
+        if (size.x == 0 || size.y == 0) return;
+
+        // Level 0 is already half the depth buffer; a full resolution copy would never be the level a sphere picks.
+        glm::uvec2 base = glm::max(size / 2u, glm::uvec2(1));
+        if (base != hi_z_size || !hi_z) {
+            destroy_hi_z();
+            hi_z_size = base;
+            hi_z_levels = std::bit_width(std::max(base.x, base.y));
+
+            glCreateTextures(GL_TEXTURE_2D, 1, &hi_z);
+            glTextureStorage2D(hi_z, hi_z_levels, GL_R32F, static_cast<GLsizei>(base.x), static_cast<GLsizei>(base.y));
+        }
+
+        glBindSampler(0, sampler);
+        glm::uvec2 level_size = base;
+        for (int level = 0; level < hi_z_levels; level++) {
+            bind_texture_unit(0, level == 0 ? depth_texture : hi_z);
+            reduce_program->uniform_1i(source_level_location, level == 0 ? 0 : level - 1);
+            glBindImageTexture(0, hi_z, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+            reduce_program->dispatch_invocations({level_size, 1});
+
+            // The next level reads this one through the sampler; after the last, cull() does.
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+            level_size = glm::max(level_size / 2u, glm::uvec2(1));
+        }
+        glBindSampler(0, 0);
+
+        hi_z_view_projection = view_projection;
+        hi_z_valid = true;
+    }
+
+    void GpuCuller::clear_hi_z() noexcept {
+        hi_z_valid = false;
+    }
+
+    void GpuCuller::cull(const Buffer &instances, const Buffer &meshes, std::uint32_t instance_count, const glm::mat4 &view_projection) {
+        if (instance_count > capacity) {
+            spdlog::warn("GpuCuller got {} instances but only has room for {}", instance_count, capacity);
+            instance_count = capacity;
+        }
+        draw_count = instance_count;
+
+        std::uint32_t zero = 0;
+        count->update(0, sizeof(zero), &zero);
+        if (!indirect_count) {
+            // draw() will submit draw_count commands, so the ones past the survivors have to draw nothing.
+            if (BarrierTracker *tracker = BarrierTracker::get()) {
+                tracker->read(commands->get_handle(), BufferAccess::Update);
+                tracker->flush();
+            }
+            glClearNamedBufferSubData(commands->get_handle(), GL_R32UI, 0, sizeof(DrawElementsIndirectCommand) * instance_count,
+                                      GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+        }
+        if (instance_count == 0) return;
+
+        // Gribb & Hartmann: each plane is the last row of the matrix plus or minus one of the others, pointing inwards.
+        for (int i = 0; i < 6; i++) {
+            int row = i / 2;
+            float sign = i % 2 == 0 ? 1.0f : -1.0f;
+            glm::vec4 plane;
+            for (int column = 0; column < 4; column++)
+                plane[column] = view_projection[column][3] + sign * view_projection[column][row];
+            cull_program->uniform_4f(planes_location + i, plane / glm::length(glm::vec3(plane)));
+        }
+
+        cull_program->uniform_1ui(instance_count_location, instance_count);
+        cull_program->uniform_1ui(occlusion_location, hi_z_valid ? 1u : 0u);
+        if (hi_z_valid) {
+            cull_program->uniform_mat4f(hi_z_view_projection_location, hi_z_view_projection);
+            cull_program->uniform_2f(hi_z_size_location, glm::vec2(hi_z_size));
+            cull_program->uniform_1i(hi_z_levels_location, hi_z_levels);
+            glBindSampler(0, sampler);
+            bind_texture_unit(0, hi_z);
+        }
+
+        instances.bind_base(BufferTarget::ShaderStorage, get_block_binding(BlockType::ShaderStorage, "CullInstances"));
+        meshes.bind_base(BufferTarget::ShaderStorage, get_block_binding(BlockType::ShaderStorage, "CullMeshes"));
+        commands->bind_base(BufferTarget::ShaderStorage, get_block_binding(BlockType::ShaderStorage, "CullCommands"));
+        count->bind_base(BufferTarget::ShaderStorage, get_block_binding(BlockType::ShaderStorage, "CullCount"));
+        cull_program->dispatch_invocations({instance_count, 1, 1}, {commands.get(), count.get()});
+
+        if (hi_z_valid) glBindSampler(0, 0);
+    }
+
+    void GpuCuller::draw(GLenum mode, GLenum index_type) const {
+        if (indirect_count)
+            multi_draw_elements_indirect_count(*commands, 0, *count, 0, draw_count, mode, index_type);
+        else
+            multi_draw_elements_indirect(*commands, 0, draw_count, mode, index_type);
+    }
+
+    std::uint32_t GpuCuller::read_visible_count() const {
+        if (BarrierTracker *tracker = BarrierTracker::get()) {
+            tracker->read(count->get_handle(), BufferAccess::Update);
+            tracker->flush();
+        }
+        std::uint32_t visible = 0;
+        glGetNamedBufferSubData(count->get_handle(), 0, sizeof(visible), &visible);
+        return visible;
+    }
+
+    bool GpuCuller::has_hi_z() const noexcept {
+        return hi_z_valid;
+    }
+
+    bool GpuCuller::uses_indirect_count() const noexcept {
+        return indirect_count;
+    }
+
+    const Buffer &GpuCuller::get_commands() const noexcept {
+        return *commands;
+    }
+
+    const Buffer &GpuCuller::get_count() const noexcept {
+        return *count;
+    }
+
+} // gc
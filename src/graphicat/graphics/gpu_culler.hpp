@@ -0,0 +1,102 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/block_layout.hpp"
+#include "graphicat/graphics/buffer.hpp"
+#include "graphicat/graphics/shader.hpp"
+#include <cstdint>
+#include <memory>
+
+namespace gc {
+
+    // One entry of the instance buffer GpuCuller reads: a world space bounding sphere and the mesh to draw if it survives.
+    struct CullInstance {
+        glm::vec4 sphere; // center, radius
+        std::uint32_t mesh;
+        std::uint32_t padding[3] = {};
+    };
+
+    // Where a mesh's indices are, copied into the command of every visible instance of it.
+    struct CullMesh {
+        std::uint32_t count;
+        std::uint32_t first_index;
+        std::int32_t base_vertex;
+    };
+
+} // gc
+
+GC_BLOCK_LAYOUT(gc::CullInstance, sphere, mesh, padding)
+GC_BLOCK_LAYOUT(gc::CullMesh, count, first_index, base_vertex)
+
+namespace gc {
+
+    static_assert(block_layout_matches<Std430, CullInstance> && struct_layout<Std430, CullInstance>().size == sizeof(CullInstance));
+    static_assert(block_layout_matches<Std430, CullMesh> && struct_layout<Std430, CullMesh>().size == sizeof(CullMesh));
+
+    // Frustum and occlusion culling in a compute shader, so the CPU never looks at individual instances. cull() tests each
+    // instance's sphere against the frustum and against a hierarchical-Z pyramid of last frame's depth, and appends a
+    // DrawElementsIndirectCommand for every survivor, compacted with atomics (one per work group). draw() then submits them with
+    // glMultiDrawElementsIndirectCount, reading the count straight from the GPU.
+    //
+    //     culler->cull(*instances, *meshes, instance_count, projection * view);
+    //     shader->bind();
+    //     vao->bind();
+    //     culler->draw();
+    //     ...
+    //     culler->build_hi_z(depth_texture, window_size, projection * view); // after the frame's depth is complete
+    //
+    // Each command draws one instance with base_instance set to its index in the instance buffer, so per-instance data is looked up
+    // with gl_BaseInstance (see PerDrawData). Without GL 4.6 or ARB_indirect_parameters (older Mesa llvmpipe, for one) the commands
+    // are cleared before culling and draw() submits `instance_count` of them; the ones past the survivors draw nothing.
+    //
+    // Depth is assumed to be GL's default: [0, 1] window depth, less-or-equal passes. The pyramid is a frame behind, so something
+    // that was hidden last frame and is uncovered this frame shows up one frame late; call clear_hi_z() after a camera cut.
+    class GpuCuller {
+        std::unique_ptr<Shader> cull_program;
+        std::unique_ptr<Shader> reduce_program;
+        std::unique_ptr<Buffer> commands;
+        std::unique_ptr<Buffer> count;
+        std::uint32_t capacity;
+        std::uint32_t draw_count = 0;
+        bool indirect_count;
+
+        unsigned int sampler = 0;
+        unsigned int hi_z = 0;
+        glm::uvec2 hi_z_size{0};
+        int hi_z_levels = 0;
+        glm::mat4 hi_z_view_projection{1.0f};
+        bool hi_z_valid = false;
+
+        GpuCuller(std::unique_ptr<Shader> cull_program, std::unique_ptr<Shader> reduce_program, std::unique_ptr<Buffer> commands,
+                  std::unique_ptr<Buffer> count, std::uint32_t capacity);
+
+        void destroy_hi_z();
+
+    public:
+        ~GpuCuller();
+
+        // Room for `max_instances` instances per cull. nullptr if the shaders fail to build.
+        static std::unique_ptr<GpuCuller> create(std::uint32_t max_instances);
+
+        // Downsamples `depth_texture` (any depth or single channel float format, `size` texels) into the pyramid the next cull()
+        // tests against. `view_projection` is the matrix the depth was rendered with.
+        void build_hi_z(unsigned int depth_texture, glm::uvec2 size, const glm::mat4 &view_projection);
+        // Turns occlusion culling off until the next build_hi_z().
+        void clear_hi_z() noexcept;
+
+        // `instances` holds CullInstances, `meshes` the CullMeshes they index. Instances past max_instances are dropped.
+        void cull(const Buffer &instances, const Buffer &meshes, std::uint32_t instance_count, const glm::mat4 &view_projection);
+
+        // Draws the last cull's survivors with the bound program and vertex array.
+        void draw(GLenum mode = GL_TRIANGLES, GLenum index_type = GL_UNSIGNED_INT) const;
+
+        // Reads the survivor count back. Stalls until the cull is done; for debugging and tests.
+        [[nodiscard]] std::uint32_t read_visible_count() const;
+
+        [[nodiscard]] bool has_hi_z() const noexcept;
+        [[nodiscard]] bool uses_indirect_count() const noexcept;
+        [[nodiscard]] const Buffer &get_commands() const noexcept;
+        [[nodiscard]] const Buffer &get_count() const noexcept;
+    };
+
+} // gc
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/block_layout.hpp"
+#include "graphicat/graphics/draw_indirect.hpp"
+#include "graphicat/graphics/stream_buffer.hpp"
+#include "graphicat/graphics/uniform_block.hpp"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <spdlog/spdlog.h>
+
+namespace gc {
+
+    // Per-object data for a frame's draws, in a storage block the shader indexes with the draw's base instance:
+    //
+    //     struct Object { mat4 transform; uint material; };
+    //     layout(std430) readonly buffer Objects { Object objects[]; };
+    //     ... objects[gl_BaseInstance] ...
+    //
+    // add() writes the object and an indirect command whose base_instance points at it, and draw() submits everything added since
+    // the last draw as a single glMultiDrawElementsIndirect, so a batch of objects with different transforms is one call. Both live
+    // in StreamBuffers, one region per frame in flight. An instanced command reads gl_BaseInstance + gl_InstanceID, so it needs
+    // one pushed entry per instance.
+    template<typename T, typename Layout = Std430> class PerDrawData {
+        static_assert(detail::registered_block<T>, "Describe the struct with GC_BLOCK_LAYOUT before using it as per-draw data");
+        static_assert(block_layout_matches<Layout, T>, "Struct does not follow the block layout; gc::block_layout_mismatch names the member");
+        static_assert(struct_layout<Layout, T>().size == sizeof(T), "Array stride of the struct in the block differs from sizeof; pad it");
+
+        std::unique_ptr<StreamBuffer> data;
+        std::unique_ptr<StreamBuffer> commands;
+        unsigned int binding;
+        std::uint32_t capacity;
+        std::uint32_t count = 0;
+        std::uint32_t command_count = 0;
+        std::uint32_t submitted = 0;
+
+        PerDrawData(std::unique_ptr<StreamBuffer> data, std::unique_ptr<StreamBuffer> commands, unsigned int binding, std::uint32_t capacity)
+            : data(std::move(data)), commands(std::move(commands)), binding(binding), capacity(capacity) {}
+
+    public:
+        static std::unique_ptr<PerDrawData> create(UniformName block, std::uint32_t max_draws, unsigned int frames = 3) {
+            auto data = StreamBuffer::create(sizeof(T) * max_draws, frames);
+            auto commands = StreamBuffer::create(sizeof(DrawElementsIndirectCommand) * max_draws, frames);
+            if (!data || !commands) return nullptr;
+
+            return std::unique_ptr<PerDrawData>(new PerDrawData(std::move(data), std::move(commands),
+                                                                get_block_binding(BlockType::ShaderStorage, block), max_draws));
+        }
+
+        // Writes the object and returns its index, for drawing with your own call (pass it as the base instance). Returns
+        // get_capacity() when this frame is full.
+        std::uint32_t push(const T &value) {
+            if (count >= capacity) {
+                spdlog::warn("PerDrawData is full ({} draws this frame)", capacity);
+                return capacity;
+            }
+
+            std::memcpy(data->get_region_data() + sizeof(T) * count, &value, sizeof(T));
+            return count++;
+        }
+
+        // Queues a draw of `command` reading `value`. base_instance is filled in.
+        void add(const T &value, DrawElementsIndirectCommand command) {
+            std::uint32_t index = push(value);
+            if (index == capacity) return;
+
+            command.base_instance = index;
+            std::memcpy(commands->get_region_data() + sizeof(DrawElementsIndirectCommand) * command_count++, &command, sizeof(command));
+        }
+
+        // Binds this frame's objects to the block.
+        void bind() const {
+            data->get_buffer().bind_range(BufferTarget::ShaderStorage, binding, data->get_region_offset(), sizeof(T) * capacity);
+        }
+
+        // Submits the draws added since the last call with the bound program and vertex array.
+        void draw(GLenum mode = GL_TRIANGLES, GLenum index_type = GL_UNSIGNED_INT) {
+            bind();
+            multi_draw_elements_indirect(commands->get_buffer(), commands->get_region_offset() + sizeof(DrawElementsIndirectCommand) * submitted,
+                                         command_count - submitted, mode, index_type);
+            submitted = command_count;
+        }
+
+        void next_frame() {
+            data->next_frame();
+            commands->next_frame();
+            count = 0;
+            command_count = 0;
+            submitted = 0;
+        }
+
+        [[nodiscard]] std::uint32_t get_count() const noexcept { return count; }
+        [[nodiscard]] std::uint32_t get_capacity() const noexcept { return capacity; }
+        [[nodiscard]] unsigned int get_binding() const noexcept { return binding; }
+    };
+
+} // gc
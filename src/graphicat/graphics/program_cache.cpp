@@ -0,0 +1,249 @@
+#include "program_cache.hpp"
+#include "graphicat/util/hash.hpp"
+#include <cstring>
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define GC_PROGRAM_CACHE_MMAP 1
+#endif
+
+namespace gc {
+
+    static constexpr std::uint32_t archive_magic = 0x42504347; // "GCPB"
+    static constexpr std::uint32_t archive_version = 1;
+
+    struct ArchiveHeader {
+        std::uint32_t magic;
+        std::uint32_t version;
+    };
+
+    struct RecordHeader {
+        std::uint64_t key;
+        std::uint32_t format;
+        std::uint32_t size;
+    };
+
+    static std::size_t record_padding(std::uint32_t size) {
+        return (8 - size % 8) % 8;
+    }
+
+    ProgramCache::ProgramCache(std::filesystem::path path) : path(std::move(path)) {
+        open_archive();
+    }
+
+    ProgramCache::~ProgramCache() {
+#ifdef GC_PROGRAM_CACHE_MMAP
+        if (mapping) munmap(mapping, mapping_size);
+        if (fd != -1) close(fd);
+#endif
+    }
+
+    // Returns the size of the valid prefix; anything after it is a record that was cut off mid-write.
+    std::size_t ProgramCache::build_index(const std::byte *data, std::size_t size) {
+        ArchiveHeader header{};
+        if (size < sizeof(header)) return 0;
+
+        std::memcpy(&header, data, sizeof(header));
+        if (header.magic != archive_magic || header.version != archive_version) {
+            spdlog::warn("Program cache {} is not a compatible archive; starting over", path.string());
+            return 0;
+        }
+
+        std::size_t offset = sizeof(header);
+        while (offset + sizeof(RecordHeader) <= size) {
+            RecordHeader record{};
+            std::memcpy(&record, data + offset, sizeof(record));
+
+            std::size_t end = offset + sizeof(record) + record.size + record_padding(record.size);
+            if (end > size) break;
+
+            index[record.key] = {data + offset + sizeof(record), record.size, record.format};
+            offset = end;
+        }
+
+        return offset;
+    }
+
+#ifdef GC_PROGRAM_CACHE_MMAP
+    void ProgramCache::open_archive() {
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (fd == -1) {
+            spdlog::error("Failed to open program cache {}", path.string());
+            return;
+        }
+
+        struct stat st {};
+        fstat(fd, &st);
+        auto size = static_cast<std::size_t>(st.st_size);
+
+        if (size > 0) {
+            mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping == MAP_FAILED) {
+                mapping = nullptr;
+                size = 0;
+            } else {
+                mapping_size = size;
+            }
+        }
+
+        std::size_t valid = build_index(static_cast<const std::byte *>(mapping), size);
+        if (valid == size && size > 0) return;
+
+        // Drop a torn trailing record (or an incompatible archive) so later appends stay parseable.
+        if (valid < sizeof(ArchiveHeader)) {
+            index.clear();
+            valid = 0;
+        }
+        if (mapping) {
+            munmap(mapping, mapping_size);
+            mapping = nullptr;
+            mapping_size = 0;
+        }
+        if (ftruncate(fd, static_cast<off_t>(valid)) != 0) {
+            spdlog::error("Failed to truncate program cache {}", path.string());
+        }
+
+        if (valid == 0) {
+            ArchiveHeader header{archive_magic, archive_version};
+            if (write(fd, &header, sizeof(header)) != sizeof(header)) spdlog::error("Failed to write program cache {}", path.string());
+            return;
+        }
+
+        index.clear();
+        mapping = mmap(nullptr, valid, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED) {
+            mapping = nullptr;
+            return;
+        }
+        mapping_size = valid;
+        build_index(static_cast<const std::byte *>(mapping), valid);
+    }
+
+    void ProgramCache::append(std::uint64_t key, unsigned int format, const std::byte *data, std::uint32_t size) {
+        if (fd == -1) return;
+
+        RecordHeader record{key, format, size};
+        const std::byte padding[8]{};
+
+        bool ok = write(fd, &record, sizeof(record)) == sizeof(record);
+        ok = ok && write(fd, data, size) == static_cast<ssize_t>(size);
+        ok = ok && write(fd, padding, record_padding(size)) == static_cast<ssize_t>(record_padding(size));
+        if (!ok) spdlog::error("Failed to append to program cache {}", path.string());
+    }
+#else
+    void ProgramCache::open_archive() {
+        std::ifstream f(path, std::ios::binary | std::ios::ate);
+        if (f) {
+            fallback.resize(static_cast<std::size_t>(f.tellg()));
+            f.seekg(0);
+            f.read(reinterpret_cast<char *>(fallback.data()), static_cast<std::streamsize>(fallback.size()));
+        }
+
+        std::size_t valid = build_index(fallback.data(), fallback.size());
+        if (valid == fallback.size() && valid > 0) return;
+
+        if (valid < sizeof(ArchiveHeader)) {
+            index.clear();
+            valid = 0;
+        }
+
+        // Rewrite the valid prefix; the index still points into `fallback`, which is left untouched.
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (valid == 0) {
+            ArchiveHeader header{archive_magic, archive_version};
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        } else {
+            out.write(reinterpret_cast<const char *>(fallback.data()), static_cast<std::streamsize>(valid));
+        }
+    }
+
+    void ProgramCache::append(std::uint64_t key, unsigned int format, const std::byte *data, std::uint32_t size) {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+
+        RecordHeader record{key, format, size};
+        const char padding[8]{};
+
+        out.write(reinterpret_cast<const char *>(&record), sizeof(record));
+        out.write(reinterpret_cast<const char *>(data), size);
+        out.write(padding, static_cast<std::streamsize>(record_padding(size)));
+        if (!out) spdlog::error("Failed to append to program cache {}", path.string());
+    }
+#endif
+
+    // Binaries are only valid for the driver that produced them, so the driver strings are folded into every key.
+    std::uint64_t ProgramCache::full_key(std::uint64_t key) {
+        if (!driver_queried) {
+            driver_queried = true;
+
+            int formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            supported = formats > 0;
+
+            for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+                const auto *str = reinterpret_cast<const char *>(glGetString(name));
+                driver = hash_string(str ? str : "", driver);
+            }
+        }
+
+        return hash_combine(driver, key);
+    }
+
+    unsigned int ProgramCache::load(std::uint64_t key, bool separable) {
+        std::lock_guard lock(mutex);
+        std::uint64_t k = full_key(key);
+        if (!supported) return 0;
+
+        auto it = index.find(k);
+        if (it == index.end()) {
+            stats.misses++;
+            return 0;
+        }
+
+        unsigned int program = glCreateProgram();
+        if (separable) glProgramParameteri(program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+        glProgramBinary(program, it->second.format, it->second.data, static_cast<GLsizei>(it->second.size));
+
+        int status;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (status != GL_TRUE) {
+            // Usually a driver update; the fresh binary gets appended after the fallback compile.
+            glDeleteProgram(program);
+            index.erase(it);
+            stats.rejected++;
+            return 0;
+        }
+
+        stats.hits++;
+        return program;
+    }
+
+    void ProgramCache::store(std::uint64_t key, unsigned int program) {
+        std::lock_guard lock(mutex);
+        std::uint64_t k = full_key(key);
+        if (!supported) return;
+
+        int length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+
+        auto data = std::make_unique<std::byte[]>(length);
+        GLenum format;
+        glGetProgramBinary(program, length, &length, &format, data.get());
+
+        append(k, format, data.get(), static_cast<std::uint32_t>(length));
+        index[k] = {data.get(), static_cast<std::uint32_t>(length), format};
+        appended.push_back(std::move(data));
+        stats.stored++;
+    }
+
+    ProgramCacheStats ProgramCache::get_stats() const {
+        std::lock_guard lock(mutex);
+        return stats;
+    }
+
+} // gc
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace gc {
+
+    struct ProgramCacheStats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t rejected = 0;
+        std::uint64_t stored = 0;
+    };
+
+    // Linked program binaries keyed by source hash and driver, kept in a single append-only archive that is mapped on open.
+    // Records are [key, format, size, data] back to back after a small header, so the index is rebuilt by hopping over record
+    // headers without touching the binaries themselves.
+    class ProgramCache {
+        struct Entry {
+            const std::byte *data;
+            std::uint32_t size;
+            unsigned int format;
+        };
+
+        std::filesystem::path path;
+        int fd = -1;
+        void *mapping = nullptr;
+        std::size_t mapping_size = 0;
+
+        std::unordered_map<std::uint64_t, Entry> index;
+        std::vector<std::unique_ptr<std::byte[]>> appended;
+        std::vector<std::byte> fallback;
+
+        std::uint64_t driver = 0;
+        bool driver_queried = false;
+        bool supported = true;
+
+        ProgramCacheStats stats;
+
+        // Programs can be built on the shader compiler's thread as well as the main one.
+        mutable std::mutex mutex;
+
+        void open_archive();
+        std::size_t build_index(const std::byte *data, std::size_t size);
+        void append(std::uint64_t key, unsigned int format, const std::byte *data, std::uint32_t size);
+        std::uint64_t full_key(std::uint64_t key);
+
+    public:
+        explicit ProgramCache(std::filesystem::path path);
+        ~ProgramCache();
+
+        ProgramCache(const ProgramCache &) = delete;
+        ProgramCache &operator=(const ProgramCache &) = delete;
+
+        // Returns a linked program, or 0 if there is no entry or the driver rejected it. Must be called with a current context.
+        unsigned int load(std::uint64_t key, bool separable = false);
+        // Records the binary of a linked program. It should have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+        void store(std::uint64_t key, unsigned int program);
+
+        [[nodiscard]] ProgramCacheStats get_stats() const;
+    };
+
+} // gc
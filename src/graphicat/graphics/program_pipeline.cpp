@@ -0,0 +1,138 @@
+#include "program_pipeline.hpp"
+#include "shader_compiler.hpp"
+#include "state_cache.hpp"
+#include <algorithm>
+#include <map>
+#include <spdlog/spdlog.h>
+
+namespace gc {
+
+    // Same order as the stage slots in the pipeline cache key.
+    static constexpr std::array<ShaderType, 6> stage_types = {
+        ShaderType::Vertex, ShaderType::TessControl, ShaderType::TessEval, ShaderType::Geometry, ShaderType::Fragment, ShaderType::Compute,
+    };
+
+    static std::size_t stage_slot(ShaderType type) {
+        return std::find(stage_types.begin(), stage_types.end(), type) - stage_types.begin();
+    }
+
+    static GLbitfield stage_bit(ShaderType type) {
+        switch (type) {
+        case ShaderType::Vertex: return GL_VERTEX_SHADER_BIT;
+        case ShaderType::Fragment: return GL_FRAGMENT_SHADER_BIT;
+        case ShaderType::Geometry: return GL_GEOMETRY_SHADER_BIT;
+        case ShaderType::TessControl: return GL_TESS_CONTROL_SHADER_BIT;
+        case ShaderType::TessEval: return GL_TESS_EVALUATION_SHADER_BIT;
+        case ShaderType::Compute: return GL_COMPUTE_SHADER_BIT;
+        }
+        return 0;
+    }
+
+    // Equivalent to glCreateShaderProgramv, but goes through the regular build path so stages hit the program binary cache.
+    static unsigned int create_stage(const ShaderSource& source) {
+        detail::ProgramBuild build = detail::submit_program({source}, true);
+        return detail::finish_program(build);
+    }
+
+    ShaderStage::ShaderStage(unsigned int handle, ShaderType type) : Shader(handle, true), type(type) {
+    }
+
+    std::unique_ptr<ShaderStage> ShaderStage::create(const ShaderSource &source) {
+        return std::unique_ptr<ShaderStage>(new ShaderStage(create_stage(source), source.type));
+    }
+
+    std::unique_ptr<ShaderStage> ShaderStage::load(ShaderType type, const std::filesystem::path &path) {
+        return create(detail::read_sources({{type, path}})[0]);
+    }
+
+    std::shared_ptr<ShaderStage> ShaderStage::create_shared(const ShaderSource &source) {
+        return std::shared_ptr<ShaderStage>(new ShaderStage(create_stage(source), source.type));
+    }
+
+    std::shared_ptr<ShaderStage> ShaderStage::load_shared(ShaderType type, const std::filesystem::path &path) {
+        return create_shared(detail::read_sources({{type, path}})[0]);
+    }
+
+    ShaderType ShaderStage::get_type() const noexcept {
+        return type;
+    }
+
+    static std::map<std::array<unsigned int, 6>, std::weak_ptr<ProgramPipeline>> s_pipelines;
+    // s_pipelines is swept for expired entries whenever it grows to this size.
+    static std::size_t s_prune_at = 64;
+
+    ProgramPipeline::ProgramPipeline(unsigned int handle, std::vector<std::shared_ptr<ShaderStage>> stages)
+        : handle(handle), stages(std::move(stages)) {
+    }
+
+    ProgramPipeline::~ProgramPipeline() {
+        if (StateCache *cache = StateCache::get()) cache->forget_program_pipeline(handle);
+        glDeleteProgramPipelines(1, &handle);
+    }
+
+    std::shared_ptr<ProgramPipeline> ProgramPipeline::get(const std::vector<std::shared_ptr<ShaderStage>> &stages) {
+        std::array<unsigned int, 6> key{};
+        for (const auto& stage : stages) {
+            key[stage_slot(stage->get_type())] = stage->get_handle();
+        }
+
+        // Pipelines nobody holds any more would otherwise pile up, one entry per combination ever built. Sweeping only when the
+        // map has doubled keeps lookups from paying for it.
+        if (s_pipelines.size() >= s_prune_at) {
+            std::erase_if(s_pipelines, [](const auto &entry) { return entry.second.expired(); });
+            s_prune_at = std::max<std::size_t>(64, s_pipelines.size() * 2);
+        }
+
+        auto &cached = s_pipelines[key];
+        if (auto pipeline = cached.lock()) return pipeline;
+
+        unsigned int h;
+        glCreateProgramPipelines(1, &h);
+        for (const auto& stage : stages) {
+            glUseProgramStages(h, stage_bit(stage->get_type()), stage->get_handle());
+        }
+
+        auto pipeline = std::shared_ptr<ProgramPipeline>(new ProgramPipeline(h, stages));
+        cached = pipeline;
+        return pipeline;
+    }
+
+    void ProgramPipeline::validate() const {
+        glValidateProgramPipeline(handle);
+        int valid;
+        glGetProgramPipelineiv(handle, GL_VALIDATE_STATUS, &valid);
+        if (valid != GL_TRUE) {
+            int log_length;
+            glGetProgramPipelineiv(handle, GL_INFO_LOG_LENGTH, &log_length);
+            std::string buf(std::max(log_length, 1), '\0');
+            glGetProgramPipelineInfoLog(handle, log_length, nullptr, buf.data());
+            spdlog::warn("Program pipeline did not validate: {}", buf);
+        }
+    }
+
+    void ProgramPipeline::bind() const {
+        for (const auto& stage : stages) stage->sync_block_reads();
+
+        // A pipeline only applies while no program is in use.
+        use_program(0);
+        bind_program_pipeline(handle);
+
+        // Validation depends on the state it is drawn with, so it only means something once the pipeline is bound for a draw.
+        if (!validated) {
+            validate();
+            validated = true;
+        }
+    }
+
+    unsigned int ProgramPipeline::get_handle() const noexcept {
+        return handle;
+    }
+
+    std::shared_ptr<ShaderStage> ProgramPipeline::get_stage(ShaderType type) const {
+        for (const auto& stage : stages) {
+            if (stage->get_type() == type) return stage;
+        }
+        return nullptr;
+    }
+
+} // gc
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/shader.hpp"
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace gc {
+
+    // A single-stage separable program. Uniforms are set on it like on any other Shader; ProgramPipeline combines stages without
+    // relinking, so N vertex and M fragment variants cost N + M links instead of N * M.
+    class ShaderStage : public Shader {
+        ShaderType type;
+
+        ShaderStage(unsigned int handle, ShaderType type);
+
+    public:
+        static std::unique_ptr<ShaderStage> create(const ShaderSource& source);
+        static std::unique_ptr<ShaderStage> load(ShaderType type, const std::filesystem::path& path);
+
+        static std::shared_ptr<ShaderStage> create_shared(const ShaderSource& source);
+        static std::shared_ptr<ShaderStage> load_shared(ShaderType type, const std::filesystem::path& path);
+
+        [[nodiscard]] ShaderType get_type() const noexcept;
+    };
+
+    class ProgramPipeline {
+        unsigned int handle;
+        std::vector<std::shared_ptr<ShaderStage>> stages;
+        mutable bool validated = false;
+
+        ProgramPipeline(unsigned int handle, std::vector<std::shared_ptr<ShaderStage>> stages);
+
+        void validate() const;
+
+    public:
+        virtual ~ProgramPipeline();
+
+        // Pipelines are cached by their combination of stages (in any order), so asking for the same set twice returns the same
+        // pipeline for as long as someone holds on to it.
+        static std::shared_ptr<ProgramPipeline> get(const std::vector<std::shared_ptr<ShaderStage>>& stages);
+
+        // Also unbinds any program bound with Shader::bind, which would otherwise take precedence over the pipeline, and issues
+        // the barriers the stages' blocks need, like Shader::bind. The first bind validates the pipeline and logs any problem.
+        void bind() const;
+
+        [[nodiscard]] unsigned int get_handle() const noexcept;
+        [[nodiscard]] std::shared_ptr<ShaderStage> get_stage(ShaderType type) const;
+    };
+
+} // gc
@@ -0,0 +1,259 @@
+#include "render_queue.hpp"
+#include "graphicat/util/job_system.hpp"
+#include <algorithm>
+#include <utility>
+#include <spdlog/spdlog.h>
+
+namespace gc {
+
+    static constexpr unsigned int key_bits = 64;
+
+    static std::uint64_t mask(unsigned int bits) {
+        return bits >= key_bits ? ~std::uint64_t(0) : (std::uint64_t(1) << bits) - 1;
+    }
+
+    static std::size_t index(SortField field) {
+        return static_cast<std::size_t>(field);
+    }
+
+    SortKeyLayout::SortKeyLayout(std::initializer_list<SortFieldBits> fields) {
+        std::vector<SortField> order;
+        std::array<bool, field_count> seen{};
+        for (const SortFieldBits &field : fields) {
+            if (seen[index(field.field)]) {
+                spdlog::error("Sort key layout lists field {} twice; ignoring the second", index(field.field));
+                continue;
+            }
+            seen[index(field.field)] = true;
+
+            unsigned int bits = std::min(field.bits, key_bits - used_bits);
+            if (bits < field.bits) spdlog::error("Sort key layout needs more than {} bits; field {} gets {} of its {}", key_bits,
+                                                 index(field.field), bits, field.bits);
+            if (bits == 0) continue;
+
+            widths[index(field.field)] = static_cast<std::uint8_t>(bits);
+            used_bits += bits;
+            order.push_back(field.field);
+        }
+
+        // Fields fill the key from the top, so unused bits are the low ones and never vary.
+        auto assign = [&](std::array<std::uint8_t, field_count> &shifts) {
+            unsigned int shift = key_bits;
+            for (SortField field : order) {
+                shift -= widths[index(field)];
+                shifts[index(field)] = static_cast<std::uint8_t>(shift);
+            }
+        };
+        assign(opaque_shifts);
+
+        auto translucency = std::find(order.begin(), order.end(), SortField::Translucency);
+        auto depth = std::find(order.begin(), order.end(), SortField::Depth);
+        if (translucency != order.end() && depth != order.end() && depth > translucency)
+            std::rotate(translucency + 1, depth, depth + 1);
+        assign(translucent_shifts);
+    }
+
+    SortKeyLayout SortKeyLayout::standard() {
+        return {
+            {SortField::Layer, 8},
+            {SortField::Translucency, 1},
+            {SortField::Program, 12},
+            {SortField::Material, 16},
+            {SortField::Depth, 27},
+        };
+    }
+
+    std::uint64_t SortKeyLayout::quantize_depth(float depth) const noexcept {
+        // Through double, since a float can't hold every step of a depth field wider than 24 bits.
+        std::uint64_t steps = mask(get_bits(SortField::Depth));
+        return static_cast<std::uint64_t>(std::clamp(static_cast<double>(depth), 0.0, 1.0) * static_cast<double>(steps));
+    }
+
+    std::uint64_t SortKeyLayout::encode(const SortKeyFields &fields) const noexcept {
+        const auto &shifts = fields.translucent ? translucent_shifts : opaque_shifts;
+        std::uint64_t depth = quantize_depth(fields.depth);
+        // Far first for translucent draws.
+        if (fields.translucent) depth = mask(get_bits(SortField::Depth)) - depth;
+
+        std::array<std::uint64_t, field_count> values{};
+        values[index(SortField::Layer)] = fields.layer;
+        values[index(SortField::Translucency)] = fields.translucent ? 1 : 0;
+        values[index(SortField::Program)] = fields.program;
+        values[index(SortField::Material)] = fields.material;
+        values[index(SortField::Depth)] = depth;
+
+        std::uint64_t key = 0;
+        for (std::size_t i = 0; i < field_count; i++) {
+            if (widths[i] != 0) key |= (values[i] & mask(widths[i])) << shifts[i];
+        }
+        return key;
+    }
+
+    unsigned int SortKeyLayout::get_bits(SortField field) const noexcept {
+        return widths[index(field)];
+    }
+
+    unsigned int SortKeyLayout::get_used_bits() const noexcept {
+        return used_bits;
+    }
+
+    // A byte of the key per pass: 256 buckets keep each histogram in L1 and each scatter's write streams in few enough cache lines.
+    static constexpr unsigned int digit_bits = 8;
+    static constexpr unsigned int digit_count = key_bits / digit_bits;
+    static constexpr std::size_t bucket_count = std::size_t(1) << digit_bits;
+
+    using Histogram = std::array<std::size_t, bucket_count>;
+    using Histograms = std::array<Histogram, digit_count>;
+    // RenderQueue keeps these as members, under the same types.
+    static_assert(bucket_count == 256 && digit_count == 8);
+
+    static std::size_t digit(std::uint64_t key, unsigned int d) {
+        return static_cast<std::size_t>(key >> (d * digit_bits)) & (bucket_count - 1);
+    }
+
+    static void count_digits(const RenderQueueItem *begin, const RenderQueueItem *end, Histograms &histograms) {
+        for (const RenderQueueItem *item = begin; item != end; item++) {
+            for (unsigned int d = 0; d < digit_count; d++) histograms[d][digit(item->key, d)]++;
+        }
+    }
+
+    // Digits every key has the same value in, which a pass would leave in place.
+    static std::array<bool, digit_count> active_digits(const std::vector<Histograms> &counts, std::uint64_t first_key, std::size_t total) {
+        std::array<bool, digit_count> active{};
+        for (unsigned int d = 0; d < digit_count; d++) {
+            std::size_t same = 0;
+            for (const Histograms &histograms : counts) same += histograms[d][digit(first_key, d)];
+            active[d] = same != total;
+        }
+        return active;
+    }
+
+    RenderQueue::RenderQueue(const SortKeyLayout &layout) : layout(layout) {
+    }
+
+    void RenderQueue::push(const SortKeyFields &fields, std::uint32_t payload) {
+        push_key(layout.encode(fields), payload);
+    }
+
+    void RenderQueue::push_key(std::uint64_t key, std::uint32_t payload) {
+        if (!items.empty() && key < items.back().key) sorted = false;
+        items.push_back({key, payload});
+    }
+
+    void RenderQueue::sort() {
+        if (sorted) return;
+
+        std::size_t count = items.size();
+        scratch.resize(count);
+
+        counts.assign(1, Histograms{});
+        count_digits(items.data(), items.data() + count, counts[0]);
+        auto active = active_digits(counts, items[0].key, count);
+
+        RenderQueueItem *from = items.data();
+        RenderQueueItem *to = scratch.data();
+        for (unsigned int d = 0; d < digit_count; d++) {
+            if (!active[d]) continue;
+
+            Histogram offsets;
+            std::size_t offset = 0;
+            for (std::size_t b = 0; b < bucket_count; b++) {
+                offsets[b] = offset;
+                offset += counts[0][d][b];
+            }
+            for (std::size_t i = 0; i < count; i++) to[offsets[digit(from[i].key, d)]++] = from[i];
+            std::swap(from, to);
+        }
+
+        if (from != items.data()) items.swap(scratch);
+        sorted = true;
+    }
+
+    void RenderQueue::sort_parallel(JobSystem *jobs) {
+        if (sorted) return;
+
+        if (!jobs) jobs = JobSystem::get();
+        std::size_t count = items.size();
+        std::size_t slices = jobs ? std::min(jobs->get_worker_count() + 1, count / (parallel_threshold / 4) + 1) : 1;
+        if (count < parallel_threshold || slices < 2) {
+            sort();
+            return;
+        }
+
+        scratch.resize(count);
+        counts.assign(slices, Histograms{});
+        pass_counts.resize(slices);
+        auto slice_begin = [&](std::size_t slice) { return count * slice / slices; };
+
+        jobs->parallel_for(0, slices, 1, [&](std::size_t first, std::size_t last) {
+            for (std::size_t s = first; s < last; s++)
+                count_digits(items.data() + slice_begin(s), items.data() + slice_begin(s + 1), counts[s]);
+        });
+        auto active = active_digits(counts, items[0].key, count);
+
+        // Each slice of the source array is counted and scattered by one job per pass. Within a bucket, slice s's items go after
+        // those of the slices before it, which keeps the scatter stable.
+        RenderQueueItem *from = items.data();
+        RenderQueueItem *to = scratch.data();
+        for (unsigned int d = 0; d < digit_count; d++) {
+            if (!active[d]) continue;
+
+            // The slices hold different items after every pass, so their histograms have to be taken again.
+            jobs->parallel_for(0, slices, 1, [&](std::size_t first, std::size_t last) {
+                for (std::size_t s = first; s < last; s++) {
+                    Histogram &local = pass_counts[s];
+                    local.fill(0);
+                    for (std::size_t i = slice_begin(s); i < slice_begin(s + 1); i++) local[digit(from[i].key, d)]++;
+                }
+            });
+
+            // Turn the counts into each slice's starting offset per bucket, in place.
+            std::size_t offset = 0;
+            for (std::size_t b = 0; b < bucket_count; b++) {
+                for (std::size_t s = 0; s < slices; s++) offset += std::exchange(pass_counts[s][b], offset);
+            }
+
+            jobs->parallel_for(0, slices, 1, [&](std::size_t first, std::size_t last) {
+                for (std::size_t s = first; s < last; s++) {
+                    Histogram &offsets = pass_counts[s];
+                    for (std::size_t i = slice_begin(s); i < slice_begin(s + 1); i++) to[offsets[digit(from[i].key, d)]++] = from[i];
+                }
+            });
+            std::swap(from, to);
+        }
+
+        if (from != items.data()) items.swap(scratch);
+        sorted = true;
+    }
+
+    void RenderQueue::clear() noexcept {
+        items.clear();
+        sorted = true;
+    }
+
+    void RenderQueue::reserve(std::size_t count) {
+        items.reserve(count);
+        scratch.reserve(count);
+    }
+
+    std::span<const RenderQueueItem> RenderQueue::get_items() const noexcept {
+        return items;
+    }
+
+    std::size_t RenderQueue::size() const noexcept {
+        return items.size();
+    }
+
+    bool RenderQueue::empty() const noexcept {
+        return items.empty();
+    }
+
+    bool RenderQueue::is_sorted() const noexcept {
+        return sorted;
+    }
+
+    const SortKeyLayout &RenderQueue::get_layout() const noexcept {
+        return layout;
+    }
+
+} // gc
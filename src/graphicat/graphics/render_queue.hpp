@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+namespace gc {
+
+    class JobSystem;
+
+    enum class SortField : std::uint8_t {
+        Layer,
+        Translucency,
+        Program,
+        Material,
+        Depth,
+    };
+
+    struct SortFieldBits {
+        SortField field;
+        unsigned int bits;
+    };
+
+    // What a draw is sorted on, before it is packed by a SortKeyLayout.
+    struct SortKeyFields {
+        std::uint32_t layer = 0;
+        bool translucent = false;
+        std::uint32_t program = 0;
+        std::uint32_t material = 0;
+        // View depth normalized to [0, 1].
+        float depth = 0.0f;
+    };
+
+    // Where each SortField goes in a 64-bit key. Fields are given most significant first; a field that is left out takes no bits and
+    // never affects the order. Values are truncated to their field, so a program or material collision only costs a rebind.
+    //
+    // Opaque draws come out front to back. Translucent ones come out back to front: their depth is inverted and, if the layout has a
+    // Translucency field, moved up to right below it, with the fields that were between them shifted down to make room.
+    class SortKeyLayout {
+        static constexpr std::size_t field_count = 5;
+
+        std::array<std::uint8_t, field_count> widths{};
+        std::array<std::uint8_t, field_count> opaque_shifts{};
+        std::array<std::uint8_t, field_count> translucent_shifts{};
+        unsigned int used_bits = 0;
+
+    public:
+        // Bits past the 64th are dropped with an error.
+        SortKeyLayout(std::initializer_list<SortFieldBits> fields);
+
+        // Layer (8 bits), translucency (1), program (12), material (16), depth (27).
+        static SortKeyLayout standard();
+
+        [[nodiscard]] std::uint64_t encode(const SortKeyFields &fields) const noexcept;
+        [[nodiscard]] std::uint64_t quantize_depth(float depth) const noexcept;
+
+        [[nodiscard]] unsigned int get_bits(SortField field) const noexcept;
+        [[nodiscard]] unsigned int get_used_bits() const noexcept;
+    };
+
+    struct RenderQueueItem {
+        std::uint64_t key;
+        // Whatever identifies the draw to the caller, usually an index into its own array of draws.
+        std::uint32_t payload;
+    };
+
+    // Draw items sorted by 64-bit key with an LSD radix sort: one histogram pass over the keys, then a stable scatter per byte of
+    // the key that isn't the same in every item, so a layout using 40 bits costs 5 passes, not 8. That is linear in the item count
+    // and has no comparator calls, which is what makes it several times faster than std::sort from a few thousand items up. Equal
+    // keys keep the order they were pushed in.
+    //
+    //     gc::RenderQueue queue;
+    //     for (std::uint32_t i = 0; i < draws.size(); i++) queue.push({.layer = 1, .program = draws[i].program, .depth = d}, i);
+    //     queue.sort();
+    //     for (const gc::RenderQueueItem &item : queue.get_items()) submit(draws[item.payload]);
+    //     queue.clear();
+    //
+    // The item and scratch arrays keep their memory across clear(), as do the sort's histograms, so a steady frame allocates
+    // nothing.
+    class RenderQueue {
+        // The radix sort's bucket counts: one histogram per byte of the key.
+        using Histogram = std::array<std::size_t, 256>;
+        using Histograms = std::array<Histogram, 8>;
+
+        SortKeyLayout layout;
+        std::vector<RenderQueueItem> items;
+        std::vector<RenderQueueItem> scratch;
+        // One set per slice sorted in parallel, and the per-pass counts of each slice.
+        std::vector<Histograms> counts;
+        std::vector<Histogram> pass_counts;
+        bool sorted = true;
+
+    public:
+        // Below this, sort_parallel() sorts on the calling thread; handing out jobs costs more than it saves.
+        static constexpr std::size_t parallel_threshold = 64 * 1024;
+
+        explicit RenderQueue(const SortKeyLayout &layout = SortKeyLayout::standard());
+
+        void push(const SortKeyFields &fields, std::uint32_t payload);
+        // For keys built elsewhere, e.g. with SortKey.
+        void push_key(std::uint64_t key, std::uint32_t payload);
+
+        void sort();
+        // Splits each pass into one job per worker (plus the caller) on `jobs`, or GlobalState's JobSystem if it is nullptr.
+        // Sorts on the calling thread if there is neither.
+        void sort_parallel(JobSystem *jobs = nullptr);
+
+        // Forgets the items, keeping the memory.
+        void clear() noexcept;
+        void reserve(std::size_t count);
+
+        [[nodiscard]] std::span<const RenderQueueItem> get_items() const noexcept;
+        [[nodiscard]] std::size_t size() const noexcept;
+        [[nodiscard]] bool empty() const noexcept;
+        [[nodiscard]] bool is_sorted() const noexcept;
+        [[nodiscard]] const SortKeyLayout &get_layout() const noexcept;
+    };
+
+} // gc
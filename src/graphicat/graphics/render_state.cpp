@@ -0,0 +1,222 @@
+#include "render_state.hpp"
+#include "state_cache.hpp"
+#include "graphicat/util/hash.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace gc {
+
+    BlendState BlendState::alpha() {
+        BlendState state;
+        state.enabled = true;
+        state.src_color = GL_SRC_ALPHA;
+        state.dst_color = GL_ONE_MINUS_SRC_ALPHA;
+        state.src_alpha = GL_ONE;
+        state.dst_alpha = GL_ONE_MINUS_SRC_ALPHA;
+        return state;
+    }
+
+    BlendState BlendState::additive() {
+        BlendState state;
+        state.enabled = true;
+        state.src_color = GL_ONE;
+        state.dst_color = GL_ONE;
+        state.src_alpha = GL_ONE;
+        state.dst_alpha = GL_ONE;
+        return state;
+    }
+
+    BlendState BlendState::premultiplied() {
+        BlendState state;
+        state.enabled = true;
+        state.src_color = GL_ONE;
+        state.dst_color = GL_ONE_MINUS_SRC_ALPHA;
+        state.src_alpha = GL_ONE;
+        state.dst_alpha = GL_ONE_MINUS_SRC_ALPHA;
+        return state;
+    }
+
+    RenderState::RenderState(const RenderStateDesc &desc, std::uint64_t hash, std::uint32_t id) : desc(desc), hash(hash), id(id) {
+    }
+
+    static std::uint64_t mix(std::uint64_t h, std::uint64_t value) {
+        return hash_combine(h, value);
+    }
+
+    static std::uint64_t mix(std::uint64_t h, float value) {
+        return hash_combine(h, std::bit_cast<std::uint32_t>(value));
+    }
+
+    static std::uint64_t mix_face(std::uint64_t h, const StencilFace &face) {
+        h = mix(h, std::uint64_t(face.func));
+        h = mix(h, std::uint64_t(static_cast<std::uint32_t>(face.reference)));
+        h = mix(h, std::uint64_t(face.read_mask));
+        h = mix(h, std::uint64_t(face.write_mask));
+        h = mix(h, std::uint64_t(face.fail));
+        h = mix(h, std::uint64_t(face.depth_fail));
+        return mix(h, std::uint64_t(face.pass));
+    }
+
+    std::uint64_t RenderState::hash_desc(const RenderStateDesc &desc) {
+        // Field by field rather than over the bytes, since the structs have padding.
+        std::uint64_t h = hash_seed;
+
+        const BlendState &b = desc.blend;
+        h = mix(h, std::uint64_t(b.enabled));
+        h = mix(h, std::uint64_t(b.src_color));
+        h = mix(h, std::uint64_t(b.dst_color));
+        h = mix(h, std::uint64_t(b.src_alpha));
+        h = mix(h, std::uint64_t(b.dst_alpha));
+        h = mix(h, std::uint64_t(b.color_equation));
+        h = mix(h, std::uint64_t(b.alpha_equation));
+        for (int i = 0; i < 4; i++) h = mix(h, b.constant[i]);
+
+        h = mix(h, std::uint64_t(desc.depth.test));
+        h = mix(h, std::uint64_t(desc.depth.write));
+        h = mix(h, std::uint64_t(desc.depth.func));
+
+        h = mix(h, std::uint64_t(desc.stencil.test));
+        h = mix_face(h, desc.stencil.front);
+        h = mix_face(h, desc.stencil.back);
+
+        const RasterState &r = desc.raster;
+        h = mix(h, std::uint64_t(r.cull));
+        h = mix(h, std::uint64_t(r.cull_face));
+        h = mix(h, std::uint64_t(r.front_face));
+        h = mix(h, std::uint64_t(r.polygon_mode));
+        h = mix(h, std::uint64_t(r.polygon_offset));
+        h = mix(h, r.offset_factor);
+        h = mix(h, r.offset_units);
+
+        for (bool channel : desc.color_mask) h = mix(h, std::uint64_t(channel));
+        return h;
+    }
+
+    std::shared_ptr<const RenderState> RenderState::get(const RenderStateDesc &desc) {
+        std::uint64_t hash = hash_desc(desc);
+
+        std::lock_guard lock(s_mutex);
+
+        // States that vary every frame (blend constants, polygon offsets) would otherwise leave an expired entry each. Sweeping
+        // only when the map has doubled keeps get() amortized constant.
+        if (s_states.size() >= s_prune_at) {
+            std::erase_if(s_states, [](const auto &entry) { return entry.second.expired(); });
+            s_prune_at = std::max<std::size_t>(64, s_states.size() * 2);
+        }
+
+        auto &entry = s_states[hash];
+        if (auto state = entry.lock()) {
+            if (state->desc == desc) return state;
+
+            // Two descriptions with the same hash. Hand out an uninterned state; it still works, it just isn't shared.
+            return std::shared_ptr<const RenderState>(new RenderState(desc, hash, s_next_id++));
+        }
+
+        auto state = std::shared_ptr<const RenderState>(new RenderState(desc, hash, s_next_id++));
+        entry = state;
+        return state;
+    }
+
+    std::uint32_t RenderState::diff(const RenderState &from, const RenderState &to) {
+        if (&from == &to) return 0;
+
+        const RenderStateDesc &a = from.desc, &b = to.desc;
+        std::uint32_t fields = 0;
+
+        if (a.blend.enabled != b.blend.enabled) fields |= BlendEnable;
+        if (a.blend.src_color != b.blend.src_color || a.blend.dst_color != b.blend.dst_color ||
+            a.blend.src_alpha != b.blend.src_alpha || a.blend.dst_alpha != b.blend.dst_alpha) fields |= BlendFunc;
+        if (a.blend.color_equation != b.blend.color_equation || a.blend.alpha_equation != b.blend.alpha_equation) fields |= BlendEquation;
+        if (a.blend.constant != b.blend.constant) fields |= BlendColor;
+
+        if (a.depth.test != b.depth.test) fields |= DepthTest;
+        if (a.depth.write != b.depth.write) fields |= DepthWrite;
+        if (a.depth.func != b.depth.func) fields |= DepthFunc;
+
+        const StencilFace &af = a.stencil.front, &ab = a.stencil.back, &bf = b.stencil.front, &bb = b.stencil.back;
+        if (a.stencil.test != b.stencil.test) fields |= StencilTest;
+        if (af.func != bf.func || af.reference != bf.reference || af.read_mask != bf.read_mask ||
+            ab.func != bb.func || ab.reference != bb.reference || ab.read_mask != bb.read_mask) fields |= StencilFunc;
+        if (af.fail != bf.fail || af.depth_fail != bf.depth_fail || af.pass != bf.pass ||
+            ab.fail != bb.fail || ab.depth_fail != bb.depth_fail || ab.pass != bb.pass) fields |= StencilOp;
+        if (af.write_mask != bf.write_mask || ab.write_mask != bb.write_mask) fields |= StencilWriteMask;
+
+        if (a.raster.cull != b.raster.cull) fields |= CullEnable;
+        if (a.raster.cull_face != b.raster.cull_face) fields |= CullFace;
+        if (a.raster.front_face != b.raster.front_face) fields |= FrontFace;
+        if (a.raster.polygon_mode != b.raster.polygon_mode) fields |= PolygonMode;
+        if (a.raster.polygon_offset != b.raster.polygon_offset) fields |= PolygonOffsetEnable;
+        if (a.raster.offset_factor != b.raster.offset_factor || a.raster.offset_units != b.raster.offset_units) fields |= PolygonOffset;
+
+        if (a.color_mask != b.color_mask) fields |= ColorMask;
+        return fields;
+    }
+
+    static void set_enabled(GLenum cap, bool enabled) {
+        if (enabled)
+            glEnable(cap);
+        else
+            glDisable(cap);
+    }
+
+    std::uint32_t RenderState::apply(const RenderState *previous) const {
+        std::uint32_t fields = previous ? diff(*previous, *this) : AllRenderStateFields;
+        if (!fields) return 0;
+
+        const StencilFace &front = desc.stencil.front, &back = desc.stencil.back;
+
+        if (fields & BlendEnable) set_enabled(GL_BLEND, desc.blend.enabled);
+        if (fields & BlendFunc) glBlendFuncSeparate(desc.blend.src_color, desc.blend.dst_color, desc.blend.src_alpha, desc.blend.dst_alpha);
+        if (fields & BlendEquation) glBlendEquationSeparate(desc.blend.color_equation, desc.blend.alpha_equation);
+        if (fields & BlendColor) glBlendColor(desc.blend.constant.r, desc.blend.constant.g, desc.blend.constant.b, desc.blend.constant.a);
+
+        if (fields & DepthTest) set_enabled(GL_DEPTH_TEST, desc.depth.test);
+        if (fields & DepthWrite) glDepthMask(desc.depth.write ? GL_TRUE : GL_FALSE);
+        if (fields & DepthFunc) glDepthFunc(desc.depth.func);
+
+        if (fields & StencilTest) set_enabled(GL_STENCIL_TEST, desc.stencil.test);
+        if (fields & StencilFunc) {
+            glStencilFuncSeparate(GL_FRONT, front.func, front.reference, front.read_mask);
+            glStencilFuncSeparate(GL_BACK, back.func, back.reference, back.read_mask);
+        }
+        if (fields & StencilOp) {
+            glStencilOpSeparate(GL_FRONT, front.fail, front.depth_fail, front.pass);
+            glStencilOpSeparate(GL_BACK, back.fail, back.depth_fail, back.pass);
+        }
+        if (fields & StencilWriteMask) {
+            glStencilMaskSeparate(GL_FRONT, front.write_mask);
+            glStencilMaskSeparate(GL_BACK, back.write_mask);
+        }
+
+        if (fields & CullEnable) set_enabled(GL_CULL_FACE, desc.raster.cull);
+        if (fields & CullFace) glCullFace(desc.raster.cull_face);
+        if (fields & FrontFace) glFrontFace(desc.raster.front_face);
+        if (fields & PolygonMode) glPolygonMode(GL_FRONT_AND_BACK, desc.raster.polygon_mode);
+        if (fields & PolygonOffsetEnable) set_enabled(GL_POLYGON_OFFSET_FILL, desc.raster.polygon_offset);
+        if (fields & PolygonOffset) glPolygonOffset(desc.raster.offset_factor, desc.raster.offset_units);
+
+        if (fields & ColorMask) glColorMask(desc.color_mask[0], desc.color_mask[1], desc.color_mask[2], desc.color_mask[3]);
+
+        return fields;
+    }
+
+    void RenderState::bind() const {
+        if (StateCache *cache = StateCache::get())
+            cache->bind_render_state(*this);
+        else
+            apply(nullptr);
+    }
+
+    const RenderStateDesc &RenderState::get_desc() const noexcept {
+        return desc;
+    }
+
+    std::uint64_t RenderState::get_hash() const noexcept {
+        return hash;
+    }
+
+    std::uint32_t RenderState::get_id() const noexcept {
+        return id;
+    }
+
+} // gc
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace gc {
+
+    // Defaults are GL's own, so RenderState::get({}) is the state of a fresh context.
+    struct BlendState {
+        bool enabled = false;
+        GLenum src_color = GL_ONE;
+        GLenum dst_color = GL_ZERO;
+        GLenum src_alpha = GL_ONE;
+        GLenum dst_alpha = GL_ZERO;
+        GLenum color_equation = GL_FUNC_ADD;
+        GLenum alpha_equation = GL_FUNC_ADD;
+        glm::vec4 constant = glm::vec4(0.0f);
+
+        bool operator==(const BlendState &) const = default;
+
+        // src * alpha + dst * (1 - alpha)
+        static BlendState alpha();
+        // src + dst
+        static BlendState additive();
+        // src + dst * (1 - alpha), for colors already multiplied by their alpha
+        static BlendState premultiplied();
+    };
+
+    struct DepthState {
+        bool test = false;
+        bool write = true;
+        GLenum func = GL_LESS;
+
+        bool operator==(const DepthState &) const = default;
+    };
+
+    struct StencilFace {
+        GLenum func = GL_ALWAYS;
+        int reference = 0;
+        unsigned int read_mask = ~0u;
+        unsigned int write_mask = ~0u;
+        GLenum fail = GL_KEEP;
+        GLenum depth_fail = GL_KEEP;
+        GLenum pass = GL_KEEP;
+
+        bool operator==(const StencilFace &) const = default;
+    };
+
+    struct StencilState {
+        bool test = false;
+        StencilFace front;
+        StencilFace back;
+
+        bool operator==(const StencilState &) const = default;
+    };
+
+    struct RasterState {
+        bool cull = false;
+        GLenum cull_face = GL_BACK;
+        GLenum front_face = GL_CCW;
+        GLenum polygon_mode = GL_FILL;
+        bool polygon_offset = false;
+        float offset_factor = 0.0f;
+        float offset_units = 0.0f;
+
+        bool operator==(const RasterState &) const = default;
+    };
+
+    struct RenderStateDesc {
+        BlendState blend;
+        DepthState depth;
+        StencilState stencil;
+        RasterState raster;
+        std::array<bool, 4> color_mask = {true, true, true, true};
+
+        bool operator==(const RenderStateDesc &) const = default;
+    };
+
+    // One bit per group of GL calls a RenderState can issue.
+    enum RenderStateField : std::uint32_t {
+        BlendEnable = 1 << 0,
+        BlendFunc = 1 << 1,
+        BlendEquation = 1 << 2,
+        BlendColor = 1 << 3,
+        DepthTest = 1 << 4,
+        DepthWrite = 1 << 5,
+        DepthFunc = 1 << 6,
+        StencilTest = 1 << 7,
+        StencilFunc = 1 << 8,
+        StencilOp = 1 << 9,
+        StencilWriteMask = 1 << 10,
+        CullEnable = 1 << 11,
+        CullFace = 1 << 12,
+        FrontFace = 1 << 13,
+        PolygonMode = 1 << 14,
+        PolygonOffsetEnable = 1 << 15,
+        PolygonOffset = 1 << 16,
+        ColorMask = 1 << 17,
+
+        AllRenderStateFields = (1 << 18) - 1,
+    };
+
+    // Fixed-function state (blend, depth, stencil, culling, polygon offset, color mask) as one immutable object. Equal descriptions
+    // give the same object, so states compare by pointer and get() can be called every frame. Switching from one state to another
+    // only issues the fields that differ between them; bind() goes through the StateCache, which remembers the current state.
+    class RenderState : public std::enable_shared_from_this<RenderState> {
+        RenderStateDesc desc;
+        std::uint64_t hash;
+        std::uint32_t id;
+
+        inline static std::unordered_map<std::uint64_t, std::weak_ptr<const RenderState>> s_states;
+        inline static std::uint32_t s_next_id = 0;
+        // s_states is swept for expired entries whenever it grows to this size.
+        inline static std::size_t s_prune_at = 64;
+        inline static std::mutex s_mutex;
+
+        RenderState(const RenderStateDesc &desc, std::uint64_t hash, std::uint32_t id);
+
+    public:
+        // Safe from any thread, so states can be looked up while recording command lists.
+        static std::shared_ptr<const RenderState> get(const RenderStateDesc &desc = {});
+
+        static std::uint64_t hash_desc(const RenderStateDesc &desc);
+
+        // RenderStateField bits of everything that differs between the two.
+        static std::uint32_t diff(const RenderState &from, const RenderState &to);
+
+        // Issues the fields that differ from `previous`, or everything if it is nullptr. Returns the fields issued. Straight to GL;
+        // use bind() unless you know what is current.
+        std::uint32_t apply(const RenderState *previous) const;
+
+        void bind() const;
+
+        [[nodiscard]] const RenderStateDesc &get_desc() const noexcept;
+        [[nodiscard]] std::uint64_t get_hash() const noexcept;
+        // Small and dense, in creation order, for sort keys.
+        [[nodiscard]] std::uint32_t get_id() const noexcept;
+    };
+
+} // gc
@@ -1,86 +1,645 @@
 #include "shader.hpp"
+#include "barrier_tracker.hpp"
+#include "buffer.hpp"
+#include "uniform_block.hpp"
+#include "program_cache.hpp"
+#include "shader_compiler.hpp"
+#include "shader_profiler.hpp"
+#include "shader_registry.hpp"
+#include "state_cache.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
 #include <fstream>
+#include <utility>
 #include <spdlog/spdlog.h>
 #include <glm/gtc/type_ptr.hpp>
 
 namespace gc {
     Shader::Shader(unsigned int handle, bool owned) : handle(handle), owned(owned) {
+        reflect();
+    }
+
+    enum class UniformBase { Float, Double, Int, UnsignedInt };
+
+    struct UniformTypeInfo {
+        UniformBase base;
+        std::uint32_t size;
+    };
+
+    static UniformTypeInfo uniform_type_info(GLenum type) {
+        switch (type) {
+        case GL_FLOAT: return {UniformBase::Float, 4};
+        case GL_FLOAT_VEC2: return {UniformBase::Float, 8};
+        case GL_FLOAT_VEC3: return {UniformBase::Float, 12};
+        case GL_FLOAT_VEC4: return {UniformBase::Float, 16};
+        case GL_FLOAT_MAT2: return {UniformBase::Float, 16};
+        case GL_FLOAT_MAT2x3: return {UniformBase::Float, 24};
+        case GL_FLOAT_MAT2x4: return {UniformBase::Float, 32};
+        case GL_FLOAT_MAT3: return {UniformBase::Float, 36};
+        case GL_FLOAT_MAT3x2: return {UniformBase::Float, 24};
+        case GL_FLOAT_MAT3x4: return {UniformBase::Float, 48};
+        case GL_FLOAT_MAT4: return {UniformBase::Float, 64};
+        case GL_FLOAT_MAT4x2: return {UniformBase::Float, 32};
+        case GL_FLOAT_MAT4x3: return {UniformBase::Float, 48};
+        case GL_DOUBLE: return {UniformBase::Double, 8};
+        case GL_DOUBLE_VEC2: return {UniformBase::Double, 16};
+        case GL_DOUBLE_VEC3: return {UniformBase::Double, 24};
+        case GL_DOUBLE_VEC4: return {UniformBase::Double, 32};
+        case GL_DOUBLE_MAT2: return {UniformBase::Double, 32};
+        case GL_DOUBLE_MAT2x3: return {UniformBase::Double, 48};
+        case GL_DOUBLE_MAT2x4: return {UniformBase::Double, 64};
+        case GL_DOUBLE_MAT3: return {UniformBase::Double, 72};
+        case GL_DOUBLE_MAT3x2: return {UniformBase::Double, 48};
+        case GL_DOUBLE_MAT3x4: return {UniformBase::Double, 96};
+        case GL_DOUBLE_MAT4: return {UniformBase::Double, 128};
+        case GL_DOUBLE_MAT4x2: return {UniformBase::Double, 64};
+        case GL_DOUBLE_MAT4x3: return {UniformBase::Double, 96};
+        case GL_INT_VEC2: case GL_BOOL_VEC2: return {UniformBase::Int, 8};
+        case GL_INT_VEC3: case GL_BOOL_VEC3: return {UniformBase::Int, 12};
+        case GL_INT_VEC4: case GL_BOOL_VEC4: return {UniformBase::Int, 16};
+        case GL_UNSIGNED_INT: return {UniformBase::UnsignedInt, 4};
+        case GL_UNSIGNED_INT_VEC2: return {UniformBase::UnsignedInt, 8};
+        case GL_UNSIGNED_INT_VEC3: return {UniformBase::UnsignedInt, 12};
+        case GL_UNSIGNED_INT_VEC4: return {UniformBase::UnsignedInt, 16};
+        default: return {UniformBase::Int, 4}; // int, bool, samplers and images are all set through glProgramUniform1i
+        }
+    }
+
+    // Sets one uniform location from raw values laid out like the shadow copy keeps them.
+    static void upload_uniform(unsigned int program, int location, GLenum type, const void *data) {
+        auto f = static_cast<const float *>(data);
+        auto d = static_cast<const double *>(data);
+        auto i = static_cast<const int *>(data);
+        auto u = static_cast<const unsigned int *>(data);
+
+        switch (type) {
+        case GL_FLOAT: glProgramUniform1fv(program, location, 1, f); break;
+        case GL_FLOAT_VEC2: glProgramUniform2fv(program, location, 1, f); break;
+        case GL_FLOAT_VEC3: glProgramUniform3fv(program, location, 1, f); break;
+        case GL_FLOAT_VEC4: glProgramUniform4fv(program, location, 1, f); break;
+        case GL_FLOAT_MAT2: glProgramUniformMatrix2fv(program, location, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT2x3: glProgramUniformMatrix2x3fv(program, location, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT2x4: glProgramUniformMatrix2x4fv(program, location, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT3: glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT3x2: glProgramUniformMatrix3x2fv(program, location, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT3x4: glProgramUniformMatrix3x4fv(program, location, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT4: glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT4x2: glProgramUniformMatrix4x2fv(program, location, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT4x3: glProgramUniformMatrix4x3fv(program, location, 1, GL_FALSE, f); break;
+        case GL_DOUBLE: glProgramUniform1dv(program, location, 1, d); break;
+        case GL_DOUBLE_VEC2: glProgramUniform2dv(program, location, 1, d); break;
+        case GL_DOUBLE_VEC3: glProgramUniform3dv(program, location, 1, d); break;
+        case GL_DOUBLE_VEC4: glProgramUniform4dv(program, location, 1, d); break;
+        case GL_DOUBLE_MAT2: glProgramUniformMatrix2dv(program, location, 1, GL_FALSE, d); break;
+        case GL_DOUBLE_MAT2x3: glProgramUniformMatrix2x3dv(program, location, 1, GL_FALSE, d); break;
+        case GL_DOUBLE_MAT2x4: glProgramUniformMatrix2x4dv(program, location, 1, GL_FALSE, d); break;
+        case GL_DOUBLE_MAT3: glProgramUniformMatrix3dv(program, location, 1, GL_FALSE, d); break;
+        case GL_DOUBLE_MAT3x2: glProgramUniformMatrix3x2dv(program, location, 1, GL_FALSE, d); break;
+        case GL_DOUBLE_MAT3x4: glProgramUniformMatrix3x4dv(program, location, 1, GL_FALSE, d); break;
+        case GL_DOUBLE_MAT4: glProgramUniformMatrix4dv(program, location, 1, GL_FALSE, d); break;
+        case GL_DOUBLE_MAT4x2: glProgramUniformMatrix4x2dv(program, location, 1, GL_FALSE, d); break;
+        case GL_DOUBLE_MAT4x3: glProgramUniformMatrix4x3dv(program, location, 1, GL_FALSE, d); break;
+        case GL_INT_VEC2: case GL_BOOL_VEC2: glProgramUniform2iv(program, location, 1, i); break;
+        case GL_INT_VEC3: case GL_BOOL_VEC3: glProgramUniform3iv(program, location, 1, i); break;
+        case GL_INT_VEC4: case GL_BOOL_VEC4: glProgramUniform4iv(program, location, 1, i); break;
+        case GL_UNSIGNED_INT: glProgramUniform1uiv(program, location, 1, u); break;
+        case GL_UNSIGNED_INT_VEC2: glProgramUniform2uiv(program, location, 1, u); break;
+        case GL_UNSIGNED_INT_VEC3: glProgramUniform3uiv(program, location, 1, u); break;
+        case GL_UNSIGNED_INT_VEC4: glProgramUniform4uiv(program, location, 1, u); break;
+        default: glProgramUniform1iv(program, location, 1, i); break;
+        }
+    }
+
+    void Shader::reflect() {
+        uniforms.clear();
+        slots.clear();
+        shadow.clear();
+        if (handle == 0) return;
+
+        int linked;
+        glGetProgramiv(handle, GL_LINK_STATUS, &linked);
+        if (linked != GL_TRUE) return;
+
+        reflect_blocks();
+
+        int count, max_name_length;
+        glGetProgramInterfaceiv(handle, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+        glGetProgramInterfaceiv(handle, GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_name_length);
+
+        std::string name(max_name_length, '\0');
+        const GLenum props[] = {GL_BLOCK_INDEX, GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE};
+
+        std::vector<std::pair<UniformInfo, std::string>> found;
+        found.reserve(count);
+        for (int i = 0; i < count; i++) {
+            int values[4];
+            glGetProgramResourceiv(handle, GL_UNIFORM, i, 4, props, 4, nullptr, values);
+            if (values[0] != -1 || values[1] == -1) continue;
+
+            int length;
+            glGetProgramResourceName(handle, GL_UNIFORM, i, max_name_length, &length, name.data());
+            std::string_view view(name.data(), length);
+
+            UniformInfo info{hash_string(view), values[1], static_cast<unsigned int>(values[2]), values[3]};
+            found.emplace_back(info, view);
+
+            // Arrays are reported as "name[0]"; make the bare name resolve to the first element too.
+            if (view.ends_with("[0]")) {
+                std::string_view bare = view.substr(0, view.size() - 3);
+                info.hash = hash_string(bare);
+                found.emplace_back(info, bare);
+            }
+        }
+
+        std::sort(found.begin(), found.end(), [](const auto &a, const auto &b) { return a.first.hash < b.first.hash; });
+
+        uniforms.reserve(found.size());
+        for (std::size_t i = 0; i < found.size(); i++) {
+            if (i > 0 && found[i].first.hash == found[i - 1].first.hash) {
+                spdlog::error("Uniforms {} and {} have the same name hash; only {} can be set by name", found[i - 1].second,
+                              found[i].second, found[i - 1].second);
+                continue;
+            }
+            uniforms.push_back(found[i].first);
+        }
+
+        int max_location = -1;
+        for (const auto &info : uniforms)
+            max_location = std::max(max_location, info.location + info.array_size - 1);
+
+        // Array elements occupy consecutive locations; each one gets its own slot.
+        std::uint32_t offset = 0;
+        slots.assign(max_location + 1, UniformSlot{0, 0, 0});
+        for (const auto &info : uniforms) {
+            std::uint32_t size = uniform_type_info(info.type).size;
+            for (int i = 0; i < info.array_size; i++) {
+                UniformSlot &slot = slots[info.location + i];
+                if (slot.size != 0) continue;
+
+                slot = {offset, size, info.type};
+                offset += size;
+            }
+        }
+
+        shadow.resize(offset);
+        sync_uniforms();
+    }
+
+    void Shader::reflect_blocks() {
+        uniform_bindings.clear();
+        storage_bindings.clear();
+
+        for (auto type : {BlockType::Uniform, BlockType::ShaderStorage}) {
+            GLenum interface = type == BlockType::Uniform ? GL_UNIFORM_BLOCK : GL_SHADER_STORAGE_BLOCK;
+
+            int count, max_name_length, max_bindings;
+            glGetProgramInterfaceiv(handle, interface, GL_ACTIVE_RESOURCES, &count);
+            glGetProgramInterfaceiv(handle, interface, GL_MAX_NAME_LENGTH, &max_name_length);
+            glGetIntegerv(type == BlockType::Uniform ? GL_MAX_UNIFORM_BUFFER_BINDINGS : GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &max_bindings);
+
+            std::string name(max_name_length, '\0');
+            for (int i = 0; i < count; i++) {
+                int length;
+                glGetProgramResourceName(handle, interface, i, max_name_length, &length, name.data());
+
+                auto &bindings = type == BlockType::Uniform ? uniform_bindings : storage_bindings;
+
+                const GLenum prop = GL_BUFFER_BINDING;
+                int declared;
+                glGetProgramResourceiv(handle, interface, i, 1, &prop, 1, nullptr, &declared);
+
+                // SPIR-V without debug info has no names; its blocks keep the binding set in the shader. So does any block with
+                // an explicit binding; 0 can't be told apart from none, so those get one assigned.
+                if (length == 0 || declared != 0) {
+                    if (length != 0) claim_block_binding(type, std::string_view(name.data(), length), declared);
+                    bindings.push_back(declared);
+                    continue;
+                }
+
+                unsigned int binding = get_block_binding(type, std::string_view(name.data(), length));
+                if (binding >= static_cast<unsigned int>(max_bindings))
+                    spdlog::warn("Ran out of {} block bindings ({} available)", type == BlockType::Uniform ? "uniform" : "storage", max_bindings);
+
+                if (type == BlockType::Uniform)
+                    glUniformBlockBinding(handle, i, binding);
+                else
+                    glShaderStorageBlockBinding(handle, i, binding);
+                bindings.push_back(binding);
+            }
+        }
+    }
+
+    void Shader::swap_program(Shader &other) {
+        std::swap(handle, other.handle);
+        std::swap(owned, other.owned);
+        std::swap(uniforms, other.uniforms);
+        std::swap(slots, other.slots);
+        std::swap(shadow, other.shadow);
+        std::swap(uniform_bindings, other.uniform_bindings);
+        std::swap(storage_bindings, other.storage_bindings);
+        std::swap(work_group_size, other.work_group_size);
+
+        if (handle == 0) return;
+
+        for (const auto &info : uniforms) {
+            auto previous = std::lower_bound(other.uniforms.begin(), other.uniforms.end(), info.hash,
+                                             [](const UniformInfo &u, std::uint64_t hash) { return u.hash < hash; });
+            if (previous == other.uniforms.end() || previous->hash != info.hash || previous->type != info.type) continue;
+
+            for (int i = 0; i < std::min(info.array_size, previous->array_size); i++) {
+                const UniformSlot &to = slots[info.location + i];
+                const UniformSlot &from = other.slots[previous->location + i];
+                if (std::memcmp(shadow.data() + to.offset, other.shadow.data() + from.offset, to.size) == 0) continue;
+
+                upload_uniform(handle, info.location + i, info.type, other.shadow.data() + from.offset);
+                std::memcpy(shadow.data() + to.offset, other.shadow.data() + from.offset, to.size);
+            }
+        }
+    }
+
+    void Shader::sync_uniforms() {
+        for (const auto &info : uniforms) {
+            UniformBase base = uniform_type_info(info.type).base;
+            for (int i = 0; i < info.array_size; i++) {
+                const UniformSlot &slot = slots[info.location + i];
+                void *dst = shadow.data() + slot.offset;
+                auto size = static_cast<GLsizei>(slot.size);
+
+                switch (base) {
+                case UniformBase::Float: glGetnUniformfv(handle, info.location + i, size, static_cast<float *>(dst)); break;
+                case UniformBase::Double: glGetnUniformdv(handle, info.location + i, size, static_cast<double *>(dst)); break;
+                case UniformBase::Int: glGetnUniformiv(handle, info.location + i, size, static_cast<int *>(dst)); break;
+                case UniformBase::UnsignedInt: glGetnUniformuiv(handle, info.location + i, size, static_cast<unsigned int *>(dst)); break;
+                }
+            }
+        }
+    }
+
+    // Components of a bool uniform type, 0 if it isn't one.
+    static int bool_components(GLenum type) {
+        switch (type) {
+        case GL_BOOL: return 1;
+        case GL_BOOL_VEC2: return 2;
+        case GL_BOOL_VEC3: return 3;
+        case GL_BOOL_VEC4: return 4;
+        default: return 0;
+        }
+    }
+
+    // Components of the f, i and ui setters, which GL all accepts for bools; 0 for the other setters.
+    static int bool_setter_components(GLenum setter) {
+        switch (setter) {
+        case GL_FLOAT: case GL_INT: case GL_UNSIGNED_INT: return 1;
+        case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: return 2;
+        case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: return 3;
+        case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: return 4;
+        default: return 0;
+        }
+    }
+
+    // Samplers and images are set through glProgramUniform1i like plain ints.
+    static bool is_opaque_type(GLenum type) {
+        UniformTypeInfo info = uniform_type_info(type);
+        return info.base == UniformBase::Int && info.size == 4 && type != GL_INT && type != GL_BOOL;
+    }
+
+    bool Shader::update_shadow(int location, const void *data, std::size_t size, GLenum setter) const {
+        if (location < 0) {
+            // GL ignores location -1 anyway.
+            s_uniforms_skipped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        if (static_cast<std::size_t>(location) >= slots.size() || slots[location].size == 0) {
+            // Unknown location; let GL deal with it.
+            s_uniforms_issued.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        const UniformSlot &slot = slots[location];
+        int flags[4];
+        if (int components = bool_components(slot.type)) {
+            // GL stores whatever setter was used as 0 or 1, which is also how sync_uniforms() reads bools back, so compare
+            // against that rather than the bytes passed in.
+            if (bool_setter_components(setter) != components) {
+                s_uniforms_issued.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+
+            bool is_float = uniform_type_info(setter).base == UniformBase::Float;
+            for (int i = 0; i < components; i++)
+                flags[i] = is_float ? static_cast<const float *>(data)[i] != 0.0f : static_cast<const int *>(data)[i] != 0;
+            data = flags;
+            size = components * sizeof(int);
+        } else if (setter != slot.type && !(setter == GL_INT && is_opaque_type(slot.type))) {
+            // GL rejects any other setter with INVALID_OPERATION and keeps the old value, so the shadow stays as it is.
+            s_uniforms_issued.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        std::byte *dst = shadow.data() + slot.offset;
+        if (std::memcmp(dst, data, size) == 0) {
+            s_uniforms_skipped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        std::memcpy(dst, data, size);
+        s_uniforms_issued.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    UniformStats Shader::get_uniform_stats() noexcept {
+        return {s_uniforms_issued.load(std::memory_order_relaxed), s_uniforms_skipped.load(std::memory_order_relaxed)};
+    }
+
+    void Shader::reset_uniform_stats() noexcept {
+        s_uniforms_issued.store(0, std::memory_order_relaxed);
+        s_uniforms_skipped.store(0, std::memory_order_relaxed);
     }
 
     Shader::~Shader() {
-        if (owned) glDeleteProgram(handle);
+        if (owned) {
+            if (StateCache *cache = StateCache::get()) cache->forget_program(handle);
+            glDeleteProgram(handle);
+        }
+    }
+
+    ShaderSource ShaderSource::from_spirv(ShaderType type, std::vector<std::uint32_t> spirv, std::string entry_point) {
+        ShaderSource source{type};
+        source.spirv = std::move(spirv);
+        source.entry_point = std::move(entry_point);
+        return source;
+    }
+
+    ShaderSource &ShaderSource::specialize(unsigned int id, bool value) {
+        return specialize(id, static_cast<std::uint32_t>(value));
+    }
+
+    ShaderSource &ShaderSource::specialize(unsigned int id, std::int32_t value) {
+        return specialize(id, static_cast<std::uint32_t>(value));
     }
 
-    static unsigned int create_shader_module(const ShaderSource& source) {
+    ShaderSource &ShaderSource::specialize(unsigned int id, std::uint32_t value) {
+        auto it = std::find_if(constants.begin(), constants.end(), [&](const SpecializationConstant &c) { return c.id == id; });
+        if (it != constants.end()) it->value = value;
+        else constants.push_back({id, value});
+        return *this;
+    }
+
+    ShaderSource &ShaderSource::specialize(unsigned int id, float value) {
+        return specialize(id, std::bit_cast<std::uint32_t>(value));
+    }
+
+    ShaderSource &ShaderSource::reject_constant(unsigned int id) {
+        spdlog::error("Specialization constant {} of {} does not fit in 32 bits, leaving it unset", id, name.empty() ? "a shader" : name);
+        return *this;
+    }
+
+    bool ShaderSource::is_spirv() const noexcept {
+        return !spirv.empty();
+    }
+
+    EmbeddedShader::operator ShaderSource() const {
+        ShaderSource result{type, std::string(source)};
+        result.hash = hash;
+        result.name = std::string(name);
+        return result;
+    }
+
+    static unsigned int submit_shader_module(const ShaderSource& source) {
         unsigned int shader = glCreateShader(static_cast<GLenum>(source.type));
+
+        if (source.is_spirv()) {
+            glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V, source.spirv.data(),
+                           static_cast<GLsizei>(source.spirv.size() * sizeof(std::uint32_t)));
+
+            std::vector<unsigned int> ids, values;
+            for (const auto& constant : source.constants) {
+                ids.push_back(constant.id);
+                values.push_back(constant.value);
+            }
+
+            // Specializing is the SPIR-V equivalent of glCompileShader and sets the compile status the same way.
+            glSpecializeShader(shader, source.entry_point.c_str(), static_cast<unsigned int>(ids.size()), ids.data(), values.data());
+            return shader;
+        }
+
         const char* src = source.source.c_str();
         glShaderSource(shader, 1, &src, nullptr);
 
         glCompileShader(shader);
 
+        return shader;
+    }
+
+    static bool check_shader_module(unsigned int shader) {
         int status;
         glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
         if (status != GL_TRUE) {
             int log_length;
             glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_length);
-            char* buf = new char[log_length];
+            std::string buf(log_length, '\0');
 
-            glGetShaderInfoLog(shader, log_length, &status, buf);
+            glGetShaderInfoLog(shader, log_length, nullptr, buf.data());
             spdlog::error("Failed to compile shader: {}", buf);
 
-            glDeleteShader(shader);
-            return 0;
+            return false;
         }
 
-        return shader;
+        return true;
     }
 
-    static unsigned int create_shader(const std::vector<ShaderSource> &sources) {
-        unsigned int program = glCreateProgram();
-        std::vector<unsigned int> shaders;
-        shaders.reserve(sources.size());
+    namespace detail {
+        std::uint64_t hash_source(const ShaderSource &source) {
+            std::uint64_t h = hash_combine(hash_seed, static_cast<std::uint64_t>(source.type));
+            h = hash_combine(h, source.hash ? source.hash : hash_shader_source(source.source));
+            if (!source.is_spirv()) return h;
+
+            h = hash_combine(h, hash_bytes(source.spirv.data(), source.spirv.size() * sizeof(std::uint32_t)));
+            h = hash_combine(h, hash_string(source.entry_point));
+            for (const auto& constant : source.constants) {
+                h = hash_combine(hash_combine(h, constant.id), constant.value);
+            }
+            return h;
+        }
+    } // detail
+
+    static std::uint64_t hash_sources(const std::vector<ShaderSource> &sources) {
+        std::uint64_t h = hash_seed;
+        for (const auto &source : sources) {
+            h = hash_combine(h, detail::hash_source(source));
+        }
+        return h;
+    }
+
+    static ProgramCache *get_program_cache() {
+        GlobalState *state = GlobalState::get();
+        return state ? state->get_program_cache() : nullptr;
+    }
+
+    static std::string build_label(const std::vector<ShaderSource> &sources) {
+        std::string label;
         for (const auto& source : sources) {
-            unsigned int module = create_shader_module(source);
+            if (source.name.empty()) continue;
+            if (!label.empty()) label += '+';
+            label += source.name;
+        }
+        return label;
+    }
+
+    static void profile_build(const detail::ProgramBuild &build, unsigned int program) {
+        if (!ShaderProfiler::is_enabled()) return;
+
+        using ms = std::chrono::duration<double, std::milli>;
+
+        ShaderBuildRecord record;
+        record.label = build.label.empty() ? fmt::format("{:016x}", build.key) : build.label;
+        record.key = build.key;
+        record.cached = build.cached;
+        record.failed = program == 0;
+        record.stages = build.stages;
+        record.source_size = build.source_size;
+        record.compile_ms = ms(build.compile_time).count();
+        record.link_ms = ms(build.link_time).count();
+        record.cache_ms = ms(build.cache_time).count();
+        record.total_ms = ms(ShaderProfiler::Clock::now() - build.started).count();
+
+        if (program) {
+            int length = 0;
+            glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+            record.binary_length = length;
+        }
 
-            if (module == 0) {
-                spdlog::error("Shader module failed to compile; not proceeding to link program.");
+        ShaderProfiler::record(std::move(record), build.started);
+    }
+
+    namespace detail {
+        ProgramBuild submit_program(const std::vector<ShaderSource> &sources, bool separable) {
+            using Clock = ShaderProfiler::Clock;
 
-                for (const auto& module_ : shaders) {
-                    glDeleteShader(module_);
+            ProgramBuild build;
+            build.started = Clock::now();
+            build.key = hash_combine(hash_sources(sources), separable);
+            build.label = build_label(sources);
+            build.stages = sources.size();
+            for (const auto& source : sources) {
+                build.source_size += source.is_spirv() ? source.spirv.size() * sizeof(std::uint32_t) : source.source.size();
+            }
+
+            if (ProgramCache *cache = get_program_cache()) {
+                build.program = cache->load(build.key, separable);
+                build.cache_time = Clock::now() - build.started;
+                if (build.program) {
+                    build.cached = true;
+                    return build;
                 }
+            }
 
-                return 0; // definitely not a program handle
+            build.program = glCreateProgram();
+            if (get_program_cache()) glProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            if (separable) glProgramParameteri(build.program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+
+            auto compile_start = Clock::now();
+            build.modules.reserve(sources.size());
+            for (const auto& source : sources) {
+                unsigned int module = submit_shader_module(source);
+                build.modules.push_back(module);
+                glAttachShader(build.program, module);
             }
 
-            shaders.push_back(module);
+            // Link without waiting on the compiles so a driver with parallel compilation can queue the whole program. A failed
+            // compile just makes the link fail, and finish_program reports the compile log first.
+            auto link_start = Clock::now();
+            glLinkProgram(build.program);
+
+            build.compile_time += link_start - compile_start;
+            build.link_time += Clock::now() - link_start;
 
-            glAttachShader(program, module);
+            return build;
         }
 
-        glLinkProgram(program);
-        int status;
-        glGetProgramiv(program, GL_LINK_STATUS, &status);
-        if (status != GL_TRUE) {
-            int log_length;
-            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &log_length);
-            char* buf = new char[log_length];
+        bool is_program_build_complete(const ProgramBuild &build) {
+            if (build.cached || build.program == 0) return true;
 
-            glGetProgramInfoLog(program, log_length, &status, buf);
+            // The query is an error without the extension; report not ready and let finish_program() block on the build.
+            if (!GLAD_GL_KHR_parallel_shader_compile && !GLAD_GL_ARB_parallel_shader_compile) return false;
 
-            spdlog::error("Failed to link shader: {}", buf);
+            int complete = GL_FALSE;
+            glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &complete);
+            return complete == GL_TRUE;
+        }
 
-            for (const auto& module : shaders) {
+        void discard_program(ProgramBuild &build) {
+            for (const auto& module : build.modules) {
                 glDeleteShader(module);
             }
+            build.modules.clear();
 
-            return 0; // definitely not a program handle
+            if (build.program) glDeleteProgram(build.program);
+            build.program = 0;
         }
 
-        for (const auto& module : shaders) {
-            glDeleteShader(module);
+        unsigned int finish_program(ProgramBuild &build) {
+            using Clock = ShaderProfiler::Clock;
+
+            if (build.cached) {
+                profile_build(build, build.program);
+                return std::exchange(build.program, 0);
+            }
+
+            // Asking for the status is where the driver makes us wait for the work it queued.
+            auto compile_start = Clock::now();
+            bool compiled = true;
+            for (const auto& module : build.modules) {
+                compiled = check_shader_module(module) && compiled;
+            }
+            build.compile_time += Clock::now() - compile_start;
+
+            if (!compiled) {
+                spdlog::error("Shader module failed to compile; not proceeding to link program.");
+                discard_program(build);
+                profile_build(build, 0);
+                return 0; // definitely not a program handle
+            }
+
+            auto link_start = Clock::now();
+            int status;
+            glGetProgramiv(build.program, GL_LINK_STATUS, &status);
+            build.link_time += Clock::now() - link_start;
+            if (status != GL_TRUE) {
+                int log_length;
+                glGetProgramiv(build.program, GL_INFO_LOG_LENGTH, &log_length);
+                std::string buf(log_length, '\0');
+
+                glGetProgramInfoLog(build.program, log_length, nullptr, buf.data());
+
+                spdlog::error("Failed to link shader: {}", buf);
+
+                discard_program(build);
+                profile_build(build, 0);
+                return 0; // definitely not a program handle
+            }
+
+            for (const auto& module : build.modules) {
+                glDeleteShader(module);
+            }
+            build.modules.clear();
+
+            if (ProgramCache *cache = get_program_cache()) {
+                auto store_start = Clock::now();
+                cache->store(build.key, build.program);
+                build.cache_time += Clock::now() - store_start;
+            }
+
+            profile_build(build, build.program);
+            return std::exchange(build.program, 0);
         }
+    } // detail
 
-        return program;
+    static unsigned int create_shader(const std::vector<ShaderSource> &sources) {
+        detail::ProgramBuild build = detail::submit_program(sources);
+        return detail::finish_program(build);
     }
 
     static std::string read_file(const std::filesystem::path& path) {
@@ -94,14 +653,41 @@ namespace gc {
         return buf;
     }
 
-    static unsigned int load_shader(const std::vector<std::pair<ShaderType, std::filesystem::path>> &sources) {
-        std::vector<ShaderSource> loaded_sources;
-        loaded_sources.reserve(sources.size());
-        for (const auto& source : sources) {
-            loaded_sources.push_back(ShaderSource{source.first, read_file(source.second)});
+    static constexpr std::uint32_t spirv_magic = 0x07230203;
+
+    static std::vector<std::uint32_t> read_spirv(const std::filesystem::path& path) {
+        std::ifstream f(path, std::ios::ate | std::ios::in | std::ios::binary);
+
+        std::size_t size = f ? static_cast<std::size_t>(f.tellg()) : 0;
+        std::vector<std::uint32_t> words(size / sizeof(std::uint32_t));
+        f.seekg(0);
+        f.read(reinterpret_cast<char *>(words.data()), static_cast<std::streamsize>(words.size() * sizeof(std::uint32_t)));
+
+        if (words.empty() || words[0] != spirv_magic || size % sizeof(std::uint32_t) != 0) {
+            spdlog::error("{} is not a SPIR-V module", path.string());
+            return {};
         }
 
-        return create_shader(loaded_sources);
+        return words;
+    }
+
+    namespace detail {
+        std::vector<ShaderSource> read_sources(const std::vector<std::pair<ShaderType, std::filesystem::path>> &sources) {
+            std::vector<ShaderSource> loaded_sources;
+            loaded_sources.reserve(sources.size());
+            for (const auto& source : sources) {
+                if (source.second.extension() == ".spv")
+                    loaded_sources.push_back(ShaderSource::from_spirv(source.first, read_spirv(source.second)));
+                else
+                    loaded_sources.push_back(ShaderSource{source.first, read_file(source.second)});
+                loaded_sources.back().name = source.second.filename().string();
+            }
+            return loaded_sources;
+        }
+    } // detail
+
+    static unsigned int load_shader(const std::vector<std::pair<ShaderType, std::filesystem::path>> &sources) {
+        return create_shader(detail::read_sources(sources));
     }
 
     std::unique_ptr<Shader> Shader::wrap(unsigned int handle, bool take_ownership) {
@@ -121,420 +707,533 @@ namespace gc {
     }
 
     std::shared_ptr<Shader> Shader::create_shared(const std::vector<ShaderSource> &sources) {
-        return wrap_shared(create_shader(sources), true);
+        return ShaderRegistry::get_or_create(sources, [&]() { return wrap_shared(create_shader(sources), true); });
     }
 
     std::shared_ptr<Shader>
     Shader::load_shared(const std::vector<std::pair<ShaderType, std::filesystem::path>> &sources) {
-        return wrap_shared(load_shader(sources), true);
+        return create_shared(detail::read_sources(sources));
+    }
+
+    void Shader::sync_block_reads() const {
+        BarrierTracker *tracker = BarrierTracker::get();
+        if (!tracker) return;
+
+        for (auto binding : uniform_bindings)
+            tracker->read(tracker->get_binding(BufferTarget::Uniform, binding), BufferAccess::Uniform);
+        for (auto binding : storage_bindings)
+            tracker->read(tracker->get_binding(BufferTarget::ShaderStorage, binding), BufferAccess::ShaderStorage);
+        tracker->flush();
+    }
+
+    void Shader::record_dispatch_writes(std::initializer_list<const Buffer *> writes) const {
+        BarrierTracker *tracker = BarrierTracker::get();
+        if (!tracker) return;
+
+        if (writes.size() == 0) {
+            for (auto binding : storage_bindings)
+                tracker->write(tracker->get_binding(BufferTarget::ShaderStorage, binding));
+        } else {
+            for (const auto *buffer : writes)
+                if (buffer) tracker->write(buffer->get_handle());
+        }
     }
 
     void Shader::bind() const {
-        glUseProgram(handle);
+        sync_block_reads();
+        use_program(handle);
+    }
+
+    void Shader::dispatch(const glm::uvec3 &groups, std::initializer_list<const Buffer *> writes) const {
+        bind();
+        glDispatchCompute(groups.x, groups.y, groups.z);
+        record_dispatch_writes(writes);
+    }
+
+    void Shader::dispatch_invocations(const glm::uvec3 &invocations, std::initializer_list<const Buffer *> writes) const {
+        glm::uvec3 size = get_work_group_size();
+        dispatch((invocations + size - 1u) / size, writes);
+    }
+
+    void Shader::dispatch_indirect(const Buffer &buffer, std::size_t offset, std::initializer_list<const Buffer *> writes) const {
+        if (BarrierTracker *tracker = BarrierTracker::get()) tracker->read(buffer.get_handle(), BufferAccess::Command);
+        bind(); // flushes the command read along with the block reads
+
+        bind_buffer(GL_DISPATCH_INDIRECT_BUFFER, buffer.get_handle());
+        glDispatchComputeIndirect(static_cast<GLintptr>(offset));
+        record_dispatch_writes(writes);
+    }
+
+    glm::uvec3 Shader::get_work_group_size() const {
+        if (!work_group_size) {
+            int size[3] = {1, 1, 1};
+            if (handle) glGetProgramiv(handle, GL_COMPUTE_WORK_GROUP_SIZE, size);
+            work_group_size = glm::uvec3(size[0], size[1], size[2]);
+        }
+        return *work_group_size;
+    }
+
+    unsigned int Shader::get_handle() const noexcept {
+        return handle;
+    }
+
+    static const UniformInfo *find_uniform_hash(const std::vector<UniformInfo> &uniforms, std::uint64_t hash) noexcept {
+        auto it = std::lower_bound(uniforms.begin(), uniforms.end(), hash,
+                                   [](const UniformInfo &info, std::uint64_t value) { return info.hash < value; });
+        if (it == uniforms.end() || it->hash != hash) return nullptr;
+        return &*it;
+    }
+
+    const UniformInfo *Shader::find_uniform(UniformName name) const noexcept {
+        return find_uniform_hash(uniforms, name.hash);
+    }
+
+    int Shader::get_uniform_location(UniformName name) const noexcept {
+        if (const UniformInfo *info = find_uniform(name)) return info->location;
+        if (name.array_hash == 0) return -1;
+
+        // "name[N]" past the first element: elements follow the first one's location.
+        const UniformInfo *array = find_uniform_hash(uniforms, name.array_hash);
+        if (!array || name.element >= static_cast<std::uint32_t>(array->array_size)) return -1;
+        return array->location + static_cast<int>(name.element);
     }
 
-    int Shader::get_uniform_location(const std::string &name) const {
-        return glGetUniformLocation(handle, name.c_str());
+    const std::vector<UniformInfo> &Shader::get_uniforms() const noexcept {
+        return uniforms;
     }
 
-    void Shader::uniform_1f(const std::string& name, const float &x) const {
+    void Shader::uniform_1f(UniformName name, const float &x) const {
         uniform_1f(get_uniform_location(name), x);
     }
 
     void Shader::uniform_1f(int location, const float &x) const {
-        glProgramUniform1f(handle, location, x);
+        uniform_1f(location, glm::vec1(x));
     }
 
-    void Shader::uniform_1f(const std::string& name, const glm::vec1 &v) const {
+    void Shader::uniform_1f(UniformName name, const glm::vec1 &v) const {
         uniform_1f(get_uniform_location(name), v);
     }
 
     void Shader::uniform_1f(int location, const glm::vec1 &v) const {
-        uniform_1f(location, v.x);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_FLOAT))
+            glProgramUniform1fv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_2f(const std::string& name, const float &x, const float &y) const {
+    void Shader::uniform_2f(UniformName name, const float &x, const float &y) const {
         uniform_2f(get_uniform_location(name), x, y);
     }
 
     void Shader::uniform_2f(int location, const float &x, const float &y) const {
-        glProgramUniform2f(handle, location, x, y);
+        uniform_2f(location, glm::vec2(x, y));
     }
 
-    void Shader::uniform_2f(const std::string& name, const glm::vec2 &v) const {
+    void Shader::uniform_2f(UniformName name, const glm::vec2 &v) const {
         uniform_2f(get_uniform_location(name), v);
     }
 
     void Shader::uniform_2f(int location, const glm::vec2 &v) const {
-        uniform_2f(location, v.x, v.y);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_FLOAT_VEC2))
+            glProgramUniform2fv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_3f(const std::string& name, const float &x, const float &y, const float &z) const {
+    void Shader::uniform_3f(UniformName name, const float &x, const float &y, const float &z) const {
         uniform_3f(get_uniform_location(name), x, y, z);
     }
 
     void Shader::uniform_3f(int location, const float &x, const float &y, const float &z) const {
-        glProgramUniform3f(handle, location, x, y, z);
+        uniform_3f(location, glm::vec3(x, y, z));
     }
 
-    void Shader::uniform_3f(const std::string& name, const glm::vec3 &v) const {
+    void Shader::uniform_3f(UniformName name, const glm::vec3 &v) const {
         uniform_3f(get_uniform_location(name), v);
     }
 
     void Shader::uniform_3f(int location, const glm::vec3 &v) const {
-        uniform_3f(location, v.x, v.y, v.z);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_FLOAT_VEC3))
+            glProgramUniform3fv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_4f(const std::string& name, const float &x, const float &y, const float &z, const float &w) const {
+    void Shader::uniform_4f(UniformName name, const float &x, const float &y, const float &z, const float &w) const {
         uniform_4f(get_uniform_location(name), x, y, z, w);
     }
 
     void Shader::uniform_4f(int location, const float &x, const float &y, const float &z, const float &w) const {
-        glProgramUniform4f(handle, location, x, y, z, w);
+        uniform_4f(location, glm::vec4(x, y, z, w));
     }
 
-    void Shader::uniform_4f(const std::string& name, const glm::vec4 &v) const {
+    void Shader::uniform_4f(UniformName name, const glm::vec4 &v) const {
         uniform_4f(get_uniform_location(name), v);
     }
 
     void Shader::uniform_4f(int location, const glm::vec4 &v) const {
-        uniform_4f(location, v.x, v.y, v.z, v.w);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_FLOAT_VEC4))
+            glProgramUniform4fv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_1i(const std::string& name, const int &x) const {
+    void Shader::uniform_1i(UniformName name, const int &x) const {
         uniform_1i(get_uniform_location(name), x);
     }
 
     void Shader::uniform_1i(int location, const int &x) const {
-        glProgramUniform1i(handle, location, x);
+        uniform_1i(location, glm::ivec1(x));
     }
 
-    void Shader::uniform_1i(const std::string& name, const glm::ivec1 &v) const {
+    void Shader::uniform_1i(UniformName name, const glm::ivec1 &v) const {
         uniform_1i(get_uniform_location(name), v);
     }
 
     void Shader::uniform_1i(int location, const glm::ivec1 &v) const {
-        uniform_1i(location, v.x);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_INT))
+            glProgramUniform1iv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_2i(const std::string& name, const int &x, const int &y) const {
+    void Shader::uniform_2i(UniformName name, const int &x, const int &y) const {
         uniform_2i(get_uniform_location(name), x, y);
     }
 
     void Shader::uniform_2i(int location, const int &x, const int &y) const {
-        glProgramUniform2i(handle, location, x, y);
+        uniform_2i(location, glm::ivec2(x, y));
     }
 
-    void Shader::uniform_2i(const std::string& name, const glm::ivec2 &v) const {
+    void Shader::uniform_2i(UniformName name, const glm::ivec2 &v) const {
         uniform_2i(get_uniform_location(name), v);
     }
 
     void Shader::uniform_2i(int location, const glm::ivec2 &v) const {
-        uniform_2i(location, v.x, v.y);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_INT_VEC2))
+            glProgramUniform2iv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_3i(const std::string& name, const int &x, const int &y, const int &z) const {
+    void Shader::uniform_3i(UniformName name, const int &x, const int &y, const int &z) const {
         uniform_3i(get_uniform_location(name), x, y, z);
     }
 
     void Shader::uniform_3i(int location, const int &x, const int &y, const int &z) const {
-        glProgramUniform3i(handle, location, x, y, z);
+        uniform_3i(location, glm::ivec3(x, y, z));
     }
 
-    void Shader::uniform_3i(const std::string& name, const glm::ivec3 &v) const {
+    void Shader::uniform_3i(UniformName name, const glm::ivec3 &v) const {
         uniform_3i(get_uniform_location(name), v);
     }
 
     void Shader::uniform_3i(int location, const glm::ivec3 &v) const {
-        uniform_3i(location, v.x, v.y, v.z);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_INT_VEC3))
+            glProgramUniform3iv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_4i(const std::string& name, const int &x, const int &y, const int &z, const int &w) const {
+    void Shader::uniform_4i(UniformName name, const int &x, const int &y, const int &z, const int &w) const {
         uniform_4i(get_uniform_location(name), x, y, z, w);
     }
 
     void Shader::uniform_4i(int location, const int &x, const int &y, const int &z, const int &w) const {
-        glProgramUniform4i(handle, location, x, y, z, w);
+        uniform_4i(location, glm::ivec4(x, y, z, w));
     }
 
-    void Shader::uniform_4i(const std::string& name, const glm::ivec4 &v) const {
+    void Shader::uniform_4i(UniformName name, const glm::ivec4 &v) const {
         uniform_4i(get_uniform_location(name), v);
     }
 
     void Shader::uniform_4i(int location, const glm::ivec4 &v) const {
-        uniform_4i(location, v.x, v.y, v.z, v.w);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_INT_VEC4))
+            glProgramUniform4iv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_1ui(const std::string& name, const unsigned int &x) const {
+    void Shader::uniform_1ui(UniformName name, const unsigned int &x) const {
         uniform_1ui(get_uniform_location(name), x);
     }
 
     void Shader::uniform_1ui(int location, const unsigned int &x) const {
-        glProgramUniform1ui(handle, location, x);
+        uniform_1ui(location, glm::uvec1(x));
     }
 
-    void Shader::uniform_1ui(const std::string& name, const glm::uvec1 &v) const {
+    void Shader::uniform_1ui(UniformName name, const glm::uvec1 &v) const {
         uniform_1ui(get_uniform_location(name), v);
     }
 
     void Shader::uniform_1ui(int location, const glm::uvec1 &v) const {
-        uniform_1ui(location, v.x);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_UNSIGNED_INT))
+            glProgramUniform1uiv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_2ui(const std::string& name, const unsigned int &x, const unsigned int &y) const {
+    void Shader::uniform_2ui(UniformName name, const unsigned int &x, const unsigned int &y) const {
         uniform_2ui(get_uniform_location(name), x, y);
     }
 
     void Shader::uniform_2ui(int location, const unsigned int &x, const unsigned int &y) const {
-        glProgramUniform2ui(handle, location, x, y);
+        uniform_2ui(location, glm::uvec2(x, y));
     }
 
-    void Shader::uniform_2ui(const std::string& name, const glm::uvec2 &v) const {
+    void Shader::uniform_2ui(UniformName name, const glm::uvec2 &v) const {
         uniform_2ui(get_uniform_location(name), v);
     }
 
     void Shader::uniform_2ui(int location, const glm::uvec2 &v) const {
-        uniform_2ui(location, v.x, v.y);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_UNSIGNED_INT_VEC2))
+            glProgramUniform2uiv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_3ui(const std::string& name, const unsigned int &x, const unsigned int &y, const unsigned int &z) const {
+    void Shader::uniform_3ui(UniformName name, const unsigned int &x, const unsigned int &y, const unsigned int &z) const {
         uniform_3ui(get_uniform_location(name), x, y, z);
     }
 
     void Shader::uniform_3ui(int location, const unsigned int &x, const unsigned int &y, const unsigned int &z) const {
-        glProgramUniform3ui(handle, location, x, y, z);
+        uniform_3ui(location, glm::uvec3(x, y, z));
     }
 
-    void Shader::uniform_3ui(const std::string& name, const glm::uvec3 &v) const {
+    void Shader::uniform_3ui(UniformName name, const glm::uvec3 &v) const {
         uniform_3ui(get_uniform_location(name), v);
     }
 
     void Shader::uniform_3ui(int location, const glm::uvec3 &v) const {
-        uniform_3ui(location, v.x, v.y, v.z);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_UNSIGNED_INT_VEC3))
+            glProgramUniform3uiv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_4ui(const std::string& name, const unsigned int &x, const unsigned int &y, const unsigned int &z, const unsigned int &w) const {
+    void Shader::uniform_4ui(UniformName name, const unsigned int &x, const unsigned int &y, const unsigned int &z, const unsigned int &w) const {
         uniform_4ui(get_uniform_location(name), x, y, z, w);
     }
 
     void Shader::uniform_4ui(int location, const unsigned int &x, const unsigned int &y, const unsigned int &z, const unsigned int &w) const {
-        glProgramUniform4ui(handle, location, x, y, z, w);
+        uniform_4ui(location, glm::uvec4(x, y, z, w));
     }
 
-    void Shader::uniform_4ui(const std::string& name, const glm::uvec4 &v) const {
+    void Shader::uniform_4ui(UniformName name, const glm::uvec4 &v) const {
         uniform_4ui(get_uniform_location(name), v);
     }
 
     void Shader::uniform_4ui(int location, const glm::uvec4 &v) const {
-        uniform_4ui(location, v.x, v.y, v.z, v.w);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_UNSIGNED_INT_VEC4))
+            glProgramUniform4uiv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_1d(const std::string& name, const double &x) const {
+    void Shader::uniform_1d(UniformName name, const double &x) const {
         uniform_1d(get_uniform_location(name), x);
     }
 
     void Shader::uniform_1d(int location, const double &x) const {
-        glProgramUniform1d(handle, location, x);
+        uniform_1d(location, glm::dvec1(x));
     }
 
-    void Shader::uniform_1d(const std::string& name, const glm::dvec1 &v) const {
+    void Shader::uniform_1d(UniformName name, const glm::dvec1 &v) const {
         uniform_1d(get_uniform_location(name), v);
     }
 
     void Shader::uniform_1d(int location, const glm::dvec1 &v) const {
-        uniform_1d(location, v.x);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_DOUBLE))
+            glProgramUniform1dv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_2d(const std::string& name, const double &x, const double &y) const {
+    void Shader::uniform_2d(UniformName name, const double &x, const double &y) const {
         uniform_2d(get_uniform_location(name), x, y);
     }
 
     void Shader::uniform_2d(int location, const double &x, const double &y) const {
-        glProgramUniform2d(handle, location, x, y);
+        uniform_2d(location, glm::dvec2(x, y));
     }
 
-    void Shader::uniform_2d(const std::string& name, const glm::dvec2 &v) const {
+    void Shader::uniform_2d(UniformName name, const glm::dvec2 &v) const {
         uniform_2d(get_uniform_location(name), v);
     }
 
     void Shader::uniform_2d(int location, const glm::dvec2 &v) const {
-        uniform_2d(location, v.x, v.y);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_DOUBLE_VEC2))
+            glProgramUniform2dv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_3d(const std::string& name, const double &x, const double &y, const double &z) const {
+    void Shader::uniform_3d(UniformName name, const double &x, const double &y, const double &z) const {
         uniform_3d(get_uniform_location(name), x, y, z);
     }
 
     void Shader::uniform_3d(int location, const double &x, const double &y, const double &z) const {
-        glProgramUniform3d(handle, location, x, y, z);
+        uniform_3d(location, glm::dvec3(x, y, z));
     }
 
-    void Shader::uniform_3d(const std::string& name, const glm::dvec3 &v) const {
+    void Shader::uniform_3d(UniformName name, const glm::dvec3 &v) const {
         uniform_3d(get_uniform_location(name), v);
     }
 
     void Shader::uniform_3d(int location, const glm::dvec3 &v) const {
-        uniform_3d(location, v.x, v.y, v.z);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_DOUBLE_VEC3))
+            glProgramUniform3dv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_4d(const std::string& name, const double &x, const double &y, const double &z, const double &w) const {
+    void Shader::uniform_4d(UniformName name, const double &x, const double &y, const double &z, const double &w) const {
         uniform_4d(get_uniform_location(name), x, y, z, w);
     }
 
     void Shader::uniform_4d(int location, const double &x, const double &y, const double &z, const double &w) const {
-        glProgramUniform4d(handle, location, x, y, z, w);
+        uniform_4d(location, glm::dvec4(x, y, z, w));
     }
 
-    void Shader::uniform_4d(const std::string& name, const glm::dvec4 &v) const {
+    void Shader::uniform_4d(UniformName name, const glm::dvec4 &v) const {
         uniform_4d(get_uniform_location(name), v);
     }
 
     void Shader::uniform_4d(int location, const glm::dvec4 &v) const {
-        uniform_4d(location, v.x, v.y, v.z, v.w);
+        if (update_shadow(location, glm::value_ptr(v), sizeof(v), GL_DOUBLE_VEC4))
+            glProgramUniform4dv(handle, location, 1, glm::value_ptr(v));
     }
 
-    void Shader::uniform_mat2f(const std::string& name, const glm::mat2 &m) const {
+    void Shader::uniform_mat2f(UniformName name, const glm::mat2 &m) const {
         uniform_mat2f(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat2f(int location, const glm::mat2 &m) const {
-        glProgramUniformMatrix2fv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_FLOAT_MAT2))
+            glProgramUniformMatrix2fv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat2x3f(const std::string& name, const glm::mat2x3 &m) const {
+    void Shader::uniform_mat2x3f(UniformName name, const glm::mat2x3 &m) const {
         uniform_mat2x3f(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat2x3f(int location, const glm::mat2x3 &m) const {
-        glProgramUniformMatrix2x3fv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_FLOAT_MAT2x3))
+            glProgramUniformMatrix2x3fv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat2x4f(const std::string& name, const glm::mat2x4 &m) const {
+    void Shader::uniform_mat2x4f(UniformName name, const glm::mat2x4 &m) const {
         uniform_mat2x4f(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat2x4f(int location, const glm::mat2x4 &m) const {
-        glProgramUniformMatrix2x4fv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_FLOAT_MAT2x4))
+            glProgramUniformMatrix2x4fv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat3f(const std::string& name, const glm::mat3 &m) const {
+    void Shader::uniform_mat3f(UniformName name, const glm::mat3 &m) const {
         uniform_mat3f(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat3f(int location, const glm::mat3 &m) const {
-        glProgramUniformMatrix3fv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_FLOAT_MAT3))
+            glProgramUniformMatrix3fv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat3x2f(const std::string& name, const glm::mat3x2 &m) const {
+    void Shader::uniform_mat3x2f(UniformName name, const glm::mat3x2 &m) const {
         uniform_mat3x2f(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat3x2f(int location, const glm::mat3x2 &m) const {
-        glProgramUniformMatrix3x2fv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_FLOAT_MAT3x2))
+            glProgramUniformMatrix3x2fv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat3x4f(const std::string& name, const glm::mat3x4 &m) const {
+    void Shader::uniform_mat3x4f(UniformName name, const glm::mat3x4 &m) const {
         uniform_mat3x4f(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat3x4f(int location, const glm::mat3x4 &m) const {
-        glProgramUniformMatrix3x4fv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_FLOAT_MAT3x4))
+            glProgramUniformMatrix3x4fv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat4f(const std::string& name, const glm::mat4 &m) const {
+    void Shader::uniform_mat4f(UniformName name, const glm::mat4 &m) const {
         uniform_mat4f(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat4f(int location, const glm::mat4 &m) const {
-        glProgramUniformMatrix4fv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_FLOAT_MAT4))
+            glProgramUniformMatrix4fv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat4x2f(const std::string& name, const glm::mat4x2 &m) const {
+    void Shader::uniform_mat4x2f(UniformName name, const glm::mat4x2 &m) const {
         uniform_mat4x2f(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat4x2f(int location, const glm::mat4x2 &m) const {
-        glProgramUniformMatrix4x2fv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_FLOAT_MAT4x2))
+            glProgramUniformMatrix4x2fv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat4x3f(const std::string& name, const glm::mat4x3 &m) const {
+    void Shader::uniform_mat4x3f(UniformName name, const glm::mat4x3 &m) const {
         uniform_mat4x3f(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat4x3f(int location, const glm::mat4x3 &m) const {
-        glProgramUniformMatrix4x3fv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_FLOAT_MAT4x3))
+            glProgramUniformMatrix4x3fv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat2d(const std::string& name, const glm::dmat2 &m) const {
+    void Shader::uniform_mat2d(UniformName name, const glm::dmat2 &m) const {
         uniform_mat2d(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat2d(int location, const glm::dmat2 &m) const {
-        glProgramUniformMatrix2dv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_DOUBLE_MAT2))
+            glProgramUniformMatrix2dv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat2x3d(const std::string& name, const glm::dmat2x3 &m) const {
+    void Shader::uniform_mat2x3d(UniformName name, const glm::dmat2x3 &m) const {
         uniform_mat2x3d(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat2x3d(int location, const glm::dmat2x3 &m) const {
-        glProgramUniformMatrix2x3dv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_DOUBLE_MAT2x3))
+            glProgramUniformMatrix2x3dv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat2x4d(const std::string& name, const glm::dmat2x4 &m) const {
+    void Shader::uniform_mat2x4d(UniformName name, const glm::dmat2x4 &m) const {
         uniform_mat2x4d(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat2x4d(int location, const glm::dmat2x4 &m) const {
-        glProgramUniformMatrix2x4dv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_DOUBLE_MAT2x4))
+            glProgramUniformMatrix2x4dv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat3d(const std::string& name, const glm::dmat3 &m) const {
+    void Shader::uniform_mat3d(UniformName name, const glm::dmat3 &m) const {
         uniform_mat3d(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat3d(int location, const glm::dmat3 &m) const {
-        glProgramUniformMatrix3dv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_DOUBLE_MAT3))
+            glProgramUniformMatrix3dv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat3x2d(const std::string& name, const glm::dmat3x2 &m) const {
+    void Shader::uniform_mat3x2d(UniformName name, const glm::dmat3x2 &m) const {
         uniform_mat3x2d(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat3x2d(int location, const glm::dmat3x2 &m) const {
-        glProgramUniformMatrix3x2dv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_DOUBLE_MAT3x2))
+            glProgramUniformMatrix3x2dv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat3x4d(const std::string& name, const glm::dmat3x4 &m) const {
+    void Shader::uniform_mat3x4d(UniformName name, const glm::dmat3x4 &m) const {
         uniform_mat3x4d(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat3x4d(int location, const glm::dmat3x4 &m) const {
-        glProgramUniformMatrix3x4dv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_DOUBLE_MAT3x4))
+            glProgramUniformMatrix3x4dv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat4d(const std::string& name, const glm::dmat4 &m) const {
+    void Shader::uniform_mat4d(UniformName name, const glm::dmat4 &m) const {
         uniform_mat4d(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat4d(int location, const glm::dmat4 &m) const {
-        glProgramUniformMatrix4dv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_DOUBLE_MAT4))
+            glProgramUniformMatrix4dv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat4x2d(const std::string& name, const glm::dmat4x2 &m) const {
+    void Shader::uniform_mat4x2d(UniformName name, const glm::dmat4x2 &m) const {
         uniform_mat4x2d(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat4x2d(int location, const glm::dmat4x2 &m) const {
-        glProgramUniformMatrix4x2dv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_DOUBLE_MAT4x2))
+            glProgramUniformMatrix4x2dv(handle, location, 1, false, glm::value_ptr(m));
     }
 
-    void Shader::uniform_mat4x3d(const std::string& name, const glm::dmat4x3 &m) const {
+    void Shader::uniform_mat4x3d(UniformName name, const glm::dmat4x3 &m) const {
         uniform_mat4x3d(get_uniform_location(name), m);
     }
 
     void Shader::uniform_mat4x3d(int location, const glm::dmat4x3 &m) const {
-        glProgramUniformMatrix4x3dv(handle, location, 1, false, glm::value_ptr(m));
+        if (update_shadow(location, glm::value_ptr(m), sizeof(m), GL_DOUBLE_MAT4x3))
+            glProgramUniformMatrix4x3dv(handle, location, 1, false, glm::value_ptr(m));
     }
 
     void Shader::bind_attrib_location(const std::string &name, int location) const {
@@ -1,9 +1,17 @@
 #pragma once
 
 #include "graphicat/graphicat.hpp"
+#include "graphicat/util/hash.hpp"
+#include <atomic>
+#include <cmath>
+#include <limits>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <filesystem>
+#include <initializer_list>
+#include <optional>
 #include <vector>
 #include <glm/glm.hpp>
 
@@ -18,15 +26,150 @@ namespace gc {
         Compute = GL_COMPUTE_SHADER,
     };
 
+    struct SpecializationConstant {
+        unsigned int id;
+        std::uint32_t value;
+    };
+
+    // Either GLSL text in `source`, or a SPIR-V module in `spirv` (which takes precedence). Specialization constants and the entry
+    // point only apply to SPIR-V.
     struct ShaderSource {
         ShaderType type;
-        std::string source;
+        std::string source = {};
+        std::vector<std::uint32_t> spirv = {};
+        std::string entry_point = "main";
+        std::vector<SpecializationConstant> constants = {};
+        // hash_shader_source(source) if it is already known (e.g. computed at build time), 0 otherwise.
+        std::uint64_t hash = 0;
+        // Shows up in build reports; usually the file the source came from.
+        std::string name = {};
+
+        static ShaderSource from_spirv(ShaderType type, std::vector<std::uint32_t> spirv, std::string entry_point = "main");
+
+        // Sets constant_id `id`. The type has to match the declaration in the shader; bools are 0 or 1.
+        ShaderSource &specialize(unsigned int id, bool value);
+        ShaderSource &specialize(unsigned int id, std::int32_t value);
+        ShaderSource &specialize(unsigned int id, std::uint32_t value);
+        ShaderSource &specialize(unsigned int id, float value);
+        // Any other arithmetic type (double, long, char, ...) narrows to the 32-bit type of its kind. A value that doesn't fit is
+        // logged and the constant left alone.
+        template<typename T> requires std::is_arithmetic_v<T> ShaderSource &specialize(unsigned int id, T value) {
+            if constexpr (std::is_floating_point_v<T>) {
+                if (std::isfinite(value) && std::abs(value) > std::numeric_limits<float>::max()) return reject_constant(id);
+                return specialize(id, static_cast<float>(value));
+            } else if constexpr (std::is_signed_v<T>) {
+                if (static_cast<long long>(value) < std::numeric_limits<std::int32_t>::min() ||
+                    static_cast<long long>(value) > std::numeric_limits<std::int32_t>::max())
+                    return reject_constant(id);
+                return specialize(id, static_cast<std::int32_t>(value));
+            } else {
+                if (static_cast<unsigned long long>(value) > std::numeric_limits<std::uint32_t>::max()) return reject_constant(id);
+                return specialize(id, static_cast<std::uint32_t>(value));
+            }
+        }
+
+        [[nodiscard]] bool is_spirv() const noexcept;
+
+    private:
+        ShaderSource &reject_constant(unsigned int id);
+    };
+
+    // A shader that graphicat_add_shaders preprocessed, hashed and compiled into the binary.
+    struct EmbeddedShader {
+        ShaderType type;
+        std::string_view name;
+        std::string_view source;
+        std::uint64_t hash;
+
+        operator ShaderSource() const;
+    };
+
+    // Uniform names are only ever looked up by hash. Constructing one from a literal or string_view does not allocate, and the
+    // _uniform literal guarantees the hash is computed at compile time. A trailing "[N]" is also remembered as the array it
+    // indexes, since GL only reports the first element of an array.
+    struct UniformName {
+        std::uint64_t hash;
+        // Hash of the name without its trailing "[N]", or 0 if it has none.
+        std::uint64_t array_hash = 0;
+        std::uint32_t element = 0;
+
+        constexpr UniformName(const char *name) : UniformName(std::string_view(name)) {}
+        constexpr UniformName(std::string_view name) : hash(hash_string(name)) { parse_element(name); }
+        UniformName(const std::string &name) : UniformName(std::string_view(name)) {}
+
+    private:
+        constexpr void parse_element(std::string_view name) {
+            std::size_t open = name.rfind('[');
+            if (!name.ends_with(']') || open == std::string_view::npos || open + 2 >= name.size()) return;
+
+            std::uint32_t index = 0;
+            for (char c : name.substr(open + 1, name.size() - open - 2)) {
+                if (c < '0' || c > '9') return;
+                index = index * 10 + static_cast<std::uint32_t>(c - '0');
+            }
+            array_hash = hash_string(name.substr(0, open));
+            element = index;
+        }
+    };
+
+    namespace literals {
+        consteval UniformName operator""_uniform(const char *name, std::size_t length) {
+            return UniformName(std::string_view(name, length));
+        }
+    } // literals
+
+    struct UniformInfo {
+        std::uint64_t hash;
+        int location;
+        unsigned int type;
+        int array_size;
     };
 
+    struct UniformStats {
+        std::uint64_t issued = 0;
+        std::uint64_t skipped = 0;
+    };
+
+    class Buffer;
+    class PendingShader;
+
     class Shader {
+        struct UniformSlot {
+            std::uint32_t offset;
+            std::uint32_t size;
+            // GL type of the uniform.
+            std::uint32_t type;
+        };
+
         unsigned int handle;
         bool owned;
 
+        // Sorted by hash, filled once after link. Block members have no location and are left out.
+        std::vector<UniformInfo> uniforms;
+
+        // Last value sent for every active uniform location, so redundant uploads can be dropped.
+        std::vector<UniformSlot> slots;
+        mutable std::vector<std::byte> shadow;
+
+        // Bindings of the program's blocks, for tracing them back to buffers when barriers are needed.
+        std::vector<unsigned int> uniform_bindings;
+        std::vector<unsigned int> storage_bindings;
+
+        mutable std::optional<glm::uvec3> work_group_size;
+
+        // Atomic since programs can be touched from more than one thread.
+        inline static std::atomic<std::uint64_t> s_uniforms_issued = 0;
+        inline static std::atomic<std::uint64_t> s_uniforms_skipped = 0;
+
+        void reflect();
+        void reflect_blocks();
+        bool update_shadow(int location, const void *data, std::size_t size, GLenum setter) const;
+        void sync_block_reads() const;
+        void record_dispatch_writes(std::initializer_list<const Buffer *> writes) const;
+
+        friend class ProgramPipeline;
+
+    protected:
         Shader(unsigned int handle, bool owned);
 
     public:
@@ -36,130 +179,167 @@ namespace gc {
         static std::unique_ptr<Shader> create(const std::vector<ShaderSource>& sources);
         static std::unique_ptr<Shader> load(const std::vector<std::pair<ShaderType, std::filesystem::path>>& sources);
 
+        // Not registered anywhere: there are no sources to key a handle made elsewhere on.
         static std::shared_ptr<Shader> wrap_shared(unsigned int handle, bool take_ownership = true);
+        // Deduplicated through ShaderRegistry: identical sources give the same Shader, uniform values included.
         static std::shared_ptr<Shader> create_shared(const std::vector<ShaderSource>& sources);
         static std::shared_ptr<Shader> load_shared(const std::vector<std::pair<ShaderType, std::filesystem::path>>& sources);
 
+        // Submits every stage and the link without waiting on any of them. Issue all of a load's programs before polling or
+        // calling get() on the first so the driver (or the compile thread) can work through them in parallel.
+        static std::unique_ptr<PendingShader> create_async(const std::vector<ShaderSource>& sources);
+        static std::unique_ptr<PendingShader> load_async(const std::vector<std::pair<ShaderType, std::filesystem::path>>& sources);
+
+        // Also issues whatever barriers the program's blocks need after earlier dispatches wrote to them.
         void bind() const;
 
-        int get_uniform_location(const std::string& name) const;
+        [[nodiscard]] unsigned int get_handle() const noexcept;
+
+        // Binds the program and dispatches it. `writes` lists the buffers the dispatch writes, so later reads of only those wait
+        // on it; left empty, every buffer at one of the program's storage block bindings is assumed to be written.
+        void dispatch(const glm::uvec3 &groups, std::initializer_list<const Buffer *> writes = {}) const;
+        // Enough groups to cover `invocations`, rounding up to the work group size.
+        void dispatch_invocations(const glm::uvec3 &invocations, std::initializer_list<const Buffer *> writes = {}) const;
+        // Group counts come from a DispatchIndirectCommand (three uints) at `offset` in the buffer.
+        void dispatch_indirect(const Buffer &buffer, std::size_t offset = 0, std::initializer_list<const Buffer *> writes = {}) const;
+
+        // local_size_x/y/z of a compute program, queried once.
+        [[nodiscard]] glm::uvec3 get_work_group_size() const;
+
+        // Also resolves "name[N]" for any element of an array uniform; -1 past the end of the array.
+        [[nodiscard]] int get_uniform_location(UniformName name) const noexcept;
+        // Only the names GL reports, plus the bare name of each array.
+        [[nodiscard]] const UniformInfo *find_uniform(UniformName name) const noexcept;
+        [[nodiscard]] const std::vector<UniformInfo> &get_uniforms() const noexcept;
+
+        // Trades GL programs (and everything reflected from them) with `other`, then copies over the values of uniforms the two
+        // programs have in common, so the new program picks up where the old one was. Used to swap in a rebuilt program under
+        // everyone holding this Shader.
+        void swap_program(Shader &other);
+
+        // Re-reads the shadow copy from GL. Only needed if the program's uniforms were changed behind this object's back.
+        void sync_uniforms();
+
+        // Counts uniform uploads that reached GL versus ones dropped because the value was unchanged. Reset once per frame.
+        [[nodiscard]] static UniformStats get_uniform_stats() noexcept;
+        static void reset_uniform_stats() noexcept;
 
-        void uniform_1f(const std::string& name, const float &x) const;
+        void uniform_1f(UniformName name, const float &x) const;
         void uniform_1f(int location, const float &x) const;
-        void uniform_1f(const std::string& name, const glm::vec1 &v) const;
+        void uniform_1f(UniformName name, const glm::vec1 &v) const;
         void uniform_1f(int location, const glm::vec1 &v) const;
 
-        void uniform_2f(const std::string& name, const float &x, const float &y) const;
+        void uniform_2f(UniformName name, const float &x, const float &y) const;
         void uniform_2f(int location, const float &x, const float &y) const;
-        void uniform_2f(const std::string& name, const glm::vec2 &v) const;
+        void uniform_2f(UniformName name, const glm::vec2 &v) const;
         void uniform_2f(int location, const glm::vec2 &v) const;
 
-        void uniform_3f(const std::string& name, const float &x, const float &y, const float &z) const;
+        void uniform_3f(UniformName name, const float &x, const float &y, const float &z) const;
         void uniform_3f(int location, const float &x, const float &y, const float &z) const;
-        void uniform_3f(const std::string& name, const glm::vec3 &v) const;
+        void uniform_3f(UniformName name, const glm::vec3 &v) const;
         void uniform_3f(int location, const glm::vec3 &v) const;
 
-        void uniform_4f(const std::string& name, const float &x, const float &y, const float &z, const float &w) const;
+        void uniform_4f(UniformName name, const float &x, const float &y, const float &z, const float &w) const;
         void uniform_4f(int location, const float &x, const float &y, const float &z, const float &w) const;
-        void uniform_4f(const std::string& name, const glm::vec4 &v) const;
+        void uniform_4f(UniformName name, const glm::vec4 &v) const;
         void uniform_4f(int location, const glm::vec4 &v) const;
 
-        void uniform_1i(const std::string& name, const int &x) const;
+        void uniform_1i(UniformName name, const int &x) const;
         void uniform_1i(int location, const int &x) const;
-        void uniform_1i(const std::string& name, const glm::ivec1 &v) const;
+        void uniform_1i(UniformName name, const glm::ivec1 &v) const;
         void uniform_1i(int location, const glm::ivec1 &v) const;
 
-        void uniform_2i(const std::string& name, const int &x, const int &y) const;
+        void uniform_2i(UniformName name, const int &x, const int &y) const;
         void uniform_2i(int location, const int &x, const int &y) const;
-        void uniform_2i(const std::string& name, const glm::ivec2 &v) const;
+        void uniform_2i(UniformName name, const glm::ivec2 &v) const;
         void uniform_2i(int location, const glm::ivec2 &v) const;
 
-        void uniform_3i(const std::string& name, const int &x, const int &y, const int &z) const;
+        void uniform_3i(UniformName name, const int &x, const int &y, const int &z) const;
         void uniform_3i(int location, const int &x, const int &y, const int &z) const;
-        void uniform_3i(const std::string& name, const glm::ivec3 &v) const;
+        void uniform_3i(UniformName name, const glm::ivec3 &v) const;
         void uniform_3i(int location, const glm::ivec3 &v) const;
 
-        void uniform_4i(const std::string& name, const int &x, const int &y, const int &z, const int &w) const;
+        void uniform_4i(UniformName name, const int &x, const int &y, const int &z, const int &w) const;
         void uniform_4i(int location, const int &x, const int &y, const int &z, const int &w) const;
-        void uniform_4i(const std::string& name, const glm::ivec4 &v) const;
+        void uniform_4i(UniformName name, const glm::ivec4 &v) const;
         void uniform_4i(int location, const glm::ivec4 &v) const;
 
-        void uniform_1ui(const std::string& name, const unsigned int &x) const;
+        void uniform_1ui(UniformName name, const unsigned int &x) const;
         void uniform_1ui(int location, const unsigned int &x) const;
-        void uniform_1ui(const std::string& name, const glm::uvec1 &v) const;
+        void uniform_1ui(UniformName name, const glm::uvec1 &v) const;
         void uniform_1ui(int location, const glm::uvec1 &v) const;
 
-        void uniform_2ui(const std::string& name, const unsigned int &x, const unsigned int &y) const;
+        void uniform_2ui(UniformName name, const unsigned int &x, const unsigned int &y) const;
         void uniform_2ui(int location, const unsigned int &x, const unsigned int &y) const;
-        void uniform_2ui(const std::string& name, const glm::uvec2 &v) const;
+        void uniform_2ui(UniformName name, const glm::uvec2 &v) const;
         void uniform_2ui(int location, const glm::uvec2 &v) const;
 
-        void uniform_3ui(const std::string& name, const unsigned int &x, const unsigned int &y, const unsigned int &z) const;
+        void uniform_3ui(UniformName name, const unsigned int &x, const unsigned int &y, const unsigned int &z) const;
         void uniform_3ui(int location, const unsigned int &x, const unsigned int &y, const unsigned int &z) const;
-        void uniform_3ui(const std::string& name, const glm::uvec3 &v) const;
+        void uniform_3ui(UniformName name, const glm::uvec3 &v) const;
         void uniform_3ui(int location, const glm::uvec3 &v) const;
 
-        void uniform_4ui(const std::string& name, const unsigned int &x, const unsigned int &y, const unsigned int &z, const unsigned int &w) const;
+        void uniform_4ui(UniformName name, const unsigned int &x, const unsigned int &y, const unsigned int &z, const unsigned int &w) const;
         void uniform_4ui(int location, const unsigned int &x, const unsigned int &y, const unsigned int &z, const unsigned int &w) const;
-        void uniform_4ui(const std::string& name, const glm::uvec4 &v) const;
+        void uniform_4ui(UniformName name, const glm::uvec4 &v) const;
         void uniform_4ui(int location, const glm::uvec4 &v) const;
 
-        void uniform_1d(const std::string& name, const double &x) const;
+        void uniform_1d(UniformName name, const double &x) const;
         void uniform_1d(int location, const double &x) const;
-        void uniform_1d(const std::string& name, const glm::dvec1 &v) const;
+        void uniform_1d(UniformName name, const glm::dvec1 &v) const;
         void uniform_1d(int location, const glm::dvec1 &v) const;
 
-        void uniform_2d(const std::string& name, const double &x, const double &y) const;
+        void uniform_2d(UniformName name, const double &x, const double &y) const;
         void uniform_2d(int location, const double &x, const double &y) const;
-        void uniform_2d(const std::string& name, const glm::dvec2 &v) const;
+        void uniform_2d(UniformName name, const glm::dvec2 &v) const;
         void uniform_2d(int location, const glm::dvec2 &v) const;
 
-        void uniform_3d(const std::string& name, const double &x, const double &y, const double &z) const;
+        void uniform_3d(UniformName name, const double &x, const double &y, const double &z) const;
         void uniform_3d(int location, const double &x, const double &y, const double &z) const;
-        void uniform_3d(const std::string& name, const glm::dvec3 &v) const;
+        void uniform_3d(UniformName name, const glm::dvec3 &v) const;
         void uniform_3d(int location, const glm::dvec3 &v) const;
 
-        void uniform_4d(const std::string& name, const double &x, const double &y, const double &z, const double &w) const;
+        void uniform_4d(UniformName name, const double &x, const double &y, const double &z, const double &w) const;
         void uniform_4d(int location, const double &x, const double &y, const double &z, const double &w) const;
-        void uniform_4d(const std::string& name, const glm::dvec4 &v) const;
+        void uniform_4d(UniformName name, const glm::dvec4 &v) const;
         void uniform_4d(int location, const glm::dvec4 &v) const;
 
-        void uniform_mat2f(const std::string& name, const glm::mat2 &m) const;
+        void uniform_mat2f(UniformName name, const glm::mat2 &m) const;
         void uniform_mat2f(int location, const glm::mat2 &m) const;
-        void uniform_mat2x3f(const std::string& name, const glm::mat2x3 &m) const;
+        void uniform_mat2x3f(UniformName name, const glm::mat2x3 &m) const;
         void uniform_mat2x3f(int location, const glm::mat2x3 &m) const;
-        void uniform_mat2x4f(const std::string& name, const glm::mat2x4 &m) const;
+        void uniform_mat2x4f(UniformName name, const glm::mat2x4 &m) const;
         void uniform_mat2x4f(int location, const glm::mat2x4 &m) const;
-        void uniform_mat3f(const std::string& name, const glm::mat3 &m) const;
+        void uniform_mat3f(UniformName name, const glm::mat3 &m) const;
         void uniform_mat3f(int location, const glm::mat3 &m) const;
-        void uniform_mat3x2f(const std::string& name, const glm::mat3x2 &m) const;
+        void uniform_mat3x2f(UniformName name, const glm::mat3x2 &m) const;
         void uniform_mat3x2f(int location, const glm::mat3x2 &m) const;
-        void uniform_mat3x4f(const std::string& name, const glm::mat3x4 &m) const;
+        void uniform_mat3x4f(UniformName name, const glm::mat3x4 &m) const;
         void uniform_mat3x4f(int location, const glm::mat3x4 &m) const;
-        void uniform_mat4f(const std::string& name, const glm::mat4 &m) const;
+        void uniform_mat4f(UniformName name, const glm::mat4 &m) const;
         void uniform_mat4f(int location, const glm::mat4 &m) const;
-        void uniform_mat4x2f(const std::string& name, const glm::mat4x2 &m) const;
+        void uniform_mat4x2f(UniformName name, const glm::mat4x2 &m) const;
         void uniform_mat4x2f(int location, const glm::mat4x2 &m) const;
-        void uniform_mat4x3f(const std::string& name, const glm::mat4x3 &m) const;
+        void uniform_mat4x3f(UniformName name, const glm::mat4x3 &m) const;
         void uniform_mat4x3f(int location, const glm::mat4x3 &m) const;
 
-        void uniform_mat2d(const std::string& name, const glm::dmat2 &m) const;
+        void uniform_mat2d(UniformName name, const glm::dmat2 &m) const;
         void uniform_mat2d(int location, const glm::dmat2 &m) const;
-        void uniform_mat2x3d(const std::string& name, const glm::dmat2x3 &m) const;
+        void uniform_mat2x3d(UniformName name, const glm::dmat2x3 &m) const;
         void uniform_mat2x3d(int location, const glm::dmat2x3 &m) const;
-        void uniform_mat2x4d(const std::string& name, const glm::dmat2x4 &m) const;
+        void uniform_mat2x4d(UniformName name, const glm::dmat2x4 &m) const;
         void uniform_mat2x4d(int location, const glm::dmat2x4 &m) const;
-        void uniform_mat3d(const std::string& name, const glm::dmat3 &m) const;
+        void uniform_mat3d(UniformName name, const glm::dmat3 &m) const;
         void uniform_mat3d(int location, const glm::dmat3 &m) const;
-        void uniform_mat3x2d(const std::string& name, const glm::dmat3x2 &m) const;
+        void uniform_mat3x2d(UniformName name, const glm::dmat3x2 &m) const;
         void uniform_mat3x2d(int location, const glm::dmat3x2 &m) const;
-        void uniform_mat3x4d(const std::string& name, const glm::dmat3x4 &m) const;
+        void uniform_mat3x4d(UniformName name, const glm::dmat3x4 &m) const;
         void uniform_mat3x4d(int location, const glm::dmat3x4 &m) const;
-        void uniform_mat4d(const std::string& name, const glm::dmat4 &m) const;
+        void uniform_mat4d(UniformName name, const glm::dmat4 &m) const;
         void uniform_mat4d(int location, const glm::dmat4 &m) const;
-        void uniform_mat4x2d(const std::string& name, const glm::dmat4x2 &m) const;
+        void uniform_mat4x2d(UniformName name, const glm::dmat4x2 &m) const;
         void uniform_mat4x2d(int location, const glm::dmat4x2 &m) const;
-        void uniform_mat4x3d(const std::string& name, const glm::dmat4x3 &m) const;
+        void uniform_mat4x3d(UniformName name, const glm::dmat4x3 &m) const;
         void uniform_mat4x3d(int location, const glm::dmat4x3 &m) const;
 
         void bind_attrib_location(const std::string& name, int location) const;
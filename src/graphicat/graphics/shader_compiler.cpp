@@ -0,0 +1,168 @@
+#include "shader_compiler.hpp"
+#include "graphicat/os/window.hpp"
+#include <spdlog/spdlog.h>
+
+namespace gc {
+
+    ShaderCompiler::ShaderCompiler() {
+        parallel = GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+
+        if (parallel) {
+            // Let the driver pick how many threads to use.
+            if (GLAD_GL_KHR_parallel_shader_compile)
+                glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+            else
+                glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+            return;
+        }
+
+        main_context = glfwGetCurrentContext();
+
+        // Contexts only share objects if they agree on robustness, so mirror the main context's.
+        ContextProperties properties{};
+        properties.debug = glfwGetWindowAttrib(main_context, GLFW_OPENGL_DEBUG_CONTEXT);
+        properties.robustness = static_cast<ContextRobustness>(glfwGetWindowAttrib(main_context, GLFW_CONTEXT_ROBUSTNESS));
+
+        glfwDefaultWindowHints();
+        properties.apply();
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        shared_context = glfwCreateWindow(1, 1, "", nullptr, main_context);
+        glfwDefaultWindowHints();
+
+        if (!shared_context) {
+            spdlog::error("Failed to create a shared context for shader compilation; async builds will run on submit");
+            return;
+        }
+
+        worker = std::thread(&ShaderCompiler::run, this);
+    }
+
+    ShaderCompiler::~ShaderCompiler() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+
+        if (worker.joinable()) worker.join();
+        if (shared_context) glfwDestroyWindow(shared_context);
+    }
+
+    void ShaderCompiler::run() {
+        glfwMakeContextCurrent(shared_context);
+
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock lock(mutex);
+                condition.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) break;
+
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            job();
+        }
+
+        glfwMakeContextCurrent(nullptr);
+    }
+
+    bool ShaderCompiler::has_parallel_compile() const noexcept {
+        return parallel;
+    }
+
+    void ShaderCompiler::submit(std::function<void()> job) {
+        if (!worker.joinable()) {
+            job();
+            return;
+        }
+
+        {
+            std::lock_guard lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        condition.notify_one();
+    }
+
+    PendingShader::PendingShader(std::shared_ptr<State> state) : state(std::move(state)) {
+    }
+
+    PendingShader::~PendingShader() {
+        if (result || !state) return;
+
+        if (!state->threaded) {
+            detail::discard_program(state->build);
+            return;
+        }
+
+        std::lock_guard lock(state->mutex);
+        if (state->done)
+            glDeleteProgram(state->program);
+        else
+            state->abandoned = true;
+    }
+
+    bool PendingShader::is_ready() const {
+        if (result) return true;
+        if (state->threaded) return state->done;
+        return detail::is_program_build_complete(state->build);
+    }
+
+    std::shared_ptr<Shader> PendingShader::get() {
+        if (result) return result;
+
+        unsigned int program;
+        if (state->threaded) {
+            state->done.wait(false);
+            program = state->program;
+        } else {
+            program = detail::finish_program(state->build);
+        }
+
+        result = Shader::wrap_shared(program, true);
+        return result;
+    }
+
+    std::unique_ptr<PendingShader> Shader::create_async(const std::vector<ShaderSource> &sources) {
+        auto state = std::make_shared<PendingShader::State>();
+        ShaderCompiler *compiler = GlobalState::get() ? GlobalState::get()->get_shader_compiler() : nullptr;
+
+        if (!compiler || compiler->has_parallel_compile()) {
+            // Without a compiler (no GlobalState) this degrades to a plain build that finishes in get().
+            state->build = detail::submit_program(sources);
+            auto pending = std::unique_ptr<PendingShader>(new PendingShader(std::move(state)));
+
+            // Without parallel compile nothing finishes the build in the background, so is_ready() would never turn true for
+            // someone polling it; finish it here instead.
+            if (!GLAD_GL_KHR_parallel_shader_compile && !GLAD_GL_ARB_parallel_shader_compile) pending->get();
+            return pending;
+        }
+
+        state->threaded = true;
+        compiler->submit([state, sources] {
+            detail::ProgramBuild build = detail::submit_program(sources);
+            unsigned int program = detail::finish_program(build);
+
+            // The program has to be complete before the main context can use it.
+            glFinish();
+
+            std::lock_guard lock(state->mutex);
+            if (state->abandoned) {
+                glDeleteProgram(program);
+                return;
+            }
+
+            state->program = program;
+            state->done = true;
+            state->done.notify_all();
+        });
+
+        return std::unique_ptr<PendingShader>(new PendingShader(std::move(state)));
+    }
+
+    std::unique_ptr<PendingShader> Shader::load_async(const std::vector<std::pair<ShaderType, std::filesystem::path>> &sources) {
+        return create_async(detail::read_sources(sources));
+    }
+
+} // gc
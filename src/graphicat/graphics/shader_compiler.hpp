@@ -0,0 +1,110 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/shader.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct GLFWwindow;
+
+namespace gc {
+
+    namespace detail {
+        // A program whose stages have been submitted and linked, but whose status nobody has looked at yet.
+        struct ProgramBuild {
+            unsigned int program = 0;
+            std::vector<unsigned int> modules;
+            std::uint64_t key = 0;
+            bool cached = false;
+
+            // For ShaderProfiler.
+            std::string label;
+            std::size_t stages = 0;
+            std::size_t source_size = 0;
+            std::chrono::steady_clock::time_point started;
+            std::chrono::steady_clock::duration compile_time{}, link_time{}, cache_time{};
+        };
+
+        // Separable programs can be combined with others in a ProgramPipeline.
+        ProgramBuild submit_program(const std::vector<ShaderSource> &sources, bool separable = false);
+        // Only meaningful with GL_KHR_parallel_shader_compile (or the ARB version); without it, anything but a cached program is
+        // reported as not ready and finish_program() has to block on it.
+        bool is_program_build_complete(const ProgramBuild &build);
+        // Blocks on the compile and link results, logs failures, and returns the program or 0.
+        unsigned int finish_program(ProgramBuild &build);
+        void discard_program(ProgramBuild &build);
+
+        // Stage type, normalized text (or SPIR-V and its specialization) of one source.
+        std::uint64_t hash_source(const ShaderSource &source);
+
+        std::vector<ShaderSource> read_sources(const std::vector<std::pair<ShaderType, std::filesystem::path>> &sources);
+    } // detail
+
+    // Owns whatever the driver needs to build programs off the render thread. With GL_KHR_parallel_shader_compile (or the ARB
+    // version) the driver does the work on its own threads. Otherwise jobs run on a worker thread with a hidden context that shares
+    // objects with the context that was current when the compiler was created.
+    class ShaderCompiler {
+        GLFWwindow *shared_context = nullptr;
+        GLFWwindow *main_context = nullptr;
+        std::thread worker;
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<std::function<void()>> jobs;
+        bool stopping = false;
+        bool parallel;
+
+        void run();
+
+    public:
+        // Must be created on the GL thread with a current context.
+        ShaderCompiler();
+        ~ShaderCompiler();
+
+        ShaderCompiler(const ShaderCompiler &) = delete;
+        ShaderCompiler &operator=(const ShaderCompiler &) = delete;
+
+        [[nodiscard]] bool has_parallel_compile() const noexcept;
+
+        // Runs the job on the worker thread with the shared context current. Jobs should glFinish before handing objects they
+        // created to the main context.
+        void submit(std::function<void()> job);
+    };
+
+    class PendingShader {
+        friend class Shader;
+
+        struct State {
+            detail::ProgramBuild build;
+            bool threaded = false;
+            std::atomic<bool> done = false;
+            std::mutex mutex;
+            bool abandoned = false;
+            unsigned int program = 0;
+        };
+
+        std::shared_ptr<State> state;
+        std::shared_ptr<Shader> result;
+
+        explicit PendingShader(std::shared_ptr<State> state);
+
+    public:
+        ~PendingShader();
+
+        PendingShader(const PendingShader &) = delete;
+        PendingShader &operator=(const PendingShader &) = delete;
+
+        // Never blocks.
+        [[nodiscard]] bool is_ready() const;
+        // Blocks until the program is built. A failed build gives a shader with handle 0, like Shader::create.
+        std::shared_ptr<Shader> get();
+    };
+
+} // gc
@@ -0,0 +1,243 @@
+#include "shader_preprocessor.hpp"
+#include "graphicat/util/hash.hpp"
+#include <fstream>
+#include <sstream>
+#include <spdlog/spdlog.h>
+
+namespace gc {
+
+    static constexpr int max_include_depth = 32;
+
+    static std::string path_key(const std::filesystem::path& path) {
+        std::error_code ec;
+        return std::filesystem::weakly_canonical(path, ec).string();
+    }
+
+    static std::string_view trim_front(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        return s;
+    }
+
+    // Returns the directive name and leaves `line` at its arguments, or an empty view if this isn't a directive.
+    static std::string_view directive(std::string_view& line) {
+        line = trim_front(line);
+        if (line.empty() || line.front() != '#') return {};
+        line = trim_front(line.substr(1));
+
+        std::size_t end = 0;
+        while (end < line.size() && line[end] != ' ' && line[end] != '\t' && line[end] != '\r') end++;
+        std::string_view name = line.substr(0, end);
+        line = trim_front(line.substr(end));
+        return name;
+    }
+
+    ShaderPreprocessor::ShaderPreprocessor(std::vector<std::filesystem::path> include_directories)
+        : include_directories(std::move(include_directories)) {
+    }
+
+    void ShaderPreprocessor::add_include_directory(const std::filesystem::path &directory) {
+        include_directories.push_back(directory);
+    }
+
+    std::shared_ptr<const ShaderPreprocessor::ParsedFile> ShaderPreprocessor::parse(const std::filesystem::path &path, std::string_view text) {
+        auto file = std::make_shared<ParsedFile>();
+        file->path = path;
+
+        Chunk chunk;
+        unsigned int line_number = 0;
+        while (!text.empty()) {
+            std::size_t end = text.find('\n');
+            std::string_view line = text.substr(0, end);
+            text = end == std::string_view::npos ? std::string_view{} : text.substr(end + 1);
+            line_number++;
+
+            std::string_view args = line;
+            std::string_view name = directive(args);
+
+            if (name == "include" && !args.empty() && (args.front() == '"' || args.front() == '<')) {
+                char close = args.front() == '"' ? '"' : '>';
+                std::size_t close_at = args.find(close, 1);
+                if (close_at != std::string_view::npos) {
+                    chunk.include = std::string(args.substr(1, close_at - 1));
+                    chunk.angled = close == '>';
+                    chunk.next_line = line_number + 1;
+                    file->chunks.push_back(std::move(chunk));
+                    chunk = {};
+                    continue;
+                }
+            }
+
+            if (name == "pragma" && args.starts_with("once")) {
+                file->once = true;
+                chunk.text += '\n'; // keep line numbers lined up
+                continue;
+            }
+
+            chunk.text += line;
+            chunk.text += '\n';
+        }
+
+        file->chunks.push_back(std::move(chunk));
+        return file;
+    }
+
+    std::shared_ptr<const ShaderPreprocessor::ParsedFile> ShaderPreprocessor::get_file(const std::filesystem::path &path) {
+        std::string key = path_key(path);
+        {
+            std::lock_guard lock(mutex);
+            if (auto it = files.find(key); it != files.end()) return it->second;
+        }
+
+        std::ifstream f(path, std::ios::in | std::ios::binary);
+        if (!f) return nullptr;
+
+        std::stringstream ss;
+        ss << f.rdbuf();
+        auto parsed = parse(path, ss.str());
+
+        std::lock_guard lock(mutex);
+        files[key] = parsed;
+        return parsed;
+    }
+
+    std::vector<std::filesystem::path> ShaderPreprocessor::candidates(const Chunk &chunk, const std::filesystem::path &from) const {
+        std::vector<std::filesystem::path> paths;
+        if (!chunk.angled) paths.push_back(from.parent_path() / chunk.include);
+        for (const auto& directory : include_directories) paths.push_back(directory / chunk.include);
+        return paths;
+    }
+
+    std::optional<std::filesystem::path> ShaderPreprocessor::resolve(const Chunk &chunk, const std::filesystem::path &from) const {
+        for (auto& candidate : candidates(chunk, from)) {
+            if (std::filesystem::exists(candidate)) return candidate;
+        }
+        return std::nullopt;
+    }
+
+    bool ShaderPreprocessor::expand(const ParsedFile &file, std::string &out, std::vector<std::filesystem::path> &dependencies,
+                                    std::unordered_set<std::string> &included_once, int depth) {
+        if (depth > max_include_depth) {
+            spdlog::error("Includes nested too deeply in {} (include cycle?)", file.path.string());
+            return false;
+        }
+
+        for (const auto& chunk : file.chunks) {
+            out += chunk.text;
+            if (chunk.include.empty()) continue;
+
+            auto path = resolve(chunk, file.path);
+            auto included = path ? get_file(*path) : nullptr;
+            if (!included) {
+                spdlog::error("Could not find {} included from {}", chunk.include, file.path.string());
+                if (!path) {
+                    auto missing = candidates(chunk, file.path);
+                    dependencies.insert(dependencies.end(), missing.begin(), missing.end());
+                }
+                return false;
+            }
+
+            if (included->once && !included_once.insert(path_key(*path)).second) {
+                out += "\n";
+                continue;
+            }
+
+            dependencies.push_back(*path);
+
+            out += "#line 1\n";
+            if (!expand(*included, out, dependencies, included_once, depth + 1)) return false;
+            out += "#line " + std::to_string(chunk.next_line) + "\n";
+        }
+
+        return true;
+    }
+
+    std::optional<PreprocessedSource> ShaderPreprocessor::process(const std::filesystem::path &path, const std::vector<std::string> &defines,
+                                                                  std::vector<std::filesystem::path> *failed_dependencies) {
+        auto file = get_file(path);
+        if (!file) {
+            spdlog::error("Could not read shader {}", path.string());
+            if (failed_dependencies) *failed_dependencies = {path};
+            return std::nullopt;
+        }
+
+        PreprocessedSource result;
+        result.dependencies.push_back(path);
+
+        std::string expanded;
+        std::unordered_set<std::string> included_once;
+        if (file->once) included_once.insert(path_key(path));
+        if (!expand(*file, expanded, result.dependencies, included_once, 0)) {
+            if (failed_dependencies) *failed_dependencies = std::move(result.dependencies);
+            return std::nullopt;
+        }
+
+        result.source = inject_defines(expanded, defines);
+        result.hash = hash_shader_source(result.source);
+        return result;
+    }
+
+    std::optional<PreprocessedSource> ShaderPreprocessor::process_source(std::string_view source, const std::filesystem::path &origin,
+                                                                         const std::vector<std::string> &defines) {
+        auto file = parse(origin, source);
+
+        PreprocessedSource result;
+        std::string expanded;
+        std::unordered_set<std::string> included_once;
+        if (!expand(*file, expanded, result.dependencies, included_once, 0)) return std::nullopt;
+
+        result.source = inject_defines(expanded, defines);
+        result.hash = hash_shader_source(result.source);
+        return result;
+    }
+
+    void ShaderPreprocessor::invalidate(const std::filesystem::path &path) {
+        std::lock_guard lock(mutex);
+        files.erase(path_key(path));
+    }
+
+    void ShaderPreprocessor::clear() {
+        std::lock_guard lock(mutex);
+        files.clear();
+    }
+
+    std::string ShaderPreprocessor::inject_defines(std::string_view source, const std::vector<std::string> &defines) {
+        if (defines.empty()) return std::string(source);
+
+        // #version has to stay the first thing in the shader, so the defines go right after it.
+        std::size_t insert_at = 0;
+        unsigned int version_line = 0;
+        std::string_view rest = source;
+        for (unsigned int line_number = 1; !rest.empty(); line_number++) {
+            std::size_t end = rest.find('\n');
+            std::string_view line = rest.substr(0, end);
+            std::string_view args = line;
+
+            if (directive(args) == "version") {
+                insert_at = static_cast<std::size_t>(line.data() - source.data()) + line.size() + (end == std::string_view::npos ? 0 : 1);
+                version_line = line_number;
+                break;
+            }
+
+            if (end == std::string_view::npos) break;
+            rest = rest.substr(end + 1);
+        }
+
+        std::string block;
+        if (insert_at == source.size() && !source.empty() && source.back() != '\n') block += '\n';
+        for (const auto& define : defines) {
+            std::size_t eq = define.find('=');
+            block += "#define ";
+            block += eq == std::string::npos ? define : define.substr(0, eq) + " " + define.substr(eq + 1);
+            block += '\n';
+        }
+        block += "#line " + std::to_string(version_line + 1) + "\n";
+
+        std::string out;
+        out.reserve(source.size() + block.size());
+        out.append(source.substr(0, insert_at));
+        out.append(block);
+        out.append(source.substr(insert_at));
+        return out;
+    }
+
+} // gc
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace gc {
+
+    struct PreprocessedSource {
+        std::string source;
+        std::uint64_t hash; // hash_shader_source(source)
+        // Every file that went into the source, starting with the root.
+        std::vector<std::filesystem::path> dependencies;
+    };
+
+    // Resolves #include "..." (relative to the including file, then the include directories) and #include <...> (include directories
+    // only), honours #pragma once, and injects #defines right after #version. Files are parsed once into text/include chunks and
+    // memoized, so expanding many variants of the same shader does not touch the disk again.
+    class ShaderPreprocessor {
+        struct Chunk {
+            std::string text;
+            std::string include;
+            bool angled = false;
+            unsigned int next_line = 0;
+        };
+
+        struct ParsedFile {
+            std::filesystem::path path;
+            std::vector<Chunk> chunks;
+            bool once = false;
+        };
+
+        std::vector<std::filesystem::path> include_directories;
+        std::unordered_map<std::string, std::shared_ptr<const ParsedFile>> files;
+        std::mutex mutex;
+
+        std::shared_ptr<const ParsedFile> get_file(const std::filesystem::path& path);
+        std::vector<std::filesystem::path> candidates(const Chunk& chunk, const std::filesystem::path& from) const;
+        std::optional<std::filesystem::path> resolve(const Chunk& chunk, const std::filesystem::path& from) const;
+        bool expand(const ParsedFile& file, std::string& out, std::vector<std::filesystem::path>& dependencies,
+                    std::unordered_set<std::string>& included_once, int depth);
+
+        static std::shared_ptr<const ParsedFile> parse(const std::filesystem::path& path, std::string_view text);
+
+    public:
+        explicit ShaderPreprocessor(std::vector<std::filesystem::path> include_directories = {});
+
+        void add_include_directory(const std::filesystem::path& directory);
+
+        // Defines are either "NAME" or "NAME=VALUE". Returns nothing (and logs) if an include can't be found; `failed_dependencies`
+        // then gets the files it got through plus every place the missing include was looked for, for a watcher to notice it
+        // being created.
+        std::optional<PreprocessedSource> process(const std::filesystem::path& path, const std::vector<std::string>& defines = {},
+                                                  std::vector<std::filesystem::path>* failed_dependencies = nullptr);
+        std::optional<PreprocessedSource> process_source(std::string_view source, const std::filesystem::path& origin,
+                                                         const std::vector<std::string>& defines = {});
+
+        // Drops the memoized copy of a file so the next expansion reads it again.
+        void invalidate(const std::filesystem::path& path);
+        void clear();
+
+        static std::string inject_defines(std::string_view source, const std::vector<std::string>& defines);
+    };
+
+} // gc
@@ -0,0 +1,148 @@
+#include "shader_profiler.hpp"
+#include <algorithm>
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+namespace gc {
+
+    static double sort_value(const ShaderBuildRecord &record, ShaderProfileSort sort) {
+        switch (sort) {
+        case ShaderProfileSort::Compile: return record.compile_ms;
+        case ShaderProfileSort::Link: return record.link_ms;
+        case ShaderProfileSort::Cache: return record.cache_ms;
+        case ShaderProfileSort::SourceSize: return static_cast<double>(record.source_size);
+        case ShaderProfileSort::BinaryLength: return static_cast<double>(record.binary_length);
+        default: return record.total_ms;
+        }
+    }
+
+    static std::string escape_json(const std::string &text) {
+        std::string out;
+        out.reserve(text.size());
+        for (char c : text) {
+            switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                    out += fmt::format("\\u{:04x}", c);
+                else
+                    out += c;
+            }
+        }
+        return out;
+    }
+
+    void ShaderProfiler::record(ShaderBuildRecord record, Clock::time_point started) {
+        if (!s_enabled.load(std::memory_order_relaxed)) return;
+        std::lock_guard lock(s_mutex);
+
+        if (s_records.empty()) s_epoch = started;
+        record.started_ms = std::chrono::duration<double, std::milli>(started - s_epoch).count();
+        s_last_end_ms = std::max(s_last_end_ms, record.started_ms + record.total_ms);
+
+        if (s_records.size() < max_records) {
+            s_records.push_back(std::move(record));
+        } else {
+            s_records[s_next] = std::move(record);
+            s_next = (s_next + 1) % max_records;
+        }
+    }
+
+    void ShaderProfiler::set_enabled(bool enabled) noexcept {
+        s_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool ShaderProfiler::is_enabled() noexcept {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    std::vector<ShaderBuildRecord> ShaderProfiler::get_records(ShaderProfileSort sort) {
+        std::vector<ShaderBuildRecord> records;
+        {
+            std::lock_guard lock(s_mutex);
+            records = s_records;
+        }
+
+        std::stable_sort(records.begin(), records.end(), [sort](const ShaderBuildRecord &a, const ShaderBuildRecord &b) {
+            return sort_value(a, sort) > sort_value(b, sort);
+        });
+        return records;
+    }
+
+    ShaderProfileTotals ShaderProfiler::get_totals() {
+        std::lock_guard lock(s_mutex);
+
+        ShaderProfileTotals totals;
+        for (const auto& record : s_records) {
+            totals.programs++;
+            totals.cached += record.cached;
+            totals.failed += record.failed;
+            totals.compile_ms += record.compile_ms;
+            totals.link_ms += record.link_ms;
+            totals.cache_ms += record.cache_ms;
+            totals.total_ms += record.total_ms;
+        }
+        totals.wall_ms = s_last_end_ms;
+        return totals;
+    }
+
+    void ShaderProfiler::log_report(ShaderProfileSort sort, std::size_t top) {
+        ShaderProfileTotals totals = get_totals();
+        auto records = get_records(sort);
+
+        spdlog::info("Shader builds: {} programs ({} from cache, {} failed), {:.2f} ms total over {:.2f} ms wall "
+                     "(compile {:.2f} ms, link {:.2f} ms, cache {:.2f} ms)",
+                     totals.programs, totals.cached, totals.failed, totals.total_ms, totals.wall_ms,
+                     totals.compile_ms, totals.link_ms, totals.cache_ms);
+
+        for (std::size_t i = 0; i < std::min(top, records.size()); i++) {
+            const auto &r = records[i];
+            spdlog::info("  {:>8.2f} ms  compile {:>8.2f}  link {:>8.2f}  cache {:>6.2f}  src {:>7}  bin {:>7}{}{}  {}",
+                         r.total_ms, r.compile_ms, r.link_ms, r.cache_ms, r.source_size, r.binary_length,
+                         r.cached ? "  cached" : "", r.failed ? "  FAILED" : "", r.label);
+        }
+    }
+
+    std::string ShaderProfiler::to_json(ShaderProfileSort sort) {
+        ShaderProfileTotals totals = get_totals();
+        auto records = get_records(sort);
+
+        std::string out = fmt::format("{{\n  \"totals\": {{\"programs\": {}, \"cached\": {}, \"failed\": {}, \"compile_ms\": {:.3f}, "
+                                      "\"link_ms\": {:.3f}, \"cache_ms\": {:.3f}, \"total_ms\": {:.3f}, \"wall_ms\": {:.3f}}},\n",
+                                      totals.programs, totals.cached, totals.failed, totals.compile_ms, totals.link_ms,
+                                      totals.cache_ms, totals.total_ms, totals.wall_ms);
+
+        out += "  \"programs\": [";
+        for (std::size_t i = 0; i < records.size(); i++) {
+            const auto &r = records[i];
+            out += fmt::format("{}\n    {{\"label\": \"{}\", \"key\": \"{:016x}\", \"cached\": {}, \"failed\": {}, \"stages\": {}, "
+                               "\"source_size\": {}, \"binary_length\": {}, \"started_ms\": {:.3f}, \"compile_ms\": {:.3f}, "
+                               "\"link_ms\": {:.3f}, \"cache_ms\": {:.3f}, \"total_ms\": {:.3f}}}",
+                               i ? "," : "", escape_json(r.label), r.key, r.cached, r.failed, r.stages, r.source_size,
+                               r.binary_length, r.started_ms, r.compile_ms, r.link_ms, r.cache_ms, r.total_ms);
+        }
+        out += records.empty() ? "]\n}\n" : "\n  ]\n}\n";
+        return out;
+    }
+
+    bool ShaderProfiler::write_json(const std::filesystem::path &path, ShaderProfileSort sort) {
+        std::ofstream f(path, std::ios::out | std::ios::trunc);
+        if (!f) {
+            spdlog::error("Can't write shader profile to {}", path.string());
+            return false;
+        }
+        f << to_json(sort);
+        return static_cast<bool>(f);
+    }
+
+    void ShaderProfiler::clear() {
+        std::lock_guard lock(s_mutex);
+        s_records.clear();
+        s_next = 0;
+        s_last_end_ms = 0;
+    }
+
+} // gc
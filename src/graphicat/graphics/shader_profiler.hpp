@@ -0,0 +1,93 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gc {
+
+    // One program build, from submission to the finished (or failed) program. Times are what the building thread spent in the
+    // calls, so with parallel compilation the compile and link columns are mostly time spent waiting on the driver's threads.
+    struct ShaderBuildRecord {
+        // Stage names joined with '+', or the key in hex if the sources had none.
+        std::string label;
+        std::uint64_t key = 0;
+        bool cached = false;
+        bool failed = false;
+        std::size_t stages = 0;
+        std::size_t source_size = 0;
+        // GL_PROGRAM_BINARY_LENGTH of the linked program, 0 if it failed.
+        std::int64_t binary_length = 0;
+        // Since the first build the profiler saw.
+        double started_ms = 0;
+        double compile_ms = 0;
+        double link_ms = 0;
+        // Binary cache lookup and, after a fresh link, storing the binary.
+        double cache_ms = 0;
+        double total_ms = 0;
+    };
+
+    struct ShaderProfileTotals {
+        std::size_t programs = 0;
+        std::size_t cached = 0;
+        std::size_t failed = 0;
+        double compile_ms = 0;
+        double link_ms = 0;
+        double cache_ms = 0;
+        double total_ms = 0;
+        // From the start of the first build to the end of the last one. Builds on other threads overlap, so this can be less than
+        // total_ms.
+        double wall_ms = 0;
+    };
+
+    enum class ShaderProfileSort {
+        Total,
+        Compile,
+        Link,
+        Cache,
+        SourceSize,
+        BinaryLength,
+    };
+
+    // Collects a record for every program built through Shader (sync, async, pipelines, and the binary cache) while enabled. Off
+    // by default; set_enabled(true) before loading, then call log_report or write_json to see where startup time went. Only the
+    // latest max_records builds are kept, so leaving it on under hot reload doesn't grow without bound.
+    class ShaderProfiler {
+        inline static std::vector<ShaderBuildRecord> s_records;
+        // Where the next record goes once s_records is full.
+        inline static std::size_t s_next = 0;
+        inline static std::chrono::steady_clock::time_point s_epoch;
+        inline static double s_last_end_ms = 0;
+        inline static std::atomic<bool> s_enabled = false;
+        inline static std::mutex s_mutex;
+
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr std::size_t max_records = 4096;
+
+        static void record(ShaderBuildRecord record, Clock::time_point started);
+
+        static void set_enabled(bool enabled) noexcept;
+        [[nodiscard]] static bool is_enabled() noexcept;
+
+        [[nodiscard]] static std::vector<ShaderBuildRecord> get_records(ShaderProfileSort sort = ShaderProfileSort::Total);
+        [[nodiscard]] static ShaderProfileTotals get_totals();
+
+        // Totals, then the `top` slowest programs by `sort`, through spdlog::info.
+        static void log_report(ShaderProfileSort sort = ShaderProfileSort::Total, std::size_t top = 10);
+
+        // {"totals": {...}, "programs": [...]}, with every program in `sort` order.
+        [[nodiscard]] static std::string to_json(ShaderProfileSort sort = ShaderProfileSort::Total);
+        static bool write_json(const std::filesystem::path &path, ShaderProfileSort sort = ShaderProfileSort::Total);
+
+        static void clear();
+    };
+
+} // gc
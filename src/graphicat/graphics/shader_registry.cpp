@@ -0,0 +1,76 @@
+#include "shader_registry.hpp"
+#include "shader_compiler.hpp"
+#include <algorithm>
+
+namespace gc {
+
+    std::uint64_t ShaderRegistry::key(const std::vector<ShaderSource> &sources) {
+        std::vector<std::uint64_t> stages;
+        stages.reserve(sources.size());
+        for (const auto& source : sources) {
+            stages.push_back(detail::hash_source(source));
+        }
+        std::sort(stages.begin(), stages.end());
+
+        std::uint64_t h = hash_seed;
+        for (auto stage : stages) {
+            h = hash_combine(h, stage);
+        }
+        return h;
+    }
+
+    std::shared_ptr<Shader> ShaderRegistry::find(std::uint64_t key) {
+        std::lock_guard lock(s_mutex);
+
+        auto it = s_programs.find(key);
+        std::shared_ptr<Shader> shader = it == s_programs.end() ? nullptr : it->second.lock();
+        if (shader) {
+            s_stats.hits++;
+        } else {
+            s_stats.misses++;
+            if (it != s_programs.end()) s_programs.erase(it);
+        }
+        return shader;
+    }
+
+    std::shared_ptr<Shader> ShaderRegistry::insert(std::uint64_t key, std::shared_ptr<Shader> shader) {
+        if (!shader || shader->get_handle() == 0) return shader;
+
+        std::lock_guard lock(s_mutex);
+        auto &entry = s_programs[key];
+        if (auto existing = entry.lock()) return existing;
+
+        entry = shader;
+        return shader;
+    }
+
+    std::shared_ptr<Shader> ShaderRegistry::get_or_create(const std::vector<ShaderSource> &sources,
+                                                          const std::function<std::shared_ptr<Shader>()> &create) {
+        std::uint64_t k = key(sources);
+        if (auto shader = find(k)) return shader;
+
+        // Not holding the lock while compiling; a build can take a while.
+        return insert(k, create());
+    }
+
+    void ShaderRegistry::prune() {
+        std::lock_guard lock(s_mutex);
+        std::erase_if(s_programs, [](const auto &entry) { return entry.second.expired(); });
+    }
+
+    std::size_t ShaderRegistry::size() {
+        std::lock_guard lock(s_mutex);
+        return s_programs.size();
+    }
+
+    ShaderRegistryStats ShaderRegistry::get_stats() {
+        std::lock_guard lock(s_mutex);
+        return s_stats;
+    }
+
+    void ShaderRegistry::reset_stats() {
+        std::lock_guard lock(s_mutex);
+        s_stats = {};
+    }
+
+} // gc
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/shader.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace gc {
+
+    struct ShaderRegistryStats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+
+        [[nodiscard]] double hit_rate() const noexcept {
+            return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses);
+        }
+    };
+
+    // Every program made through Shader::create_shared/load_shared (and ShaderVariants) is remembered here by a key of its
+    // stages, so another module asking for the same sources gets the program that already exists instead of a second copy.
+    // Only weak references are kept; a program goes away once nobody uses it.
+    class ShaderRegistry {
+        inline static std::unordered_map<std::uint64_t, std::weak_ptr<Shader>> s_programs;
+        inline static ShaderRegistryStats s_stats;
+        inline static std::mutex s_mutex;
+
+    public:
+        // Independent of stage order and of line endings and trailing whitespace in the sources.
+        static std::uint64_t key(const std::vector<ShaderSource> &sources);
+
+        static std::shared_ptr<Shader> find(std::uint64_t key);
+        // Keeps an existing live program for the key if there is one (another thread got there first) and returns that instead.
+        static std::shared_ptr<Shader> insert(std::uint64_t key, std::shared_ptr<Shader> shader);
+
+        // Looks the sources up and only calls `create` on a miss. Programs that failed to build are not remembered.
+        static std::shared_ptr<Shader> get_or_create(const std::vector<ShaderSource> &sources,
+                                                     const std::function<std::shared_ptr<Shader>()> &create);
+
+        // Drops entries whose program is gone.
+        static void prune();
+
+        [[nodiscard]] static std::size_t size();
+        [[nodiscard]] static ShaderRegistryStats get_stats();
+        static void reset_stats();
+    };
+
+} // gc
@@ -0,0 +1,124 @@
+#include "shader_reloader.hpp"
+#include "shader_compiler.hpp"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace gc {
+
+    ShaderReloader::ShaderReloader(std::shared_ptr<ShaderPreprocessor> preprocessor) : preprocessor(std::move(preprocessor)) {
+    }
+
+    std::unique_ptr<ShaderReloader> ShaderReloader::create(std::shared_ptr<ShaderPreprocessor> preprocessor) {
+        if (!preprocessor) preprocessor = std::make_shared<ShaderPreprocessor>();
+        return std::unique_ptr<ShaderReloader>(new ShaderReloader(std::move(preprocessor)));
+    }
+
+    bool ShaderReloader::expand(Entry &entry, std::vector<ShaderSource> &sources) {
+        std::vector<std::string> dependencies;
+        bool expanded = true;
+
+        for (const auto& [type, path] : entry.stages) {
+            // Watch the stage file even if it doesn't expand, so fixing it brings the shader back.
+            dependencies.push_back(FileWatcher::normalize(path));
+
+            std::vector<std::filesystem::path> failed;
+            auto processed = preprocessor->process(path, entry.defines, &failed);
+            if (!processed) {
+                // Includes it got through, and where a missing one would go, so creating it brings the shader back too.
+                for (const auto& dependency : failed) dependencies.push_back(FileWatcher::normalize(dependency));
+                expanded = false;
+                break;
+            }
+
+            sources.push_back(ShaderSource{type, std::move(processed->source)});
+            sources.back().hash = processed->hash;
+            sources.back().name = path.filename().string();
+            for (const auto& dependency : processed->dependencies) {
+                dependencies.push_back(FileWatcher::normalize(dependency));
+            }
+        }
+
+        // Also keep watching what the last good expansion used, which the broken file is most likely among.
+        if (!expanded) dependencies.insert(dependencies.end(), entry.dependencies.begin(), entry.dependencies.end());
+
+        std::sort(dependencies.begin(), dependencies.end());
+        dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+        for (const auto& dependency : dependencies) {
+            watcher.watch(dependency);
+        }
+
+        // Includes can come and go between edits, so this is redone every time.
+        entry.dependencies = std::move(dependencies);
+        return expanded;
+    }
+
+    std::shared_ptr<Shader> ShaderReloader::load(const std::vector<std::pair<ShaderType, std::filesystem::path>> &stages,
+                                                 const std::vector<std::string> &defines) {
+        Entry entry{{}, stages, defines, {}, nullptr};
+
+        std::vector<ShaderSource> sources;
+        if (!expand(entry, sources)) return nullptr;
+
+        auto shader = std::shared_ptr<Shader>(Shader::create(sources));
+        entry.shader = shader;
+        entries.push_back(std::move(entry));
+        return shader;
+    }
+
+    void ShaderReloader::update() {
+        // Shaders nobody holds anymore don't need rebuilding.
+        std::erase_if(entries, [](const Entry &entry) { return entry.shader.expired(); });
+
+        auto changed = watcher.poll();
+        for (const auto& path : changed) {
+            preprocessor->invalidate(path);
+        }
+
+        for (auto& entry : entries) {
+            bool dirty = std::any_of(changed.begin(), changed.end(), [&](const std::filesystem::path &path) {
+                return std::binary_search(entry.dependencies.begin(), entry.dependencies.end(), path.string());
+            });
+
+            if (dirty) {
+                std::vector<ShaderSource> sources;
+                if (expand(entry, sources)) {
+                    // Replaces (and abandons) a rebuild still in flight from an earlier save.
+                    entry.pending = Shader::create_async(sources);
+                } else {
+                    stats.failed++;
+                }
+            }
+
+            if (!entry.pending || !entry.pending->is_ready()) continue;
+
+            auto rebuilt = entry.pending->get();
+            entry.pending.reset();
+
+            auto shader = entry.shader.lock();
+            if (!shader) continue;
+
+            if (rebuilt->get_handle() == 0) {
+                spdlog::error("Reloading shader {} failed, keeping the previous program", entry.stages.front().second.string());
+                stats.failed++;
+                continue;
+            }
+
+            shader->swap_program(*rebuilt);
+            spdlog::info("Reloaded shader {}", entry.stages.front().second.string());
+            stats.reloaded++;
+        }
+    }
+
+    bool ShaderReloader::is_supported() const noexcept {
+        return watcher.is_supported();
+    }
+
+    const std::shared_ptr<ShaderPreprocessor> &ShaderReloader::get_preprocessor() const noexcept {
+        return preprocessor;
+    }
+
+    const ShaderReloadStats &ShaderReloader::get_stats() const noexcept {
+        return stats;
+    }
+
+} // gc
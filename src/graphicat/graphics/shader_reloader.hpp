@@ -0,0 +1,58 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/shader.hpp"
+#include "graphicat/graphics/shader_preprocessor.hpp"
+#include "graphicat/os/file_watcher.hpp"
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gc {
+
+    struct ShaderReloadStats {
+        std::uint64_t reloaded = 0;
+        std::uint64_t failed = 0;
+    };
+
+    // Recompiles shaders whose files (or anything they #include) change on disk, and swaps the new program in under the existing
+    // Shader so nobody has to re-fetch it. Rebuilds go through Shader::create_async and are picked up by update() once they are
+    // done, so a frame never waits on the driver. A rebuild that fails to compile keeps the old program running.
+    //
+    // Shaders loaded here are not shared through ShaderRegistry, since their code changes out from under the key they'd be stored at.
+    class ShaderReloader {
+        struct Entry {
+            std::weak_ptr<Shader> shader;
+            std::vector<std::pair<ShaderType, std::filesystem::path>> stages;
+            std::vector<std::string> defines;
+            std::vector<std::string> dependencies;
+            std::unique_ptr<PendingShader> pending;
+        };
+
+        FileWatcher watcher;
+        std::shared_ptr<ShaderPreprocessor> preprocessor;
+        std::vector<Entry> entries;
+        ShaderReloadStats stats;
+
+        explicit ShaderReloader(std::shared_ptr<ShaderPreprocessor> preprocessor);
+
+        bool expand(Entry &entry, std::vector<ShaderSource> &sources);
+
+    public:
+        static std::unique_ptr<ShaderReloader> create(std::shared_ptr<ShaderPreprocessor> preprocessor = nullptr);
+
+        // Expands and compiles the stages like ShaderVariants does, then keeps watching their files. Returns nullptr if the sources
+        // couldn't be expanded.
+        std::shared_ptr<Shader> load(const std::vector<std::pair<ShaderType, std::filesystem::path>> &stages,
+                                     const std::vector<std::string> &defines = {});
+
+        // Call once per frame, between frames. Starts rebuilds for changed files and swaps in the ones that have finished.
+        void update();
+
+        [[nodiscard]] bool is_supported() const noexcept;
+        [[nodiscard]] const std::shared_ptr<ShaderPreprocessor> &get_preprocessor() const noexcept;
+        [[nodiscard]] const ShaderReloadStats &get_stats() const noexcept;
+    };
+
+} // gc
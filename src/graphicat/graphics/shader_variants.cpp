@@ -0,0 +1,145 @@
+#include "shader_variants.hpp"
+#include "shader_compiler.hpp"
+#include "shader_registry.hpp"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace gc {
+
+    ShaderVariants::ShaderVariants(std::vector<std::pair<ShaderType, std::filesystem::path>> stages, std::shared_ptr<ShaderPreprocessor> preprocessor)
+        : stages(std::move(stages)), preprocessor(std::move(preprocessor)) {
+    }
+
+    std::shared_ptr<ShaderVariants> ShaderVariants::create(const std::vector<std::pair<ShaderType, std::filesystem::path>> &stages,
+                                                           std::shared_ptr<ShaderPreprocessor> preprocessor) {
+        if (!preprocessor) preprocessor = std::make_shared<ShaderPreprocessor>();
+        return std::shared_ptr<ShaderVariants>(new ShaderVariants(stages, std::move(preprocessor)));
+    }
+
+    std::vector<std::string> ShaderVariants::normalize(std::vector<std::string> defines) {
+        std::sort(defines.begin(), defines.end());
+        defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+        return defines;
+    }
+
+    std::uint64_t ShaderVariants::define_key(const std::vector<std::string> &defines) {
+        std::uint64_t key = hash_seed;
+        for (const auto& define : defines) {
+            key = hash_combine(key, hash_string(define));
+        }
+        return key;
+    }
+
+    std::optional<ShaderVariants::Expanded> ShaderVariants::expand(const std::vector<std::string> &defines) const {
+        Expanded expanded;
+
+        for (const auto& [type, path] : stages) {
+            auto processed = preprocessor->process(path, defines);
+            if (!processed) return std::nullopt;
+
+            expanded.sources.push_back(ShaderSource{type, std::move(processed->source)});
+            expanded.sources.back().hash = processed->hash;
+            expanded.sources.back().name = path.filename().string();
+            expanded.dependencies.insert(expanded.dependencies.end(), processed->dependencies.begin(), processed->dependencies.end());
+        }
+
+        expanded.hash = ShaderRegistry::key(expanded.sources);
+        return expanded;
+    }
+
+    std::shared_ptr<Shader> ShaderVariants::get(const std::vector<std::string> &defines) {
+        stats.requests++;
+
+        auto normalized = normalize(defines);
+        std::uint64_t key = define_key(normalized);
+        if (auto it = variants.find(key); it != variants.end()) return it->second.shader;
+
+        auto expanded = expand(normalized);
+        if (!expanded) return nullptr;
+
+        auto shader = ShaderRegistry::find(expanded->hash);
+        if (shader) {
+            stats.deduplicated++;
+        } else {
+            shader = ShaderRegistry::insert(expanded->hash, std::shared_ptr<Shader>(Shader::create(expanded->sources)));
+            stats.compiled++;
+        }
+
+        variants[key] = Variant{shader, std::move(expanded->dependencies)};
+        return shader;
+    }
+
+    void ShaderVariants::prewarm(const std::vector<std::vector<std::string>> &define_sets) {
+        struct Job {
+            std::uint64_t key;
+            std::uint64_t hash;
+            std::vector<std::filesystem::path> dependencies;
+            std::unique_ptr<PendingShader> pending;
+        };
+
+        std::vector<Job> jobs;
+        for (const auto& defines : define_sets) {
+            auto normalized = normalize(defines);
+            std::uint64_t key = define_key(normalized);
+            if (variants.contains(key)) continue;
+
+            auto expanded = expand(normalized);
+            if (!expanded) continue;
+
+            if (auto shader = ShaderRegistry::find(expanded->hash)) {
+                variants[key] = Variant{shader, std::move(expanded->dependencies)};
+                stats.deduplicated++;
+                continue;
+            }
+
+            // Two sets in the same list can expand to the same program; only submit it once.
+            if (std::any_of(jobs.begin(), jobs.end(), [&](const Job &job) { return job.hash == expanded->hash; })) {
+                jobs.push_back({key, expanded->hash, std::move(expanded->dependencies), nullptr});
+                continue;
+            }
+
+            jobs.push_back({key, expanded->hash, std::move(expanded->dependencies), Shader::create_async(expanded->sources)});
+        }
+
+        std::unordered_map<std::uint64_t, std::shared_ptr<Shader>> built;
+        for (auto& job : jobs) {
+            if (!job.pending) continue;
+            auto shader = ShaderRegistry::insert(job.hash, job.pending->get());
+            built[job.hash] = shader;
+            variants[job.key] = Variant{shader, std::move(job.dependencies)};
+            stats.compiled++;
+        }
+
+        for (auto& job : jobs) {
+            if (job.pending) continue;
+            variants[job.key] = Variant{built[job.hash], std::move(job.dependencies)};
+            stats.deduplicated++;
+        }
+    }
+
+    void ShaderVariants::clear() {
+        variants.clear();
+    }
+
+    std::vector<std::filesystem::path> ShaderVariants::get_dependencies() const {
+        std::vector<std::filesystem::path> dependencies;
+        for (const auto& [type, path] : stages) {
+            dependencies.push_back(path);
+        }
+        for (const auto& [key, variant] : variants) {
+            for (const auto& path : variant.dependencies) {
+                if (std::find(dependencies.begin(), dependencies.end(), path) == dependencies.end()) dependencies.push_back(path);
+            }
+        }
+        return dependencies;
+    }
+
+    const std::shared_ptr<ShaderPreprocessor> &ShaderVariants::get_preprocessor() const noexcept {
+        return preprocessor;
+    }
+
+    const ShaderVariantStats &ShaderVariants::get_stats() const noexcept {
+        return stats;
+    }
+
+} // gc
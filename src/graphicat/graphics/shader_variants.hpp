@@ -0,0 +1,69 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/shader.hpp"
+#include "graphicat/graphics/shader_preprocessor.hpp"
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gc {
+
+    struct ShaderVariantStats {
+        std::uint64_t requests = 0;
+        std::uint64_t compiled = 0;
+        // Define sets that expanded to a program someone had already compiled.
+        std::uint64_t deduplicated = 0;
+    };
+
+    // Permutations of one set of stage files. Asking for a define set ({"SKINNED", "FOG"}, in any order) expands the files with
+    // those defines and compiles the result the first time, then hands back the same shader after that. Define sets whose expanded
+    // sources come out identical share a program through ShaderRegistry, also with other ShaderVariants and Shader::create_shared.
+    class ShaderVariants {
+        struct Variant {
+            std::shared_ptr<Shader> shader;
+            std::vector<std::filesystem::path> dependencies;
+        };
+
+        struct Expanded {
+            std::vector<ShaderSource> sources;
+            std::vector<std::filesystem::path> dependencies;
+            std::uint64_t hash;
+        };
+
+        std::vector<std::pair<ShaderType, std::filesystem::path>> stages;
+        std::shared_ptr<ShaderPreprocessor> preprocessor;
+        std::unordered_map<std::uint64_t, Variant> variants;
+        ShaderVariantStats stats;
+
+        ShaderVariants(std::vector<std::pair<ShaderType, std::filesystem::path>> stages, std::shared_ptr<ShaderPreprocessor> preprocessor);
+
+        std::optional<Expanded> expand(const std::vector<std::string> &defines) const;
+
+        static std::vector<std::string> normalize(std::vector<std::string> defines);
+        static std::uint64_t define_key(const std::vector<std::string> &defines);
+
+    public:
+        // Passing a preprocessor shares its include directories and parsed-file cache between several variant sets.
+        static std::shared_ptr<ShaderVariants> create(const std::vector<std::pair<ShaderType, std::filesystem::path>> &stages,
+                                                      std::shared_ptr<ShaderPreprocessor> preprocessor = nullptr);
+
+        // Compiles on first request. Returns nullptr if the sources couldn't be expanded.
+        std::shared_ptr<Shader> get(const std::vector<std::string> &defines = {});
+
+        // Submits every listed variant at once through Shader::create_async and waits for them together, so the driver can build
+        // them in parallel instead of one at a time on first use.
+        void prewarm(const std::vector<std::vector<std::string>> &define_sets);
+
+        // Forgets every compiled variant, e.g. after one of the files changed. Shaders already handed out stay valid.
+        void clear();
+
+        [[nodiscard]] std::vector<std::filesystem::path> get_dependencies() const;
+        [[nodiscard]] const std::shared_ptr<ShaderPreprocessor> &get_preprocessor() const noexcept;
+        [[nodiscard]] const ShaderVariantStats &get_stats() const noexcept;
+    };
+
+} // gc
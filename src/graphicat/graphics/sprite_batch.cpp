@@ -0,0 +1,231 @@
+#include "sprite_batch.hpp"
+#include "state_cache.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GC_SPRITE_SSE2
+#endif
+
+namespace gc {
+
+    static constexpr size_t sprite_bytes = sizeof(SpriteVertex) * 4;
+
+    static constexpr const char *vertex_source = R"(#version 450
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 uv;
+layout(location = 2) in vec4 color;
+
+layout(location = 0) uniform mat4 projection;
+
+layout(location = 0) out vec2 v_uv;
+layout(location = 1) out vec4 v_color;
+
+void main() {
+    v_uv = uv;
+    v_color = color;
+    gl_Position = projection * vec4(position, 0.0, 1.0);
+}
+)";
+
+    static constexpr const char *fragment_source = R"(#version 450
+layout(binding = 0) uniform sampler2D sprite_texture;
+
+layout(location = 0) in vec2 v_uv;
+layout(location = 1) in vec4 v_color;
+
+layout(location = 0) out vec4 frag_color;
+
+void main() {
+    frag_color = texture(sprite_texture, v_uv) * v_color;
+}
+)";
+
+    static constexpr int projection_location = 0;
+
+    static std::uint32_t pack_uv(float u, float v) {
+        return pack_unorm(u, 65535.0f) | pack_unorm(v, 65535.0f) << 16;
+    }
+
+    // Corners go (0, 0), (1, 0), (1, 1), (0, 1) in the unit square, which is counter clockwise.
+    template<typename Sprite> static void expand(const Sprite &sprite, SpriteVertex *out) {
+        std::uint32_t uv[4] = {
+            sprite.uv_min,
+            (sprite.uv_max & 0xffffu) | (sprite.uv_min & 0xffff0000u),
+            sprite.uv_max,
+            (sprite.uv_min & 0xffffu) | (sprite.uv_max & 0xffff0000u),
+        };
+
+#ifdef GC_SPRITE_SSE2
+        const __m128 corner_x = _mm_setr_ps(0.0f, 1.0f, 1.0f, 0.0f);
+        const __m128 corner_y = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+
+        __m128 xs = _mm_add_ps(_mm_set1_ps(sprite.origin.x), _mm_add_ps(_mm_mul_ps(corner_x, _mm_set1_ps(sprite.axis_x.x)),
+                                                                           _mm_mul_ps(corner_y, _mm_set1_ps(sprite.axis_y.x))));
+        __m128 ys = _mm_add_ps(_mm_set1_ps(sprite.origin.y), _mm_add_ps(_mm_mul_ps(corner_x, _mm_set1_ps(sprite.axis_x.y)),
+                                                                           _mm_mul_ps(corner_y, _mm_set1_ps(sprite.axis_y.y))));
+        __m128 uvs = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(uv)));
+        __m128 colors = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(sprite.color)));
+
+        // Transpose the four x/y/uv/color columns into one 16 byte vertex per corner.
+        __m128 xy_low = _mm_unpacklo_ps(xs, ys);        // x0 y0 x1 y1
+        __m128 xy_high = _mm_unpackhi_ps(xs, ys);       // x2 y2 x3 y3
+        __m128 rest_low = _mm_unpacklo_ps(uvs, colors);  // uv0 c uv1 c
+        __m128 rest_high = _mm_unpackhi_ps(uvs, colors); // uv2 c uv3 c
+
+        auto *dst = reinterpret_cast<float *>(out);
+        _mm_store_ps(dst + 0, _mm_movelh_ps(xy_low, rest_low));
+        _mm_store_ps(dst + 4, _mm_movehl_ps(rest_low, xy_low));
+        _mm_store_ps(dst + 8, _mm_movelh_ps(xy_high, rest_high));
+        _mm_store_ps(dst + 12, _mm_movehl_ps(rest_high, xy_high));
+#else
+        static constexpr float corner_x[4] = {0.0f, 1.0f, 1.0f, 0.0f};
+        static constexpr float corner_y[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+        for (int i = 0; i < 4; i++) {
+            SpriteVertex vertex;
+            vertex.x = sprite.origin.x + corner_x[i] * sprite.axis_x.x + corner_y[i] * sprite.axis_y.x;
+            vertex.y = sprite.origin.y + corner_x[i] * sprite.axis_x.y + corner_y[i] * sprite.axis_y.y;
+            vertex.u = static_cast<std::uint16_t>(uv[i]);
+            vertex.v = static_cast<std::uint16_t>(uv[i] >> 16);
+            vertex.color = sprite.color;
+            std::memcpy(out + i, &vertex, sizeof(vertex));
+        }
+#endif
+    }
+
+    SpriteBatch::SpriteBatch(std::unique_ptr<Shader> shader, std::unique_ptr<StreamBuffer> vertices, std::unique_ptr<Buffer> indices,
+                             std::unique_ptr<VertexArray> vertex_array, std::uint32_t capacity, SpriteSortMode sort_mode)
+        : shader(std::move(shader)), vertices(std::move(vertices)), indices(std::move(indices)), vertex_array(std::move(vertex_array)),
+          capacity(capacity), sort_mode(sort_mode) {
+    }
+
+    std::unique_ptr<SpriteBatch> SpriteBatch::create(std::uint32_t max_sprites, unsigned int frames, SpriteSortMode sort_mode) {
+        max_sprites = std::max(max_sprites, 1u);
+
+        ShaderSource vertex{ShaderType::Vertex, vertex_source};
+        vertex.name = "sprite_batch.vert";
+        ShaderSource fragment{ShaderType::Fragment, fragment_source};
+        fragment.name = "sprite_batch.frag";
+        auto shader = Shader::create({vertex, fragment});
+        if (!shader) {
+            spdlog::error("Failed to build the sprite batch shaders");
+            return nullptr;
+        }
+
+        auto vertices = StreamBuffer::create(sprite_bytes * max_sprites, frames);
+        if (!vertices) return nullptr;
+
+        // Every sprite is the same two triangles, so one index buffer serves every draw; base vertex picks the sprites.
+        std::vector<std::uint32_t> quad_indices(static_cast<size_t>(max_sprites) * 6);
+        for (std::uint32_t i = 0; i < max_sprites; i++) {
+            std::uint32_t base = i * 4;
+            std::uint32_t *quad = &quad_indices[static_cast<size_t>(i) * 6];
+            quad[0] = base;
+            quad[1] = base + 1;
+            quad[2] = base + 2;
+            quad[3] = base + 2;
+            quad[4] = base + 3;
+            quad[5] = base;
+        }
+        auto indices = Buffer::load(quad_indices.size() * sizeof(std::uint32_t), quad_indices.data(), BufferUsage::StaticDraw);
+
+        auto vertex_array = VertexArray::create();
+        vertex_array->vertex_buffer(&vertices->get_buffer(), {
+            {2, offsetof(SpriteVertex, x), "position"},
+            {2, offsetof(SpriteVertex, u), "uv", GL_UNSIGNED_SHORT, true},
+            {4, offsetof(SpriteVertex, color), "color", GL_UNSIGNED_BYTE, true},
+        }, sizeof(SpriteVertex));
+        vertex_array->element_buffer(indices.get());
+
+        return std::unique_ptr<SpriteBatch>(new SpriteBatch(std::move(shader), std::move(vertices), std::move(indices),
+                                                            std::move(vertex_array), max_sprites, sort_mode));
+    }
+
+    void SpriteBatch::draw(unsigned int texture, glm::vec2 position, glm::vec2 size, const glm::vec4 &uv_rect, const glm::vec4 &color) {
+        sprites.push_back({position, {size.x, 0.0f}, {0.0f, size.y}, pack_uv(uv_rect.x, uv_rect.y), pack_uv(uv_rect.z, uv_rect.w),
+                           pack_rgba8(color), texture});
+    }
+
+    void SpriteBatch::draw(unsigned int texture, const glm::mat3x2 &transform, const glm::vec4 &uv_rect, const glm::vec4 &color) {
+        sprites.push_back({transform[2], transform[0], transform[1], pack_uv(uv_rect.x, uv_rect.y), pack_uv(uv_rect.z, uv_rect.w),
+                           pack_rgba8(color), texture});
+    }
+
+    void SpriteBatch::flush(const glm::mat4 &projection) {
+        if (sprites.empty()) return;
+
+        // Whatever earlier flushes this frame left of the region, in whole sprites.
+        size_t used = (vertices->get_used() + sizeof(SpriteVertex) - 1) / sizeof(SpriteVertex) * sizeof(SpriteVertex);
+        size_t room = (vertices->get_region_size() - std::min(used, vertices->get_region_size())) / sprite_bytes;
+        size_t count = std::min({sprites.size(), room, static_cast<size_t>(capacity)});
+        if (count < sprites.size()) {
+            spdlog::warn("SpriteBatch is out of room for this frame; dropping {} of {} sprites", sprites.size() - count, sprites.size());
+            stats.dropped += sprites.size() - count;
+        }
+        if (count == 0) {
+            sprites.clear();
+            return;
+        }
+
+        StreamAllocation allocation = vertices->allocate(count * sprite_bytes, sizeof(SpriteVertex));
+        auto *out = reinterpret_cast<SpriteVertex *>(allocation.data);
+
+        // Texture handles differ in their low bytes only, so the radix sort gets away with a pass or two.
+        order.clear();
+        if (sort_mode == SpriteSortMode::Texture) {
+            for (size_t i = 0; i < count; i++) order.push_key(sprites[i].texture, static_cast<std::uint32_t>(i));
+            order.sort();
+        } else {
+            for (size_t i = 0; i < count; i++) order.push_key(0, static_cast<std::uint32_t>(i));
+        }
+
+        auto items = order.get_items();
+        for (size_t i = 0; i < count; i++) expand(sprites[items[i].payload], out + i * 4);
+
+        shader->bind();
+        shader->uniform_mat4f(projection_location, projection);
+        vertex_array->bind();
+
+        auto first_vertex = static_cast<GLint>(allocation.offset / sizeof(SpriteVertex));
+        for (size_t run = 0; run < count;) {
+            unsigned int texture = sprites[items[run].payload].texture;
+            size_t end = run + 1;
+            while (end < count && sprites[items[end].payload].texture == texture) end++;
+
+            bind_texture_unit(0, texture);
+            glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>((end - run) * 6), GL_UNSIGNED_INT, nullptr,
+                                     first_vertex + static_cast<GLint>(run * 4));
+
+            stats.draw_calls++;
+            run = end;
+        }
+
+        stats.sprites += count;
+        sprites.clear();
+    }
+
+    void SpriteBatch::next_frame() {
+        vertices->next_frame();
+    }
+
+    void SpriteBatch::set_sort_mode(SpriteSortMode mode) noexcept {
+        sort_mode = mode;
+    }
+
+    std::size_t SpriteBatch::get_pending() const noexcept {
+        return sprites.size();
+    }
+
+    const SpriteBatchStats &SpriteBatch::get_stats() const noexcept {
+        return stats;
+    }
+
+    void SpriteBatch::reset_stats() noexcept {
+        stats = {};
+    }
+
+} // gc
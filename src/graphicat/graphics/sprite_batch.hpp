@@ -0,0 +1,104 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/buffer.hpp"
+#include "graphicat/graphics/render_queue.hpp"
+#include "graphicat/graphics/shader.hpp"
+#include "graphicat/graphics/stream_buffer.hpp"
+#include "graphicat/graphics/vertex_array.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace gc {
+
+    // What a sprite expands to, 16 bytes per corner: position, UV as unorm16 and color as unorm8.
+    struct SpriteVertex {
+        float x, y;
+        std::uint16_t u, v;
+        std::uint32_t color; // RGBA, R in the lowest byte
+    };
+
+    static_assert(sizeof(SpriteVertex) == 16);
+
+    enum class SpriteSortMode {
+        // Bucketed by texture, in submission order within a texture: one draw per texture. Sprites on different textures no longer
+        // draw in the order they were submitted, so overlap between them comes out wrong.
+        Texture,
+        // Submission order, with a new draw every time the texture changes.
+        Submission,
+    };
+
+    struct SpriteBatchStats {
+        std::uint64_t sprites = 0;
+        std::uint64_t draw_calls = 0;
+        // Sprites that didn't fit in the frame's share of the ring.
+        std::uint64_t dropped = 0;
+    };
+
+    // Draws textured quads in bulk. draw() only records a sprite; flush() sorts them by texture, expands each into four vertices
+    // straight into a persistently mapped StreamBuffer (four 16 byte SSE stores per sprite where SSE2 is available), and draws each
+    // texture's sprites with one glDrawElementsBaseVertex over a shared quad index buffer.
+    //
+    //     batch->draw(atlas, position, size, uv_rect);
+    //     batch->draw(atlas, glm::mat3x2(axis_x, axis_y, origin), uv_rect, color);
+    //     ...
+    //     batch->flush(glm::ortho(0.0f, width, 0.0f, height));
+    //     ...
+    //     batch->next_frame(); // after the frame's last flush
+    //
+    // Put several images in an atlas and they share a draw. Blending, depth and culling are left to whatever render state is
+    // current; sprites are wound counter clockwise for positive sizes.
+    class SpriteBatch {
+        struct Sprite {
+            glm::vec2 origin;
+            glm::vec2 axis_x;
+            glm::vec2 axis_y;
+            std::uint32_t uv_min; // unorm16 u in the low half, v in the high half
+            std::uint32_t uv_max;
+            std::uint32_t color;
+            unsigned int texture;
+        };
+
+        std::unique_ptr<Shader> shader;
+        std::unique_ptr<StreamBuffer> vertices;
+        std::unique_ptr<Buffer> indices;
+        std::unique_ptr<VertexArray> vertex_array;
+        std::uint32_t capacity;
+        SpriteSortMode sort_mode;
+
+        std::vector<Sprite> sprites;
+        RenderQueue order;
+        SpriteBatchStats stats;
+
+        SpriteBatch(std::unique_ptr<Shader> shader, std::unique_ptr<StreamBuffer> vertices, std::unique_ptr<Buffer> indices,
+                    std::unique_ptr<VertexArray> vertex_array, std::uint32_t capacity, SpriteSortMode sort_mode);
+
+    public:
+        // Room for `max_sprites` sprites per frame, over all flushes; the rest are dropped. nullptr if the shaders fail to build or
+        // the ring can't be mapped.
+        static std::unique_ptr<SpriteBatch> create(std::uint32_t max_sprites, unsigned int frames = 3,
+                                                   SpriteSortMode sort_mode = SpriteSortMode::Texture);
+
+        // An axis aligned sprite with its lower left corner at `position`. `uv_rect` is (u0, v0, u1, v1), with (u0, v0) going to
+        // that corner.
+        void draw(unsigned int texture, glm::vec2 position, glm::vec2 size, const glm::vec4 &uv_rect = {0.0f, 0.0f, 1.0f, 1.0f},
+                  const glm::vec4 &color = glm::vec4(1.0f));
+        // `transform` takes the unit square to the sprite: its columns are the x and y edges and the lower left corner.
+        void draw(unsigned int texture, const glm::mat3x2 &transform, const glm::vec4 &uv_rect = {0.0f, 0.0f, 1.0f, 1.0f},
+                  const glm::vec4 &color = glm::vec4(1.0f));
+
+        // Draws everything recorded since the last flush, then forgets it. Binds its own program, vertex array and texture unit 0.
+        void flush(const glm::mat4 &projection);
+
+        // Call once per frame, after the last flush.
+        void next_frame();
+
+        void set_sort_mode(SpriteSortMode mode) noexcept;
+
+        [[nodiscard]] std::size_t get_pending() const noexcept;
+        [[nodiscard]] const SpriteBatchStats &get_stats() const noexcept;
+        void reset_stats() noexcept;
+    };
+
+} // gc
@@ -0,0 +1,312 @@
+#include "state_cache.hpp"
+#include "render_state.hpp"
+#include <bit>
+#include <spdlog/spdlog.h>
+
+namespace gc {
+
+    struct GenericTarget {
+        GLenum target;
+        GLenum binding;
+    };
+
+    static constexpr GenericTarget generic_targets[] = {
+        {GL_ARRAY_BUFFER, GL_ARRAY_BUFFER_BINDING},
+        {GL_UNIFORM_BUFFER, GL_UNIFORM_BUFFER_BINDING},
+        {GL_SHADER_STORAGE_BUFFER, GL_SHADER_STORAGE_BUFFER_BINDING},
+        {GL_DRAW_INDIRECT_BUFFER, GL_DRAW_INDIRECT_BUFFER_BINDING},
+        {GL_DISPATCH_INDIRECT_BUFFER, GL_DISPATCH_INDIRECT_BUFFER_BINDING},
+        {GL_COPY_READ_BUFFER, GL_COPY_READ_BUFFER_BINDING},
+        {GL_COPY_WRITE_BUFFER, GL_COPY_WRITE_BUFFER_BINDING},
+        {GL_PIXEL_PACK_BUFFER, GL_PIXEL_PACK_BUFFER_BINDING},
+        {GL_PIXEL_UNPACK_BUFFER, GL_PIXEL_UNPACK_BUFFER_BINDING},
+        {GL_ATOMIC_COUNTER_BUFFER, GL_ATOMIC_COUNTER_BUFFER_BINDING},
+        {GL_QUERY_BUFFER, GL_QUERY_BUFFER_BINDING},
+        {GL_TEXTURE_BUFFER, GL_TEXTURE_BUFFER_BINDING},
+        {GL_PARAMETER_BUFFER, GL_PARAMETER_BUFFER_BINDING},
+    };
+
+    struct IndexedTarget {
+        GLenum target;
+        GLenum binding;
+        GLenum start;
+        GLenum size;
+    };
+
+    static constexpr IndexedTarget indexed_targets[] = {
+        {GL_UNIFORM_BUFFER, GL_UNIFORM_BUFFER_BINDING, GL_UNIFORM_BUFFER_START, GL_UNIFORM_BUFFER_SIZE},
+        {GL_SHADER_STORAGE_BUFFER, GL_SHADER_STORAGE_BUFFER_BINDING, GL_SHADER_STORAGE_BUFFER_START, GL_SHADER_STORAGE_BUFFER_SIZE},
+        {GL_ATOMIC_COUNTER_BUFFER, GL_ATOMIC_COUNTER_BUFFER_BINDING, GL_ATOMIC_COUNTER_BUFFER_START, GL_ATOMIC_COUNTER_BUFFER_SIZE},
+    };
+
+    static_assert(std::size(generic_targets) == 13 && std::size(indexed_targets) == 3);
+
+    StateCache::StateCache(bool validate) : validate(validate) {
+        invalidate();
+    }
+
+    int StateCache::generic_index(GLenum target) {
+        for (std::size_t i = 0; i < std::size(generic_targets); i++) {
+            if (generic_targets[i].target == target) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    int StateCache::indexed_index(GLenum target) {
+        for (std::size_t i = 0; i < std::size(indexed_targets); i++) {
+            if (indexed_targets[i].target == target) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    bool StateCache::skip(unsigned int &slot, unsigned int value) {
+        if (slot == value) {
+            stats.skipped++;
+            return true;
+        }
+        slot = value;
+        stats.issued++;
+        return false;
+    }
+
+    void StateCache::check(unsigned int &slot, GLenum query, const char *what) {
+        if (!validate || slot == unknown) return;
+
+        int actual;
+        glGetIntegerv(query, &actual);
+        if (static_cast<unsigned int>(actual) == slot) return;
+
+        spdlog::warn("State cache out of sync: {} is {} but the cache had {}", what, actual, slot);
+        stats.desyncs++;
+        slot = static_cast<unsigned int>(actual);
+    }
+
+    void StateCache::check_range(Range &slot, GLenum target, unsigned int index) {
+        if (!validate || slot.buffer == unknown) return;
+
+        const IndexedTarget &t = indexed_targets[indexed_index(target)];
+        int buffer;
+        GLint64 start, size;
+        glGetIntegeri_v(t.binding, index, &buffer);
+        glGetInteger64i_v(t.start, index, &start);
+        glGetInteger64i_v(t.size, index, &size);
+
+        Range actual{static_cast<unsigned int>(buffer), static_cast<std::size_t>(start), static_cast<std::size_t>(size)};
+        if (actual.buffer == slot.buffer && actual.offset == slot.offset && actual.size == slot.size) return;
+
+        spdlog::warn("State cache out of sync: indexed binding {} of 0x{:x} is {} [{}, +{}] but the cache had {} [{}, +{}]", index,
+                     target, actual.buffer, actual.offset, actual.size, slot.buffer, slot.offset, slot.size);
+        stats.desyncs++;
+        slot = actual;
+    }
+
+    void StateCache::check_render_state() {
+        if (!validate || !render_state) return;
+
+        // Just the switches; they're what raw glEnable/glDisable calls tend to leave behind.
+        const RenderStateDesc &desc = render_state->get_desc();
+        unsigned char depth_write;
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &depth_write);
+        if (glIsEnabled(GL_BLEND) == desc.blend.enabled && glIsEnabled(GL_DEPTH_TEST) == desc.depth.test &&
+            glIsEnabled(GL_STENCIL_TEST) == desc.stencil.test && glIsEnabled(GL_CULL_FACE) == desc.raster.cull &&
+            glIsEnabled(GL_POLYGON_OFFSET_FILL) == desc.raster.polygon_offset && (depth_write == GL_TRUE) == desc.depth.write) return;
+
+        spdlog::warn("State cache out of sync: fixed-function state doesn't match the current render state");
+        stats.desyncs++;
+        render_state.reset();
+    }
+
+    void StateCache::use_program(unsigned int value) {
+        check(program, GL_CURRENT_PROGRAM, "current program");
+        if (!skip(program, value)) glUseProgram(value);
+    }
+
+    void StateCache::bind_program_pipeline(unsigned int value) {
+        check(pipeline, GL_PROGRAM_PIPELINE_BINDING, "program pipeline");
+        if (!skip(pipeline, value)) glBindProgramPipeline(value);
+    }
+
+    void StateCache::bind_vertex_array(unsigned int value) {
+        check(vertex_array, GL_VERTEX_ARRAY_BINDING, "vertex array");
+        if (!skip(vertex_array, value)) glBindVertexArray(value);
+    }
+
+    void StateCache::bind_buffer(GLenum target, unsigned int buffer) {
+        int i = generic_index(target);
+        if (i < 0) {
+            stats.issued++;
+            glBindBuffer(target, buffer);
+            return;
+        }
+
+        check(buffers[i], generic_targets[i].binding, "buffer binding");
+        if (!skip(buffers[i], buffer)) glBindBuffer(target, buffer);
+    }
+
+    void StateCache::bind_buffer_base(GLenum target, unsigned int index, unsigned int buffer) {
+        bind_buffer_range(target, index, buffer, 0, 0);
+    }
+
+    void StateCache::bind_buffer_range(GLenum target, unsigned int index, unsigned int buffer, std::size_t offset, std::size_t size) {
+        int t = indexed_index(target);
+        if (t < 0 || index >= max_indexed_bindings) {
+            stats.issued++;
+            if (size == 0)
+                glBindBufferBase(target, index, buffer);
+            else
+                glBindBufferRange(target, index, buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+            return;
+        }
+
+        Range &slot = ranges[t][index];
+        check_range(slot, target, index);
+        if (slot.buffer == buffer && slot.offset == offset && slot.size == size) {
+            stats.skipped++;
+            return;
+        }
+
+        slot = {buffer, offset, size};
+        stats.issued++;
+        if (size == 0)
+            glBindBufferBase(target, index, buffer);
+        else
+            glBindBufferRange(target, index, buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+
+        // Indexed binds also replace the generic binding of the target.
+        buffers[generic_index(target)] = buffer;
+    }
+
+    void StateCache::bind_texture_unit(unsigned int unit, unsigned int texture) {
+        // Not validated: a unit has a binding per texture target, and glBindTextureUnit doesn't say which one it used.
+        if (unit >= max_texture_units) {
+            stats.issued++;
+            glBindTextureUnit(unit, texture);
+            return;
+        }
+
+        if (!skip(textures[unit], texture)) glBindTextureUnit(unit, texture);
+    }
+
+    void StateCache::bind_render_state(const RenderState &state) {
+        check_render_state();
+        if (render_state.get() == &state) {
+            stats.skipped++;
+            return;
+        }
+
+        stats.issued++;
+        stats.render_state_fields += std::popcount(state.apply(render_state.get()));
+        render_state = state.shared_from_this();
+    }
+
+    void StateCache::forget_program(unsigned int value) {
+        // A deleted program stays current until something else is used, but its name is no use to compare against anymore.
+        if (program == value) program = unknown;
+    }
+
+    void StateCache::forget_program_pipeline(unsigned int value) {
+        if (pipeline == value) pipeline = unknown;
+    }
+
+    void StateCache::forget_vertex_array(unsigned int value) {
+        if (vertex_array == value) vertex_array = unknown;
+    }
+
+    void StateCache::forget_buffer(unsigned int buffer) {
+        for (auto &slot : buffers) {
+            if (slot == buffer) slot = unknown;
+        }
+        for (auto &target : ranges) {
+            for (auto &slot : target) {
+                if (slot.buffer == buffer) slot = Range{};
+            }
+        }
+    }
+
+    void StateCache::forget_texture(unsigned int texture) {
+        for (auto &slot : textures) {
+            if (slot == texture) slot = unknown;
+        }
+    }
+
+    void StateCache::invalidate() {
+        program = unknown;
+        pipeline = unknown;
+        vertex_array = unknown;
+        buffers.fill(unknown);
+        for (auto &target : ranges) target.fill(Range{});
+        textures.fill(unknown);
+        render_state.reset();
+    }
+
+    void StateCache::set_validation(bool enabled) noexcept {
+        validate = enabled;
+    }
+
+    bool StateCache::is_validating() const noexcept {
+        return validate;
+    }
+
+    const StateCacheStats &StateCache::get_stats() const noexcept {
+        return stats;
+    }
+
+    void StateCache::reset_stats() noexcept {
+        stats = {};
+    }
+
+    StateCache *StateCache::get() {
+        GlobalState *state = GlobalState::get();
+        return state ? state->get_state_cache() : nullptr;
+    }
+
+    void use_program(unsigned int program) {
+        if (StateCache *cache = StateCache::get())
+            cache->use_program(program);
+        else
+            glUseProgram(program);
+    }
+
+    void bind_program_pipeline(unsigned int pipeline) {
+        if (StateCache *cache = StateCache::get())
+            cache->bind_program_pipeline(pipeline);
+        else
+            glBindProgramPipeline(pipeline);
+    }
+
+    void bind_vertex_array(unsigned int vertex_array) {
+        if (StateCache *cache = StateCache::get())
+            cache->bind_vertex_array(vertex_array);
+        else
+            glBindVertexArray(vertex_array);
+    }
+
+    void bind_buffer(GLenum target, unsigned int buffer) {
+        if (StateCache *cache = StateCache::get())
+            cache->bind_buffer(target, buffer);
+        else
+            glBindBuffer(target, buffer);
+    }
+
+    void bind_buffer_base(GLenum target, unsigned int index, unsigned int buffer) {
+        if (StateCache *cache = StateCache::get())
+            cache->bind_buffer_base(target, index, buffer);
+        else
+            glBindBufferBase(target, index, buffer);
+    }
+
+    void bind_buffer_range(GLenum target, unsigned int index, unsigned int buffer, std::size_t offset, std::size_t size) {
+        if (StateCache *cache = StateCache::get())
+            cache->bind_buffer_range(target, index, buffer, offset, size);
+        else
+            glBindBufferRange(target, index, buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+    }
+
+    void bind_texture_unit(unsigned int unit, unsigned int texture) {
+        if (StateCache *cache = StateCache::get())
+            cache->bind_texture_unit(unit, texture);
+        else
+            glBindTextureUnit(unit, texture);
+    }
+
+} // gc
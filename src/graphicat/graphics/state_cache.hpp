@@ -0,0 +1,111 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace gc {
+
+    class RenderState;
+
+    struct StateCacheStats {
+        std::uint64_t issued = 0;
+        // Binds dropped because the object was already bound there.
+        std::uint64_t skipped = 0;
+        // Validation found GL disagreeing with the cache; something bound behind its back without calling invalidate().
+        std::uint64_t desyncs = 0;
+        // RenderStateField groups actually issued when switching render states.
+        std::uint64_t render_state_fields = 0;
+    };
+
+    // What the context currently has bound, so binding what's already there costs a compare instead of a GL call. Covers the
+    // program and pipeline, vertex array, the generic binding of each buffer target, indexed uniform/storage/atomic counter
+    // ranges, the texture on each unit, and the current RenderState. Shader, ProgramPipeline, VertexArray, Buffer, RenderState
+    // and CommandList bind through it, and forget their names when they are deleted.
+    //
+    // Slots start out unknown, so the first bind of each always goes through. Code that binds with raw GL calls has to call
+    // invalidate() afterwards. With validation on, every bind first compares the cache against glGet* and logs any mismatch;
+    // slow, but catches exactly that mistake. Only for the GL thread; GlobalState owns the one for the main context.
+    class StateCache {
+    public:
+        static constexpr unsigned int unknown = ~0u;
+
+    private:
+        static constexpr std::size_t generic_target_count = 13;
+        static constexpr std::size_t indexed_target_count = 3;
+        static constexpr std::size_t max_indexed_bindings = 64;
+        static constexpr std::size_t max_texture_units = 64;
+
+        struct Range {
+            unsigned int buffer = unknown;
+            std::size_t offset = 0;
+            // 0 for glBindBufferBase, which is also what GL reports for it.
+            std::size_t size = 0;
+        };
+
+        unsigned int program = unknown;
+        unsigned int pipeline = unknown;
+        unsigned int vertex_array = unknown;
+        std::array<unsigned int, generic_target_count> buffers;
+        std::array<std::array<Range, max_indexed_bindings>, indexed_target_count> ranges;
+        std::array<unsigned int, max_texture_units> textures;
+        // Kept alive so the pointer can't be reused by a new state while it's current.
+        std::shared_ptr<const RenderState> render_state;
+
+        bool validate;
+        StateCacheStats stats;
+
+        // -1 for targets that aren't cached (the element array binding belongs to the vertex array).
+        static int generic_index(GLenum target);
+        static int indexed_index(GLenum target);
+
+        bool skip(unsigned int &slot, unsigned int value);
+        void check(unsigned int &slot, GLenum query, const char *what);
+        void check_range(Range &slot, GLenum target, unsigned int index);
+        void check_render_state();
+
+    public:
+        explicit StateCache(bool validate = false);
+
+        void use_program(unsigned int program);
+        void bind_program_pipeline(unsigned int pipeline);
+        void bind_vertex_array(unsigned int vertex_array);
+        void bind_buffer(GLenum target, unsigned int buffer);
+        void bind_buffer_base(GLenum target, unsigned int index, unsigned int buffer);
+        void bind_buffer_range(GLenum target, unsigned int index, unsigned int buffer, std::size_t offset, std::size_t size);
+        void bind_texture_unit(unsigned int unit, unsigned int texture);
+        // Only issues what differs from the current render state.
+        void bind_render_state(const RenderState &state);
+
+        // Deleting an object unbinds it, and its name can be handed out again, so whoever deletes one has to tell the cache.
+        void forget_program(unsigned int program);
+        void forget_program_pipeline(unsigned int pipeline);
+        void forget_vertex_array(unsigned int vertex_array);
+        void forget_buffer(unsigned int buffer);
+        void forget_texture(unsigned int texture);
+
+        // Marks everything unknown, after code the cache can't see (another library, raw GL) changed bindings.
+        void invalidate();
+
+        void set_validation(bool enabled) noexcept;
+        [[nodiscard]] bool is_validating() const noexcept;
+
+        [[nodiscard]] const StateCacheStats &get_stats() const noexcept;
+        void reset_stats() noexcept;
+
+        // nullptr if there is no GlobalState, in which case every bind goes straight to GL.
+        static StateCache *get();
+    };
+
+    // Bind through the StateCache when there is one, and straight through GL when there isn't.
+    void use_program(unsigned int program);
+    void bind_program_pipeline(unsigned int pipeline);
+    void bind_vertex_array(unsigned int vertex_array);
+    void bind_buffer(GLenum target, unsigned int buffer);
+    void bind_buffer_base(GLenum target, unsigned int index, unsigned int buffer);
+    void bind_buffer_range(GLenum target, unsigned int index, unsigned int buffer, std::size_t offset, std::size_t size);
+    void bind_texture_unit(unsigned int unit, unsigned int texture);
+
+} // gc
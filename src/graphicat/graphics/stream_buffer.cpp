@@ -0,0 +1,95 @@
+#include "stream_buffer.hpp"
+#include <algorithm>
+#include <utility>
+#include <spdlog/spdlog.h>
+
+namespace gc {
+
+    static size_t align_up(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    StreamBuffer::StreamBuffer(std::unique_ptr<Buffer> buffer, std::byte *mapped, size_t region_size, unsigned int regions)
+        : buffer(std::move(buffer)), mapped(mapped), region_size(region_size), regions(regions), fences(regions, nullptr) {
+    }
+
+    StreamBuffer::~StreamBuffer() {
+        for (auto fence : fences) {
+            if (fence) glDeleteSync(fence);
+        }
+        buffer->unmap();
+    }
+
+    std::unique_ptr<StreamBuffer> StreamBuffer::create(size_t region_size, unsigned int regions) {
+        int uniform_alignment, storage_alignment;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_alignment);
+
+        regions = std::max(regions, 1u);
+        region_size = align_up(std::max<size_t>(region_size, 1), std::max({uniform_alignment, storage_alignment, 16}));
+
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        auto buffer = Buffer::storage(region_size * regions, flags);
+        auto *mapped = static_cast<std::byte *>(buffer->map_range(0, region_size * regions, flags));
+        if (!mapped) {
+            spdlog::error("Failed to map a {} byte stream buffer", region_size * regions);
+            return nullptr;
+        }
+
+        return std::unique_ptr<StreamBuffer>(new StreamBuffer(std::move(buffer), mapped, region_size, regions));
+    }
+
+    StreamAllocation StreamBuffer::allocate(size_t size, size_t alignment) {
+        size_t start = align_up(head, alignment);
+        if (start + size > region_size) return {nullptr, 0, 0};
+
+        head = start + size;
+        size_t offset = get_region_offset() + start;
+        return {mapped + offset, offset, size};
+    }
+
+    void StreamBuffer::next_frame() {
+        if (fences[current]) glDeleteSync(fences[current]);
+        fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        current = (current + 1) % regions;
+        head = 0;
+
+        GLsync fence = std::exchange(fences[current], nullptr);
+        if (!fence) return;
+
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            stalls++;
+            do {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000);
+            } while (result == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(fence);
+    }
+
+    std::byte *StreamBuffer::get_region_data() const noexcept {
+        return mapped + get_region_offset();
+    }
+
+    size_t StreamBuffer::get_region_offset() const noexcept {
+        return region_size * current;
+    }
+
+    size_t StreamBuffer::get_region_size() const noexcept {
+        return region_size;
+    }
+
+    size_t StreamBuffer::get_used() const noexcept {
+        return head;
+    }
+
+    const Buffer &StreamBuffer::get_buffer() const noexcept {
+        return *buffer;
+    }
+
+    std::uint64_t StreamBuffer::get_stalls() const noexcept {
+        return stalls;
+    }
+
+} // gc
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/buffer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace gc {
+
+    struct StreamAllocation {
+        std::byte *data;
+        // From the start of the whole buffer, ready for bind_range or an indirect offset.
+        size_t offset;
+        size_t size;
+    };
+
+    // A persistently mapped, coherent ring with one region per frame in flight. Writes go straight to the mapped memory with no
+    // glBufferSubData or orphaning; next_frame() fences the region that was just used and, before reusing the next one, waits
+    // until the GPU is done reading it.
+    class StreamBuffer {
+        std::unique_ptr<Buffer> buffer;
+        std::byte *mapped;
+        size_t region_size;
+        unsigned int regions;
+        unsigned int current = 0;
+        size_t head = 0;
+        std::vector<GLsync> fences;
+        std::uint64_t stalls = 0;
+
+        StreamBuffer(std::unique_ptr<Buffer> buffer, std::byte *mapped, size_t region_size, unsigned int regions);
+
+    public:
+        ~StreamBuffer();
+
+        StreamBuffer(const StreamBuffer &) = delete;
+        StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+        // Regions are rounded up so every one starts at a valid uniform/storage binding offset.
+        static std::unique_ptr<StreamBuffer> create(size_t region_size, unsigned int regions = 3);
+
+        // Space in the current frame's region, or data == nullptr if it is full.
+        StreamAllocation allocate(size_t size, size_t alignment = 16);
+
+        void next_frame();
+
+        [[nodiscard]] std::byte *get_region_data() const noexcept;
+        [[nodiscard]] size_t get_region_offset() const noexcept;
+        [[nodiscard]] size_t get_region_size() const noexcept;
+        [[nodiscard]] size_t get_used() const noexcept;
+        [[nodiscard]] const Buffer &get_buffer() const noexcept;
+
+        // Times next_frame() had to wait on the GPU; more than zero usually means too few regions.
+        [[nodiscard]] std::uint64_t get_stalls() const noexcept;
+    };
+
+} // gc
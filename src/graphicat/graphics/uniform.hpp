@@ -0,0 +1,84 @@
+#pragma once
+
+#include "graphicat/graphics/shader.hpp"
+#include <cstddef>
+#include <glm/glm.hpp>
+
+namespace gc {
+
+    namespace detail {
+        inline void set_uniform(const Shader &s, int location, const float &v) { s.uniform_1f(location, v); }
+        inline void set_uniform(const Shader &s, int location, const glm::vec2 &v) { s.uniform_2f(location, v); }
+        inline void set_uniform(const Shader &s, int location, const glm::vec3 &v) { s.uniform_3f(location, v); }
+        inline void set_uniform(const Shader &s, int location, const glm::vec4 &v) { s.uniform_4f(location, v); }
+
+        inline void set_uniform(const Shader &s, int location, const int &v) { s.uniform_1i(location, v); }
+        inline void set_uniform(const Shader &s, int location, const glm::ivec2 &v) { s.uniform_2i(location, v); }
+        inline void set_uniform(const Shader &s, int location, const glm::ivec3 &v) { s.uniform_3i(location, v); }
+        inline void set_uniform(const Shader &s, int location, const glm::ivec4 &v) { s.uniform_4i(location, v); }
+
+        inline void set_uniform(const Shader &s, int location, const unsigned int &v) { s.uniform_1ui(location, v); }
+        inline void set_uniform(const Shader &s, int location, const glm::uvec2 &v) { s.uniform_2ui(location, v); }
+        inline void set_uniform(const Shader &s, int location, const glm::uvec3 &v) { s.uniform_3ui(location, v); }
+        inline void set_uniform(const Shader &s, int location, const glm::uvec4 &v) { s.uniform_4ui(location, v); }
+
+        inline void set_uniform(const Shader &s, int location, const double &v) { s.uniform_1d(location, v); }
+        inline void set_uniform(const Shader &s, int location, const glm::dvec2 &v) { s.uniform_2d(location, v); }
+        inline void set_uniform(const Shader &s, int location, const glm::dvec3 &v) { s.uniform_3d(location, v); }
+        inline void set_uniform(const Shader &s, int location, const glm::dvec4 &v) { s.uniform_4d(location, v); }
+
+        inline void set_uniform(const Shader &s, int location, const glm::mat2 &m) { s.uniform_mat2f(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::mat2x3 &m) { s.uniform_mat2x3f(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::mat2x4 &m) { s.uniform_mat2x4f(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::mat3 &m) { s.uniform_mat3f(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::mat3x2 &m) { s.uniform_mat3x2f(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::mat3x4 &m) { s.uniform_mat3x4f(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::mat4 &m) { s.uniform_mat4f(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::mat4x2 &m) { s.uniform_mat4x2f(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::mat4x3 &m) { s.uniform_mat4x3f(location, m); }
+
+        inline void set_uniform(const Shader &s, int location, const glm::dmat2 &m) { s.uniform_mat2d(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::dmat2x3 &m) { s.uniform_mat2x3d(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::dmat2x4 &m) { s.uniform_mat2x4d(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::dmat3 &m) { s.uniform_mat3d(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::dmat3x2 &m) { s.uniform_mat3x2d(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::dmat3x4 &m) { s.uniform_mat3x4d(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::dmat4 &m) { s.uniform_mat4d(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::dmat4x2 &m) { s.uniform_mat4x2d(location, m); }
+        inline void set_uniform(const Shader &s, int location, const glm::dmat4x3 &m) { s.uniform_mat4x3d(location, m); }
+
+        template<typename T> concept uniform_value = requires(const Shader &s, const T &v) { set_uniform(s, 0, v); };
+    } // detail
+
+    // A uniform whose location is fixed when the shader is written (layout(location = N)), as generated by graphicat_add_shaders
+    // PROGRAMS. set() goes straight to the location overloads of Shader, so nothing is looked up and the type can't be mixed up;
+    // it still passes through the Shader so its redundant-upload filter stays accurate. Bools and samplers are ints.
+    template<detail::uniform_value T, int Location> class Uniform {
+        const Shader *shader;
+
+    public:
+        static constexpr int location = Location;
+
+        explicit Uniform(const Shader &shader) : shader(&shader) {}
+
+        void set(const T &value) const {
+            detail::set_uniform(*shader, Location, value);
+        }
+    };
+
+    // Array elements take consecutive locations starting at Location.
+    template<detail::uniform_value T, int Location, std::size_t Count> class UniformArray {
+        const Shader *shader;
+
+    public:
+        static constexpr int location = Location;
+        static constexpr std::size_t size = Count;
+
+        explicit UniformArray(const Shader &shader) : shader(&shader) {}
+
+        void set(std::size_t index, const T &value) const {
+            detail::set_uniform(*shader, Location + static_cast<int>(index), value);
+        }
+    };
+
+} // gc
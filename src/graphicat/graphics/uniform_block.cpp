@@ -0,0 +1,46 @@
+#include "uniform_block.hpp"
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <spdlog/spdlog.h>
+
+namespace gc {
+
+    namespace {
+        struct BlockBindings {
+            std::unordered_map<std::uint64_t, unsigned int> by_name;
+            std::unordered_set<unsigned int> taken;
+            unsigned int next = 0;
+        };
+
+        // Blocks are created from worker threads too (StorageBlock, PerDrawData), so the tables are shared behind a lock.
+        std::mutex s_block_mutex;
+        BlockBindings s_block_bindings[2];
+    }
+
+    unsigned int get_block_binding(BlockType type, UniformName name) {
+        std::lock_guard lock(s_block_mutex);
+        BlockBindings &bindings = s_block_bindings[static_cast<int>(type)];
+
+        auto it = bindings.by_name.find(name.hash);
+        if (it != bindings.by_name.end()) return it->second;
+
+        while (bindings.taken.contains(bindings.next)) bindings.next++;
+        unsigned int binding = bindings.next++;
+        bindings.taken.insert(binding);
+        bindings.by_name.emplace(name.hash, binding);
+        return binding;
+    }
+
+    void claim_block_binding(BlockType type, UniformName name, unsigned int binding) {
+        std::lock_guard lock(s_block_mutex);
+        BlockBindings &bindings = s_block_bindings[static_cast<int>(type)];
+
+        auto [it, inserted] = bindings.by_name.try_emplace(name.hash, binding);
+        if (!inserted && it->second != binding)
+            spdlog::warn("A {} block declares binding {}, but another block of the same name uses {}",
+                         type == BlockType::Uniform ? "uniform" : "storage", binding, it->second);
+        bindings.taken.insert(binding);
+    }
+
+} // gc
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "graphicat/graphicat.hpp"
+#include "graphicat/graphics/block_layout.hpp"
+#include "graphicat/graphics/buffer.hpp"
+#include "graphicat/graphics/shader.hpp"
+#include <memory>
+
+namespace gc {
+
+    enum class BlockType {
+        Uniform,
+        ShaderStorage,
+    };
+
+    // Binding points are handed out per block name, so every program that declares a block called "Camera" reads it from the same
+    // binding. Shader applies these after link to its blocks that are left at binding 0; a block with an explicit
+    // layout(binding = N), N > 0, keeps it, and N is never handed out to another name. Thread-safe and makes no GL calls.
+    unsigned int get_block_binding(BlockType type, UniformName name);
+    // Records a binding a shader declared for the block, so the name resolves to it and it isn't handed out again.
+    void claim_block_binding(BlockType type, UniformName name, unsigned int binding);
+
+    // A whole interface block backed by its own buffer: update() is one copy of T, bind() one glBindBufferRange.
+    template<typename T, typename Layout, BlockType Type> class InterfaceBlock {
+        static_assert(detail::registered_block<T>, "Describe the struct with GC_BLOCK_LAYOUT before using it as a block");
+        static_assert(block_layout_matches<Layout, T>, "Struct does not follow the block layout; gc::block_layout_mismatch names the member");
+
+        static constexpr BufferTarget target = Type == BlockType::Uniform ? BufferTarget::Uniform : BufferTarget::ShaderStorage;
+
+        std::unique_ptr<Buffer> buffer;
+        unsigned int binding;
+
+        InterfaceBlock(std::unique_ptr<Buffer> buffer, unsigned int binding) : buffer(std::move(buffer)), binding(binding) {}
+
+    public:
+        static std::unique_ptr<InterfaceBlock> create(UniformName name, const T &value = {}, BufferUsage usage = BufferUsage::DynamicDraw) {
+            return std::unique_ptr<InterfaceBlock>(new InterfaceBlock(Buffer::load(sizeof(T), &value, usage), get_block_binding(Type, name)));
+        }
+
+        static std::shared_ptr<InterfaceBlock> create_shared(UniformName name, const T &value = {}, BufferUsage usage = BufferUsage::DynamicDraw) {
+            return std::shared_ptr<InterfaceBlock>(new InterfaceBlock(Buffer::load(sizeof(T), &value, usage), get_block_binding(Type, name)));
+        }
+
+        void update(const T &value) const {
+            buffer->update(0, sizeof(T), &value);
+        }
+
+        void bind() const {
+            buffer->bind_range(target, binding, 0, sizeof(T));
+        }
+
+        [[nodiscard]] const std::unique_ptr<Buffer> &get_buffer() const noexcept { return buffer; }
+        [[nodiscard]] unsigned int get_binding() const noexcept { return binding; }
+    };
+
+    template<typename T, typename Layout = Std140> using UniformBlock = InterfaceBlock<T, Layout, BlockType::Uniform>;
+    template<typename T, typename Layout = Std430> using StorageBlock = InterfaceBlock<T, Layout, BlockType::ShaderStorage>;
+
+} // gc
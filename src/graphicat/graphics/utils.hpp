@@ -1,9 +1,22 @@
 #pragma once
 
 #include "graphicat/graphicat.hpp"
+#include <algorithm>
+#include <cstdint>
 
 namespace gc {
     void clear();
     void clear(const glm::vec4& color);
     void clear(const glm::vec3& color);
+
+    // `value` clamped to [0, 1] and scaled to an unsigned normalized integer with `steps` as its largest value.
+    inline std::uint32_t pack_unorm(float value, float steps) {
+        return static_cast<std::uint32_t>(std::clamp(value, 0.0f, 1.0f) * steps + 0.5f);
+    }
+
+    // RGBA8 with red in the low byte, which is what a GL_UNSIGNED_BYTE x4 normalized attribute reads.
+    inline std::uint32_t pack_rgba8(const glm::vec4& color) {
+        return pack_unorm(color.r, 255.0f) | pack_unorm(color.g, 255.0f) << 8 | pack_unorm(color.b, 255.0f) << 16 |
+               pack_unorm(color.a, 255.0f) << 24;
+    }
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "vertex_array.hpp"
 #include "shader.hpp"
+#include "barrier_tracker.hpp"
+#include "state_cache.hpp"
 
 namespace gc {
 
@@ -28,7 +30,13 @@ namespace gc {
     }
 
     void VertexArray::bind() const {
-        glBindVertexArray(handle);
+        if (BarrierTracker *tracker = BarrierTracker::get()) {
+            for (auto buffer : buffers) tracker->read(buffer, BufferAccess::VertexAttrib);
+            tracker->read(elements, BufferAccess::ElementArray);
+            tracker->flush();
+        }
+
+        bind_vertex_array(handle);
     }
 
     void VertexArray::bind(const std::shared_ptr<Shader> &shader) const {
@@ -59,7 +67,7 @@ namespace gc {
     void
     VertexArray::vertex_buffer(const std::shared_ptr<Buffer> &buffer, const std::vector<VertexAttribute> &attributes,
                                size_t stride, size_t offset) {
-        vertex_buffer(buffer->get_handle(), attributes, stride);
+        vertex_buffer(buffer->get_handle(), attributes, stride, offset);
     }
 
     void VertexArray::vertex_buffer(const std::unique_ptr<Buffer> &buffer, const std::vector<std::pair<size_t,std::string>> &attributes) {
@@ -69,7 +77,7 @@ namespace gc {
     void
     VertexArray::vertex_buffer(const std::unique_ptr<Buffer> &buffer, const std::vector<VertexAttribute> &attributes,
                                size_t stride, size_t offset) {
-        vertex_buffer(buffer->get_handle(), attributes, stride);
+        vertex_buffer(buffer->get_handle(), attributes, stride, offset);
     }
 
     void VertexArray::vertex_buffer(const Buffer *buffer, const std::vector<std::pair<size_t,std::string>> &attributes) {
@@ -78,7 +86,7 @@ namespace gc {
 
     void
     VertexArray::vertex_buffer(const Buffer *buffer, const std::vector<VertexAttribute> &attributes, size_t stride, size_t offset) {
-        vertex_buffer(buffer->get_handle(), attributes, stride);
+        vertex_buffer(buffer->get_handle(), attributes, stride, offset);
     }
 
     void VertexArray::vertex_buffer(unsigned int buffer, const std::vector<std::pair<size_t,std::string>> &attributes) {
@@ -94,23 +102,52 @@ namespace gc {
         }
 
         glVertexArrayVertexBuffer(handle, next_binding++, buffer, 0, stride);
+        buffers.push_back(buffer);
     }
 
     void
     VertexArray::vertex_buffer(unsigned int buffer, const std::vector<VertexAttribute> &attributes, size_t stride, size_t offset) {
         for (const auto& attrib : attributes) {
+            bool integer = attrib.type != GL_FLOAT && attrib.type != GL_HALF_FLOAT && attrib.type != GL_DOUBLE && !attrib.normalized;
+
             glVertexArrayAttribBinding(handle, next_attribute, next_binding);
-            glVertexArrayAttribFormat(handle, next_attribute, static_cast<int>(attrib.size), GL_FLOAT, false, attrib.offset);
+            if (integer)
+                glVertexArrayAttribIFormat(handle, next_attribute, static_cast<int>(attrib.size), attrib.type, attrib.offset);
+            else
+                glVertexArrayAttribFormat(handle, next_attribute, static_cast<int>(attrib.size), attrib.type, attrib.normalized, attrib.offset);
             glEnableVertexArrayAttrib(handle, next_attribute);
             attribute_names[attrib.name] = next_attribute++;
-
-            stride += static_cast<int>(attrib.size * sizeof(float));
         }
 
         glVertexArrayVertexBuffer(handle, next_binding++, buffer, static_cast<int>(offset), static_cast<int>(stride));
+        buffers.push_back(buffer);
+    }
+
+    void VertexArray::element_buffer(const std::shared_ptr<Buffer> &buffer) {
+        element_buffer(buffer->get_handle());
+    }
+
+    void VertexArray::element_buffer(const std::unique_ptr<Buffer> &buffer) {
+        element_buffer(buffer->get_handle());
+    }
+
+    void VertexArray::element_buffer(const Buffer *buffer) {
+        element_buffer(buffer->get_handle());
+    }
+
+    void VertexArray::element_buffer(unsigned int buffer) {
+        glVertexArrayElementBuffer(handle, buffer);
+        elements = buffer;
+    }
+
+    unsigned int VertexArray::get_handle() const noexcept {
+        return handle;
     }
 
     VertexArray::~VertexArray() {
-        if (owned) glDeleteVertexArrays(1, &handle);
+        if (owned) {
+            if (StateCache *cache = StateCache::get()) cache->forget_vertex_array(handle);
+            glDeleteVertexArrays(1, &handle);
+        }
     }
 } // gc
\ No newline at end of file
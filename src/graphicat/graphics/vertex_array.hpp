@@ -5,6 +5,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace gc {
 
@@ -14,6 +15,9 @@ namespace gc {
         size_t size;
         size_t offset;
         std::string name;
+        // Integer types that aren't normalized reach the shader as integers (ivec/uvec), everything else as floats.
+        GLenum type = GL_FLOAT;
+        bool normalized = false;
     };
 
     class VertexArray {
@@ -24,6 +28,9 @@ namespace gc {
         unsigned int next_attribute = 0;
 
         std::unordered_map<std::string, unsigned int> attribute_names;
+        // Kept so bind() can tell the barrier tracker which buffers the next draw pulls vertices from.
+        std::vector<unsigned int> buffers;
+        unsigned int elements = 0;
 
         VertexArray(unsigned int handle, bool owned);
 
@@ -55,6 +62,13 @@ namespace gc {
         void vertex_buffer(unsigned int buffer, const std::vector<std::pair<size_t,std::string>>& attributes);
         void vertex_buffer(unsigned int buffer, const std::vector<VertexAttribute>& attributes, size_t stride, size_t offset = 0);
 
+        void element_buffer(const std::shared_ptr<Buffer>& buffer);
+        void element_buffer(const std::unique_ptr<Buffer>& buffer);
+        void element_buffer(const Buffer* buffer);
+        void element_buffer(unsigned int buffer);
+
+        [[nodiscard]] unsigned int get_handle() const noexcept;
+
     };
 
 } // gc
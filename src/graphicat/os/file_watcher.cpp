@@ -0,0 +1,89 @@
+#include "file_watcher.hpp"
+#include <spdlog/spdlog.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace gc {
+
+    std::string FileWatcher::normalize(const std::filesystem::path &path) {
+        std::error_code ec;
+        return std::filesystem::weakly_canonical(path, ec).string();
+    }
+
+#ifdef __linux__
+
+    FileWatcher::FileWatcher() {
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) spdlog::warn("inotify unavailable, file changes won't be picked up");
+    }
+
+    FileWatcher::~FileWatcher() {
+        if (fd >= 0) close(fd);
+    }
+
+    void FileWatcher::watch(const std::filesystem::path &file) {
+        std::string normalized = normalize(file);
+        if (fd < 0 || !files.insert(normalized).second) return;
+
+        std::filesystem::path directory = std::filesystem::path(normalized).parent_path();
+        int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd < 0) {
+            spdlog::warn("Can't watch {}", directory.string());
+            return;
+        }
+        directories[wd] = directory;
+    }
+
+    std::vector<std::filesystem::path> FileWatcher::poll() {
+        std::vector<std::filesystem::path> changed;
+        if (fd < 0) return changed;
+
+        std::unordered_set<std::string> seen;
+        alignas(inotify_event) char buffer[4096];
+        while (true) {
+            ssize_t length = read(fd, buffer, sizeof(buffer));
+            if (length <= 0) break; // EAGAIN once drained
+
+            for (ssize_t i = 0; i < length;) {
+                auto *event = reinterpret_cast<const inotify_event *>(buffer + i);
+                i += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+                auto directory = directories.find(event->wd);
+                if (directory == directories.end() || event->len == 0) continue;
+
+                std::string path = (directory->second / event->name).string();
+                if (files.contains(path) && seen.insert(path).second) changed.emplace_back(path);
+            }
+        }
+
+        return changed;
+    }
+
+    bool FileWatcher::is_supported() const noexcept {
+        return fd >= 0;
+    }
+
+#else
+
+    FileWatcher::FileWatcher() = default;
+    FileWatcher::~FileWatcher() = default;
+
+    void FileWatcher::watch(const std::filesystem::path &file) {
+        files.insert(normalize(file));
+    }
+
+    std::vector<std::filesystem::path> FileWatcher::poll() {
+        return {};
+    }
+
+    bool FileWatcher::is_supported() const noexcept {
+        return false;
+    }
+
+#endif
+
+} // gc
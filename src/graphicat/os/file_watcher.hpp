@@ -0,0 +1,36 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace gc {
+
+    // Reports files that were written or replaced. Uses inotify on Linux and does nothing elsewhere. Directories are watched
+    // rather than the files themselves, since many editors save by writing a new file and renaming it over the old one.
+    class FileWatcher {
+        int fd = -1;
+        std::unordered_map<int, std::filesystem::path> directories;
+        std::unordered_set<std::string> files;
+
+    public:
+        FileWatcher();
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher &) = delete;
+        FileWatcher &operator=(const FileWatcher &) = delete;
+
+        void watch(const std::filesystem::path &file);
+
+        // Never blocks. Each changed file is reported once per call, however many events it got.
+        std::vector<std::filesystem::path> poll();
+
+        [[nodiscard]] bool is_supported() const noexcept;
+
+        // The form watched and reported paths are compared in.
+        static std::string normalize(const std::filesystem::path &path);
+    };
+
+} // gc
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace gc {
+
+    // 64-bit FNV-1a. Everything is constexpr so names and literals can be hashed at compile time.
+    inline constexpr std::uint64_t hash_seed = 0xcbf29ce484222325ull;
+
+    constexpr std::uint64_t hash_string(std::string_view data, std::uint64_t seed = hash_seed) noexcept {
+        std::uint64_t h = seed;
+        for (char c : data) {
+            h ^= static_cast<std::uint8_t>(c);
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    inline std::uint64_t hash_bytes(const void *data, std::size_t size, std::uint64_t seed = hash_seed) noexcept {
+        return hash_string(std::string_view(static_cast<const char *>(data), size), seed);
+    }
+
+    // Hash of shader text that ignores line endings, trailing whitespace and trailing blank lines, so copies of a shader that only
+    // differ in those (a CRLF checkout, an editor that strips whitespace) are recognized as the same program.
+    constexpr std::uint64_t hash_shader_source(std::string_view source, std::uint64_t seed = hash_seed) noexcept {
+        std::uint64_t h = seed;
+        std::size_t pending_newlines = 0;
+        while (!source.empty()) {
+            std::size_t end = source.find('\n');
+            std::string_view line = source.substr(0, end);
+            source = end == std::string_view::npos ? std::string_view{} : source.substr(end + 1);
+
+            std::size_t length = line.size();
+            while (length > 0 && (line[length - 1] == ' ' || line[length - 1] == '\t' || line[length - 1] == '\r')) length--;
+            // Stripping the space after a backslash would turn it into a line continuation.
+            if (length > 0 && line[length - 1] == '\\') length = line.ends_with('\r') ? line.size() - 1 : line.size();
+
+            if (length == 0) {
+                pending_newlines++;
+                continue;
+            }
+
+            for (; pending_newlines > 0; pending_newlines--) h = hash_string("\n", h);
+            h = hash_string(line.substr(0, length), h);
+            pending_newlines = 1;
+        }
+        return h;
+    }
+
+    constexpr std::uint64_t hash_combine(std::uint64_t seed, std::uint64_t value) noexcept {
+        return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+    }
+
+} // gc
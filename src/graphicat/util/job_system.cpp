@@ -0,0 +1,317 @@
+#include "job_system.hpp"
+#include "graphicat/graphicat.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace gc {
+
+    static std::int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    WorkDeque::Array::Array(std::size_t capacity) : capacity(capacity), slots(std::make_unique<std::atomic<Job *>[]>(capacity)) {
+    }
+
+    Job *WorkDeque::Array::get(std::int64_t index) const noexcept {
+        return slots[static_cast<std::size_t>(index) & (capacity - 1)].load(std::memory_order_relaxed);
+    }
+
+    void WorkDeque::Array::put(std::int64_t index, Job *job) noexcept {
+        slots[static_cast<std::size_t>(index) & (capacity - 1)].store(job, std::memory_order_relaxed);
+    }
+
+    WorkDeque::WorkDeque(std::size_t capacity) {
+        arrays.push_back(std::make_unique<Array>(std::bit_ceil(std::max<std::size_t>(capacity, 2))));
+        array.store(arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    // Orderings follow Lê, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models".
+    void WorkDeque::push(Job *job) {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_acquire);
+        Array *a = array.load(std::memory_order_relaxed);
+
+        if (b - t > static_cast<std::int64_t>(a->capacity) - 1) {
+            auto grown = std::make_unique<Array>(a->capacity * 2);
+            for (std::int64_t i = t; i < b; i++) grown->put(i, a->get(i));
+            a = grown.get();
+            arrays.push_back(std::move(grown));
+            array.store(a, std::memory_order_release);
+        }
+
+        a->put(b, job);
+        // A release store in place of the paper's release fence, which ThreadSanitizer can follow.
+        bottom.store(b + 1, std::memory_order_release);
+    }
+
+    Job *WorkDeque::pop() {
+        std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Array *a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job *job = a->get(b);
+        if (t == b) {
+            // The last job; a thief may be after it too.
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    Job *WorkDeque::steal() {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return nullptr;
+
+        Array *a = array.load(std::memory_order_acquire);
+        Job *job = a->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+        return job;
+    }
+
+    namespace {
+        struct CurrentWorker {
+            const JobSystem *system = nullptr;
+            std::size_t index = 0;
+            // Jobs run while waiting inside another job; only the outermost one's time counts, or it would be counted twice.
+            int depth = 0;
+        };
+
+        thread_local CurrentWorker t_worker;
+    }
+
+    JobSystem::JobSystem(unsigned int worker_count) : stats_since_ns(now_ns()) {
+        // Every deque has to exist before any worker starts stealing from them.
+        for (unsigned int i = 0; i < worker_count; i++) workers.push_back(std::make_unique<Worker>());
+        for (unsigned int i = 0; i < worker_count; i++) workers[i]->thread = std::jthread([this, i] { work(i); });
+    }
+
+    JobSystem::~JobSystem() {
+        stopping.store(true);
+        epoch.fetch_add(1);
+        epoch.notify_all();
+        for (auto &worker : workers) worker->thread.join();
+
+        // Nobody is left to run what was still queued.
+        for (Job *job : injected) delete job;
+    }
+
+    JobSystem *JobSystem::get() {
+        GlobalState *state = GlobalState::get();
+        return state ? state->get_job_system() : nullptr;
+    }
+
+    void JobSystem::wake() {
+        epoch.fetch_add(1);
+        if (sleeping.load() != 0) epoch.notify_one();
+    }
+
+    void JobSystem::wake_waiting() {
+        wait_epoch.fetch_add(1);
+        if (waiting.load() != 0) wait_epoch.notify_all();
+    }
+
+    void JobSystem::enqueue(Job *job) {
+        if (t_worker.system == this) {
+            workers[t_worker.index]->deque.push(job);
+        } else {
+            std::lock_guard lock(injected_mutex);
+            injected.push_back(job);
+            injected_count.fetch_add(1, std::memory_order_release);
+        }
+        wake();
+        wake_waiting();
+    }
+
+    void JobSystem::submit(std::function<void()> function) {
+        // Nobody would ever wait for it, so with no workers it would never run.
+        if (workers.empty()) {
+            function();
+            external_jobs.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        enqueue(new Job{std::move(function), nullptr});
+    }
+
+    Job *JobSystem::find_job(std::size_t index, bool &stolen) {
+        stolen = false;
+        bool is_worker = index < workers.size();
+        if (is_worker) {
+            if (Job *job = workers[index]->deque.pop()) return job;
+        }
+
+        if (injected_count.load(std::memory_order_acquire) != 0) {
+            std::lock_guard lock(injected_mutex);
+            if (!injected.empty()) {
+                Job *job = injected.front();
+                injected.pop_front();
+                injected_count.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+
+        // Start at a different victim per thief so they don't all hammer the same deque.
+        std::size_t count = workers.size();
+        std::size_t start = is_worker ? index + 1 : std::hash<std::thread::id>{}(std::this_thread::get_id());
+        for (std::size_t i = 0; i < count; i++) {
+            std::size_t victim = (start + i) % count;
+            if (is_worker && victim == index) continue;
+            if (Job *job = workers[victim]->deque.steal()) {
+                stolen = true;
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    void JobSystem::execute(Job *job, std::size_t index) {
+        if (index < workers.size()) {
+            Worker &worker = *workers[index];
+            bool outermost = t_worker.depth++ == 0;
+            std::int64_t start = outermost ? now_ns() : 0;
+            job->function();
+            if (outermost) worker.busy_ns.fetch_add(now_ns() - start, std::memory_order_relaxed);
+            t_worker.depth--;
+            worker.jobs.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            job->function();
+            external_jobs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (job->group && job->group->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) wake_waiting();
+        delete job;
+    }
+
+    void JobSystem::work(std::size_t index) {
+        t_worker = {this, index, 0};
+        Worker &worker = *workers[index];
+
+        for (;;) {
+            // Read before looking, so a job submitted after the search bumps it and the wait below returns at once.
+            std::uint32_t seen = epoch.load();
+
+            bool stolen;
+            if (Job *job = find_job(index, stolen)) {
+                if (stolen) worker.steals.fetch_add(1, std::memory_order_relaxed);
+                execute(job, index);
+                continue;
+            }
+            if (stopping.load()) break;
+
+            std::int64_t start = now_ns();
+            sleeping.fetch_add(1);
+            epoch.wait(seen);
+            sleeping.fetch_sub(1);
+            worker.parked_ns.fetch_add(now_ns() - start, std::memory_order_relaxed);
+        }
+    }
+
+    bool JobSystem::help() {
+        std::size_t index = t_worker.system == this ? t_worker.index : workers.size();
+        bool stolen;
+        Job *job = find_job(index, stolen);
+        if (!job) return false;
+
+        if (stolen && index < workers.size()) workers[index]->steals.fetch_add(1, std::memory_order_relaxed);
+        execute(job, index);
+        return true;
+    }
+
+    void JobSystem::parallel_for_impl(std::size_t begin, std::size_t end, std::size_t grain,
+                                      const std::function<void(std::size_t, std::size_t)> &body) {
+        if (begin >= end) return;
+        grain = std::max<std::size_t>(grain, 1);
+
+        TaskGroup group(*this);
+        std::function<void(std::size_t, std::size_t)> split = [&](std::size_t b, std::size_t e) {
+            // Hand off the upper half and keep going with the lower one, so the biggest pieces are the first up for stealing.
+            while (e - b > grain) {
+                std::size_t middle = b + (e - b) / 2;
+                group.run([&split, middle, e] { split(middle, e); });
+                e = middle;
+            }
+            body(b, e);
+        };
+        split(begin, end);
+        group.wait();
+    }
+
+    std::size_t JobSystem::get_worker_count() const noexcept {
+        return workers.size();
+    }
+
+    int JobSystem::get_current_worker() const noexcept {
+        return t_worker.system == this ? static_cast<int>(t_worker.index) : -1;
+    }
+
+    std::vector<WorkerStats> JobSystem::get_worker_stats() const {
+        auto elapsed = static_cast<double>(std::max<std::int64_t>(now_ns() - stats_since_ns.load(std::memory_order_relaxed), 1));
+
+        std::vector<WorkerStats> stats;
+        stats.reserve(workers.size());
+        for (const auto &worker : workers) {
+            WorkerStats s;
+            s.jobs = worker->jobs.load(std::memory_order_relaxed);
+            s.steals = worker->steals.load(std::memory_order_relaxed);
+            s.busy = std::chrono::nanoseconds(worker->busy_ns.load(std::memory_order_relaxed));
+            s.parked = std::chrono::nanoseconds(worker->parked_ns.load(std::memory_order_relaxed));
+            s.utilization = std::min(static_cast<double>(s.busy.count()) / elapsed, 1.0);
+            stats.push_back(s);
+        }
+        return stats;
+    }
+
+    std::uint64_t JobSystem::get_external_jobs() const noexcept {
+        return external_jobs.load(std::memory_order_relaxed);
+    }
+
+    void JobSystem::reset_stats() noexcept {
+        for (auto &worker : workers) {
+            worker->jobs.store(0, std::memory_order_relaxed);
+            worker->steals.store(0, std::memory_order_relaxed);
+            worker->busy_ns.store(0, std::memory_order_relaxed);
+            worker->parked_ns.store(0, std::memory_order_relaxed);
+        }
+        external_jobs.store(0, std::memory_order_relaxed);
+        stats_since_ns.store(now_ns(), std::memory_order_relaxed);
+    }
+
+    TaskGroup::TaskGroup(JobSystem &jobs) : jobs(jobs) {
+    }
+
+    TaskGroup::~TaskGroup() {
+        wait();
+    }
+
+    void TaskGroup::run(std::function<void()> function) {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        jobs.enqueue(new Job{std::move(function), this});
+    }
+
+    void TaskGroup::wait() {
+        for (;;) {
+            // Read before looking, so a job queued or a group finished after the search bumps it and the wait returns at once.
+            std::uint32_t seen = jobs.wait_epoch.load();
+            if (pending.load(std::memory_order_acquire) == 0) return;
+            if (jobs.help()) continue;
+
+            // The rest of the group is running on other threads; park rather than spin until something changes.
+            jobs.waiting.fetch_add(1);
+            jobs.wait_epoch.wait(seen);
+            jobs.waiting.fetch_sub(1);
+        }
+    }
+
+    bool TaskGroup::is_done() const noexcept {
+        return pending.load(std::memory_order_acquire) == 0;
+    }
+
+} // gc
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gc {
+
+    class TaskGroup;
+
+    struct Job {
+        std::function<void()> function;
+        TaskGroup *group;
+    };
+
+    // Chase-Lev work-stealing deque. The owning worker pushes and pops at the bottom without contention; other threads steal from
+    // the top, and only fight the owner with a CAS over the last job. Grows by doubling; old arrays are kept until the deque goes,
+    // since a thief may still be reading one.
+    class WorkDeque {
+        struct Array {
+            std::size_t capacity;
+            std::unique_ptr<std::atomic<Job *>[]> slots;
+
+            explicit Array(std::size_t capacity);
+            [[nodiscard]] Job *get(std::int64_t index) const noexcept;
+            void put(std::int64_t index, Job *job) noexcept;
+        };
+
+        alignas(64) std::atomic<std::int64_t> top = 0;
+        alignas(64) std::atomic<std::int64_t> bottom = 0;
+        std::atomic<Array *> array;
+        std::vector<std::unique_ptr<Array>> arrays;
+
+    public:
+        explicit WorkDeque(std::size_t capacity = 256);
+
+        WorkDeque(const WorkDeque &) = delete;
+        WorkDeque &operator=(const WorkDeque &) = delete;
+
+        // Owner only.
+        void push(Job *job);
+        Job *pop();
+
+        // Any thread. nullptr if the deque is empty or another thread got there first.
+        Job *steal();
+    };
+
+    struct WorkerStats {
+        std::uint64_t jobs = 0;
+        // Jobs this worker took from another worker's deque.
+        std::uint64_t steals = 0;
+        std::chrono::nanoseconds busy{0};
+        std::chrono::nanoseconds parked{0};
+        // Share of the time since the last reset_stats() spent running jobs.
+        double utilization = 0.0;
+    };
+
+    // Work-stealing scheduler: one thread per worker, each with its own WorkDeque. Jobs submitted from a worker go on its own deque,
+    // so spawned work stays on the core that made it until someone idle steals it; jobs submitted from other threads go through a
+    // shared queue. Workers with nothing to run or steal park on an atomic until more work is submitted.
+    //
+    //     gc::TaskGroup group(*gc::JobSystem::get());
+    //     group.run([&] { decode(texture_a); });
+    //     group.run([&] { decode(texture_b); });
+    //     group.wait(); // runs jobs itself while it waits
+    //
+    //     jobs->parallel_for(0, meshes.size(), 16, [&](std::size_t begin, std::size_t end) { ... });
+    //
+    // GlobalState owns the one the library's parallel features use; see GraphicatProperties::job_threads. A JobSystem with no
+    // workers is valid: group and parallel_for jobs run on the threads that wait, and submit() runs its job inline.
+    class JobSystem {
+        struct Worker {
+            WorkDeque deque;
+            std::jthread thread;
+            std::atomic<std::uint64_t> jobs = 0;
+            std::atomic<std::uint64_t> steals = 0;
+            std::atomic<std::int64_t> busy_ns = 0;
+            std::atomic<std::int64_t> parked_ns = 0;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::mutex injected_mutex;
+        std::deque<Job *> injected;
+        std::atomic<std::size_t> injected_count = 0;
+
+        std::atomic<std::uint32_t> epoch = 0;
+        std::atomic<std::uint32_t> sleeping = 0;
+        // Like epoch, for threads parked in TaskGroup::wait(): bumped when a job is queued or a group finishes. Kept here rather
+        // than in the group, which may be gone by the time its last job gets to notifying.
+        std::atomic<std::uint32_t> wait_epoch = 0;
+        std::atomic<std::uint32_t> waiting = 0;
+        std::atomic<bool> stopping = false;
+        std::atomic<std::int64_t> stats_since_ns;
+        std::atomic<std::uint64_t> external_jobs = 0;
+
+        void work(std::size_t index);
+        void wake();
+        void wake_waiting();
+        // Onto the calling worker's own deque, or the shared queue from any other thread.
+        void enqueue(Job *job);
+        Job *find_job(std::size_t index, bool &stolen);
+        void execute(Job *job, std::size_t index);
+        void parallel_for_impl(std::size_t begin, std::size_t end, std::size_t grain, const std::function<void(std::size_t, std::size_t)> &body);
+
+        friend class TaskGroup;
+
+    public:
+        // 0 workers is allowed; see above.
+        explicit JobSystem(unsigned int worker_count);
+        ~JobSystem();
+
+        JobSystem(const JobSystem &) = delete;
+        JobSystem &operator=(const JobSystem &) = delete;
+
+        static JobSystem *get();
+
+        // Fire and forget. Use a TaskGroup to wait for the job. Runs the job before returning if there are no workers.
+        void submit(std::function<void()> function);
+
+        // Runs one queued job on the calling thread, if there is one. For threads that wait on something jobs will produce.
+        bool help();
+
+        // Calls body(begin, end) over subranges of [begin, end) of at most `grain` items, in parallel, and returns when all are
+        // done. The range is split in halves recursively, so idle workers steal big pieces first.
+        template<typename F> void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, const F &body) {
+            parallel_for_impl(begin, end, grain, std::function<void(std::size_t, std::size_t)>(std::cref(body)));
+        }
+
+        [[nodiscard]] std::size_t get_worker_count() const noexcept;
+        // The calling thread's worker index, or -1 if it isn't one of this system's workers.
+        [[nodiscard]] int get_current_worker() const noexcept;
+
+        [[nodiscard]] std::vector<WorkerStats> get_worker_stats() const;
+        // Jobs run by threads that aren't workers, while waiting or helping.
+        [[nodiscard]] std::uint64_t get_external_jobs() const noexcept;
+        void reset_stats() noexcept;
+    };
+
+    // Jobs that can be waited on together. Destroying a group waits for it.
+    class TaskGroup {
+        JobSystem &jobs;
+        std::atomic<std::size_t> pending = 0;
+
+        friend class JobSystem;
+
+    public:
+        explicit TaskGroup(JobSystem &jobs);
+        ~TaskGroup();
+
+        TaskGroup(const TaskGroup &) = delete;
+        TaskGroup &operator=(const TaskGroup &) = delete;
+
+        void run(std::function<void()> function);
+
+        // Runs queued jobs (this group's or anyone's) until every job of the group is done, so waiting from a worker never
+        // deadlocks the pool. Parks while there is nothing to run and the group's jobs are busy on other threads.
+        void wait();
+
+        [[nodiscard]] bool is_done() const noexcept;
+    };
+
+} // gc
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gc {
+
+    // Bump allocator over a list of fixed-size blocks. Nothing is freed on its own: reset() rewinds to the first block and keeps
+    // every block for reuse, so after the first few frames recording allocates nothing. Only for trivially destructible objects,
+    // since nothing is ever destroyed. Not thread safe; give each thread its own.
+    class LinearAllocator {
+        struct Block {
+            std::unique_ptr<std::byte[]> data;
+            std::size_t size;
+        };
+
+        std::vector<Block> blocks;
+        std::size_t block_size;
+        std::size_t current = 0;
+        std::size_t offset = 0;
+        std::size_t used = 0;
+
+    public:
+        explicit LinearAllocator(std::size_t block_size = 64 * 1024) : block_size(block_size) {}
+
+        LinearAllocator(const LinearAllocator &) = delete;
+        LinearAllocator &operator=(const LinearAllocator &) = delete;
+        LinearAllocator(LinearAllocator &&) noexcept = default;
+        LinearAllocator &operator=(LinearAllocator &&) noexcept = default;
+
+        void *allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+            while (current < blocks.size()) {
+                Block &block = blocks[current];
+                // Align the address rather than the offset: blocks are only max_align_t aligned, and T may need more.
+                auto base = reinterpret_cast<std::uintptr_t>(block.data.get());
+                std::size_t aligned = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+                if (aligned + size <= block.size) {
+                    offset = aligned + size;
+                    used += size;
+                    return block.data.get() + aligned;
+                }
+                current++;
+                offset = 0;
+            }
+
+            // Oversized requests get a block of their own size, with room for the padding an over-aligned type needs.
+            std::size_t size_needed = std::max(block_size, size + alignment);
+            blocks.push_back({std::make_unique<std::byte[]>(size_needed), size_needed});
+            current = blocks.size() - 1;
+            offset = 0;
+            return allocate(size, alignment);
+        }
+
+        template<typename T, typename... Args> T *create(Args &&...args) {
+            static_assert(std::is_trivially_destructible_v<T>, "LinearAllocator never runs destructors");
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        void reset() noexcept {
+            current = 0;
+            offset = 0;
+            used = 0;
+        }
+
+        // Bytes handed out since the last reset, not counting alignment padding.
+        [[nodiscard]] std::size_t get_used() const noexcept { return used; }
+
+        [[nodiscard]] std::size_t get_capacity() const noexcept {
+            std::size_t capacity = 0;
+            for (const auto &block : blocks) capacity += block.size;
+            return capacity;
+        }
+    };
+
+} // gc
@@ -0,0 +1,114 @@
+#include "task.hpp"
+#include "job_system.hpp"
+#include "graphicat/graphicat.hpp"
+
+namespace gc {
+
+    static bool is_cancelled(const detail::AsyncContext *context) {
+        return context && context->cancelled.load(std::memory_order_acquire);
+    }
+
+    // A cancelled chain may hold GL objects, so it is always torn down on the GL thread.
+    static void tear_down(detail::AsyncContext *context) {
+        if (GLExecutor *executor = GLExecutor::get(); executor && !executor->is_gl_thread()) {
+            executor->post(context->root, context);
+        } else {
+            context->root.destroy();
+        }
+    }
+
+    namespace detail {
+        bool resume_on_jobs(std::coroutine_handle<> handle, AsyncContext *context) {
+            if (is_cancelled(context)) {
+                tear_down(context);
+                return true;
+            }
+
+            // With no workers, a resumption queued for the pool would wait for a TaskGroup that never comes.
+            JobSystem *jobs = JobSystem::get();
+            if (!jobs || jobs->get_worker_count() == 0) return false;
+
+            jobs->submit([handle, context] {
+                if (is_cancelled(context))
+                    tear_down(context);
+                else
+                    handle.resume();
+            });
+            return true;
+        }
+
+        bool resume_on_gl(std::coroutine_handle<> handle, AsyncContext *context, bool yield) {
+            if (is_cancelled(context)) {
+                tear_down(context);
+                return true;
+            }
+
+            GLExecutor *executor = GLExecutor::get();
+            if (!executor || (!yield && executor->is_gl_thread())) return false;
+
+            executor->post(handle, context);
+            return true;
+        }
+    } // detail
+
+    GLExecutor::GLExecutor() : gl_thread(std::this_thread::get_id()) {
+    }
+
+    GLExecutor::~GLExecutor() {
+        for (Entry &entry : queue) {
+            if (entry.context)
+                entry.context->root.destroy();
+            else
+                entry.handle.destroy();
+        }
+    }
+
+    GLExecutor *GLExecutor::get() {
+        GlobalState *state = GlobalState::get();
+        return state ? state->get_gl_executor() : nullptr;
+    }
+
+    void GLExecutor::post(std::coroutine_handle<> handle, detail::AsyncContext *context) {
+        std::lock_guard lock(mutex);
+        queue.push_back({handle, context});
+    }
+
+    std::size_t GLExecutor::run(std::chrono::microseconds budget) {
+        auto start = std::chrono::steady_clock::now();
+
+        std::size_t available;
+        {
+            std::lock_guard lock(mutex);
+            available = queue.size();
+        }
+
+        std::size_t count = 0;
+        while (count < available) {
+            Entry entry;
+            {
+                std::lock_guard lock(mutex);
+                entry = queue.front();
+                queue.pop_front();
+            }
+
+            if (is_cancelled(entry.context))
+                entry.context->root.destroy();
+            else
+                entry.handle.resume();
+            count++;
+
+            if (std::chrono::steady_clock::now() - start >= budget) break;
+        }
+        return count;
+    }
+
+    std::size_t GLExecutor::get_pending() const {
+        std::lock_guard lock(mutex);
+        return queue.size();
+    }
+
+    bool GLExecutor::is_gl_thread() const noexcept {
+        return std::this_thread::get_id() == gl_thread;
+    }
+
+} // gc
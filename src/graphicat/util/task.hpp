@@ -0,0 +1,261 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace gc {
+
+    namespace detail {
+        // Shared by every coroutine of one spawn()ed chain. Only one of them is ever suspended on something other than another
+        // of them, so destroying the root frame (which owns the rest through their Tasks) tears the whole chain down.
+        struct AsyncContext {
+            std::atomic<bool> cancelled = false;
+            std::coroutine_handle<> root;
+        };
+
+        struct PromiseBase {
+            AsyncContext *context = nullptr;
+            std::coroutine_handle<> continuation;
+
+            // Nothing in graphicat throws; an exception getting this far is a bug.
+            void unhandled_exception() noexcept { std::terminate(); }
+        };
+
+        template<typename T> struct TaskPromise : PromiseBase {
+            std::optional<T> value;
+
+            template<typename U> void return_value(U &&result) { value.emplace(std::forward<U>(result)); }
+            T take() { return std::move(*value); }
+        };
+
+        template<> struct TaskPromise<void> : PromiseBase {
+            void return_void() noexcept {}
+            void take() noexcept {}
+        };
+
+        // Both return true if the coroutine was handed off and has to stay suspended, false to carry on inline.
+        bool resume_on_jobs(std::coroutine_handle<> handle, AsyncContext *context);
+        bool resume_on_gl(std::coroutine_handle<> handle, AsyncContext *context, bool yield);
+    } // detail
+
+    // A lazily started coroutine returning T. It runs when it is co_awaited (from another Task or through spawn()), on whatever
+    // thread awaits it, until it co_awaits switch_to_jobs() or switch_to_gl() to move elsewhere. When it finishes, the awaiting
+    // coroutine picks up on the thread it finished on.
+    template<typename T = void> class [[nodiscard]] Task {
+    public:
+        struct promise_type : detail::TaskPromise<T> {
+            Task get_return_object() noexcept { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            struct FinalAwaiter {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                    std::coroutine_handle<> continuation = handle.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+                void await_resume() noexcept {}
+            };
+
+            FinalAwaiter final_suspend() noexcept { return {}; }
+        };
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+
+        explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    public:
+        Task(Task &&other) noexcept : handle(std::exchange(other.handle, {})) {}
+        Task &operator=(Task &&other) noexcept {
+            if (this != &other) {
+                if (handle) handle.destroy();
+                handle = std::exchange(other.handle, {});
+            }
+            return *this;
+        }
+        ~Task() {
+            if (handle) handle.destroy();
+        }
+
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() noexcept { return handle.done(); }
+            template<typename Promise> std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> awaiting) noexcept {
+                handle.promise().context = awaiting.promise().context;
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+            T await_resume() { return handle.promise().take(); }
+        };
+
+        Awaiter operator co_await() && noexcept { return Awaiter{handle}; }
+    };
+
+    // Moves the awaiting coroutine onto a JobSystem worker, for file I/O and decoding. Carries on inline without a JobSystem or
+    // when it has no workers.
+    struct SwitchToJobs {
+        bool await_ready() const noexcept { return false; }
+        template<typename Promise> bool await_suspend(std::coroutine_handle<Promise> handle) {
+            return detail::resume_on_jobs(handle, handle.promise().context);
+        }
+        void await_resume() const noexcept {}
+    };
+
+    // Moves the awaiting coroutine onto the GL thread, where it resumes from GLExecutor::run(). With `yield`, it goes through the
+    // queue even if it is already on the GL thread, so it picks up in a later run(): use that to poll something once a frame.
+    struct SwitchToGL {
+        bool yield = false;
+
+        bool await_ready() const noexcept { return false; }
+        template<typename Promise> bool await_suspend(std::coroutine_handle<Promise> handle) {
+            return detail::resume_on_gl(handle, handle.promise().context, yield);
+        }
+        void await_resume() const noexcept {}
+    };
+
+    [[nodiscard]] inline SwitchToJobs switch_to_jobs() noexcept { return {}; }
+    [[nodiscard]] inline SwitchToGL switch_to_gl() noexcept { return {}; }
+    [[nodiscard]] inline SwitchToGL yield_to_next_frame() noexcept { return {true}; }
+
+    // Resumes coroutines that asked for the GL thread, a bounded amount of time per call. GlobalState owns one; call run() once a
+    // frame on the GL thread:
+    //
+    //     gc::Future<std::shared_ptr<gc::Shader>> shader = gc::spawn(gc::load_shader_async({...}));
+    //     while (!window.should_close()) {
+    //         gc::GLExecutor::get()->run(std::chrono::milliseconds(2));
+    //         if (shader.is_ready()) ...
+    //     }
+    //
+    // Chains that were cancelled are destroyed here rather than resumed, so GL objects they hold are always freed on this thread.
+    class GLExecutor {
+        struct Entry {
+            std::coroutine_handle<> handle;
+            detail::AsyncContext *context;
+        };
+
+        mutable std::mutex mutex;
+        std::deque<Entry> queue;
+        std::thread::id gl_thread;
+
+    public:
+        // The calling thread is taken to be the GL thread.
+        GLExecutor();
+        // Destroys the chains still waiting, so has to run on the GL thread too.
+        ~GLExecutor();
+
+        GLExecutor(const GLExecutor &) = delete;
+        GLExecutor &operator=(const GLExecutor &) = delete;
+
+        static GLExecutor *get();
+
+        void post(std::coroutine_handle<> handle, detail::AsyncContext *context);
+
+        // Resumes queued coroutines until the budget is spent; at least one, so the queue always drains eventually. Coroutines
+        // queued while this runs wait for the next call. Returns how many were resumed or destroyed.
+        std::size_t run(std::chrono::microseconds budget);
+
+        [[nodiscard]] std::size_t get_pending() const;
+        [[nodiscard]] bool is_gl_thread() const noexcept;
+    };
+
+    namespace detail {
+        template<typename T> struct FutureState {
+            using Value = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+            AsyncContext context;
+            std::atomic<bool> done = false;
+            std::optional<Value> value;
+        };
+
+        // The root of a spawn()ed chain. Starts suspended so spawn() can fill in the context, and frees itself when it finishes.
+        struct Detached {
+            struct promise_type : PromiseBase {
+                Detached get_return_object() noexcept { return {std::coroutine_handle<promise_type>::from_promise(*this)}; }
+                std::suspend_always initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() noexcept {}
+            };
+
+            std::coroutine_handle<promise_type> handle;
+        };
+
+        template<typename T> Detached drive(Task<T> task, std::shared_ptr<FutureState<T>> state) {
+            // Marks the future done however the frame goes, including being destroyed on cancellation.
+            struct Finish {
+                FutureState<T> *state;
+                ~Finish() { state->done.store(true, std::memory_order_release); }
+            } finish{state.get()};
+
+            if constexpr (std::is_void_v<T>) {
+                co_await std::move(task);
+                state->value.emplace();
+            } else {
+                state->value.emplace(co_await std::move(task));
+            }
+        }
+    } // detail
+
+    // The result of a spawn()ed Task. Destroying it cancels the task.
+    template<typename T> class [[nodiscard]] Future {
+        std::shared_ptr<detail::FutureState<T>> state;
+
+        template<typename U> friend Future<U> spawn(Task<U> task);
+
+        explicit Future(std::shared_ptr<detail::FutureState<T>> state) : state(std::move(state)) {}
+
+    public:
+        Future() = default;
+        Future(Future &&) noexcept = default;
+        Future &operator=(Future &&other) noexcept {
+            if (this != &other) {
+                cancel();
+                state = std::move(other.state);
+            }
+            return *this;
+        }
+        ~Future() { cancel(); }
+
+        // Finished or torn down after cancel().
+        [[nodiscard]] bool is_ready() const noexcept { return !state || state->done.load(std::memory_order_acquire); }
+        [[nodiscard]] bool is_cancelled() const noexcept { return is_ready() && (!state || !state->value); }
+
+        // The chain stops at its next switch_to_jobs() or switch_to_gl(), and is destroyed on the GL thread from there. Work
+        // already running (a file read, a compile) is not interrupted.
+        void cancel() noexcept {
+            if (state) state->context.cancelled.store(true, std::memory_order_release);
+        }
+
+        // Only once ready. Empty if the task was cancelled.
+        [[nodiscard]] std::optional<T> take() requires (!std::is_void_v<T>) {
+            if (!is_ready() || !state->value) return std::nullopt;
+            return std::move(state->value);
+        }
+    };
+
+    // Starts the task on the calling thread, where it runs until it first switches threads.
+    template<typename T> Future<T> spawn(Task<T> task) {
+        auto state = std::make_shared<detail::FutureState<T>>();
+        detail::Detached root = detail::drive(std::move(task), state);
+        root.handle.promise().context = &state->context;
+        state->context.root = root.handle;
+        root.handle.resume();
+        return Future<T>(std::move(state));
+    }
+
+} // gc
@@ -0,0 +1,114 @@
+// Times gc::RenderQueue's radix sorts against std::sort with a comparator on the same items, and checks all of them agree.
+//
+// graphicat_render_queue_bench [--threads <n>] [--runs <n>] [<item count>...]
+//
+// --threads is the number of JobSystem workers for the parallel sort, one less than the hardware threads by default. Item counts
+// default to 10k, 100k and 1M. Keys come from the standard layout with a few layers, 1 in 8 translucent, 200 programs,
+// 2000 materials and random depth, which is roughly what a scene produces.
+
+#include "graphicat/graphics/render_queue.hpp"
+#include "graphicat/util/job_system.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+namespace gc::tools {
+
+    using Clock = std::chrono::steady_clock;
+
+    static std::vector<RenderQueueItem> make_items(const SortKeyLayout &layout, std::size_t count, std::uint32_t seed) {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<std::uint32_t> layer(0, 3);
+        std::uniform_int_distribution<std::uint32_t> translucent(0, 7);
+        std::uniform_int_distribution<std::uint32_t> program(0, 199);
+        std::uniform_int_distribution<std::uint32_t> material(0, 1999);
+        std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+
+        std::vector<RenderQueueItem> items(count);
+        for (std::size_t i = 0; i < count; i++) {
+            SortKeyFields fields{layer(random), translucent(random) == 0, program(random), material(random), depth(random)};
+            items[i] = {layout.encode(fields), static_cast<std::uint32_t>(i)};
+        }
+        return items;
+    }
+
+    // Best of `runs`, in milliseconds. `prepare` runs untimed before each.
+    template<typename Prepare, typename Sort> static double best_of(int runs, Prepare prepare, Sort sort) {
+        double best = 0.0;
+        for (int run = 0; run < runs; run++) {
+            prepare();
+            auto start = Clock::now();
+            sort();
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            if (run == 0 || ms < best) best = ms;
+        }
+        return best;
+    }
+
+    static bool same_order(const std::vector<RenderQueueItem> &expected, std::span<const RenderQueueItem> actual) {
+        return std::equal(expected.begin(), expected.end(), actual.begin(), actual.end(), [](const auto &a, const auto &b) {
+            return a.key == b.key && a.payload == b.payload;
+        });
+    }
+
+    static bool bench(std::size_t count, JobSystem &jobs, int runs) {
+        SortKeyLayout layout = SortKeyLayout::standard();
+        std::vector<RenderQueueItem> items = make_items(layout, count, 1234);
+
+        // Payloads are push order, so comparing them too gives the stable order the radix sort produces.
+        std::vector<RenderQueueItem> expected;
+        double std_sort = best_of(runs, [&] { expected = items; }, [&] {
+            std::sort(expected.begin(), expected.end(), [](const RenderQueueItem &a, const RenderQueueItem &b) {
+                return a.key != b.key ? a.key < b.key : a.payload < b.payload;
+            });
+        });
+
+        RenderQueue queue(layout);
+        queue.reserve(count);
+        auto refill = [&] {
+            queue.clear();
+            for (const RenderQueueItem &item : items) queue.push_key(item.key, item.payload);
+        };
+
+        double radix = best_of(runs, refill, [&] { queue.sort(); });
+        bool ok = same_order(expected, queue.get_items());
+        double parallel = best_of(runs, refill, [&] { queue.sort_parallel(&jobs); });
+        ok = ok && same_order(expected, queue.get_items());
+
+        spdlog::info("{:>9} items: std::sort {:8.3f} ms, radix {:8.3f} ms ({:4.1f}x), parallel {:8.3f} ms ({:4.1f}x){}", count, std_sort,
+                     radix, std_sort / radix, parallel, std_sort / parallel, ok ? "" : "  MISMATCH");
+        return ok;
+    }
+
+} // gc::tools
+
+int main(int argc, char **argv) {
+    unsigned int threads = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+    int runs = 5;
+    std::vector<std::size_t> counts;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        } else if (!arg.empty() && arg[0] != '-') {
+            counts.push_back(std::strtoull(arg.c_str(), nullptr, 10));
+        } else {
+            spdlog::error("Unknown argument {}", arg);
+            return EXIT_FAILURE;
+        }
+    }
+    if (counts.empty()) counts = {10'000, 100'000, 1'000'000};
+
+    gc::JobSystem jobs(threads);
+    bool ok = true;
+    for (std::size_t count : counts) ok = gc::tools::bench(count, jobs, runs) && ok;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
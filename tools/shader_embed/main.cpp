@@ -0,0 +1,513 @@
+// Build-time half of graphicat_add_shaders: preprocesses shaders, optionally validates them with glslangValidator, and writes a
+// header embedding the expanded sources with their hashes plus the uniforms they declare. With --program it also writes a struct of
+// gc::Uniform fields per program, and with --assign-locations it gives every uniform without layout(location = N) one and rewrites
+// the embedded source to match. See cmake/GraphicatShaders.cmake.
+//
+// graphicat_shader_embed --output <header> [--depfile <file>] [--namespace <ns>] [--include-dir <dir>]... [--define <D[=V]>]...
+//                        [--validator <glslangValidator>] [--assign-locations] [--program <name>=<file>,<file>...]... <shader>...
+
+#include "graphicat/graphics/shader_preprocessor.hpp"
+#include "graphicat/util/hash.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+namespace gc::tools {
+
+    struct Options {
+        std::filesystem::path output;
+        std::filesystem::path depfile;
+        std::string name_space = "shaders";
+        std::vector<std::filesystem::path> include_directories;
+        std::vector<std::string> defines;
+        std::string validator;
+        bool assign_locations = false;
+        std::vector<std::pair<std::string, std::vector<std::string>>> programs;
+        std::vector<std::filesystem::path> shaders;
+    };
+
+    struct Declarator {
+        std::string name;
+        std::string suffix; // array brackets and initializer, verbatim
+        std::optional<int> count; // 1 unless it's an array; unknown if the size isn't a literal
+        std::optional<int> location;
+    };
+
+    // One "uniform ...;" statement in the default block. begin/end cover it in the source, without the semicolon.
+    struct Declaration {
+        std::size_t begin;
+        std::size_t end;
+        std::string qualifiers; // layout qualifiers other than location
+        std::string modifiers; // precision and memory qualifiers
+        std::string type;
+        std::vector<Declarator> declarators;
+        bool rewritable;
+    };
+
+    struct Shader {
+        std::filesystem::path path;
+        std::string stage;
+        std::string source;
+        std::vector<Declaration> declarations;
+    };
+
+    static const std::map<std::string, std::string> stage_extensions = {
+        {".vert", "Vertex"}, {".frag", "Fragment"}, {".geom", "Geometry"},
+        {".tesc", "TessControl"}, {".tese", "TessEval"}, {".comp", "Compute"},
+    };
+
+    static std::optional<Options> parse_arguments(int argc, char **argv) {
+        Options options;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    spdlog::error("{} needs a value", arg);
+                    std::exit(2);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--output") options.output = value();
+            else if (arg == "--depfile") options.depfile = value();
+            else if (arg == "--namespace") options.name_space = value();
+            else if (arg == "--include-dir") options.include_directories.emplace_back(value());
+            else if (arg == "--define") options.defines.push_back(value());
+            else if (arg == "--validator") options.validator = value();
+            else if (arg == "--assign-locations") options.assign_locations = true;
+            else if (arg == "--program") {
+                std::string program = value();
+                std::size_t eq = program.find('=');
+                if (eq == std::string::npos) {
+                    spdlog::error("--program expects <name>=<file>,<file>...");
+                    return std::nullopt;
+                }
+
+                std::vector<std::string> files;
+                std::istringstream list(program.substr(eq + 1));
+                for (std::string file; std::getline(list, file, ',');) files.push_back(file);
+                options.programs.emplace_back(program.substr(0, eq), std::move(files));
+            }
+            else if (arg.starts_with("--")) {
+                spdlog::error("Unknown option {}", arg);
+                return std::nullopt;
+            } else options.shaders.emplace_back(arg);
+        }
+
+        if (options.output.empty() || options.shaders.empty()) {
+            spdlog::error("Usage: graphicat_shader_embed --output <header> [options] <shader>...");
+            return std::nullopt;
+        }
+        return options;
+    }
+
+    // basic.vert -> basic_vert
+    static std::string identifier(const std::filesystem::path &path) {
+        std::string name = path.filename().string();
+        for (auto &c : name) {
+            if (!std::isalnum(static_cast<unsigned char>(c))) c = '_';
+        }
+        if (name.empty() || std::isdigit(static_cast<unsigned char>(name.front()))) name.insert(0, "_");
+        return name;
+    }
+
+    // Blanks out comments and preprocessor lines without moving anything, so offsets into the result are offsets into the source.
+    static std::string blank_non_code(const std::string &source) {
+        std::string out = source;
+        bool line_start = true;
+        for (std::size_t i = 0; i < out.size(); i++) {
+            if (out.compare(i, 2, "//") == 0 || (line_start && out[i] == '#')) {
+                while (i < out.size() && out[i] != '\n') out[i++] = ' ';
+                line_start = true;
+                continue;
+            }
+            if (out.compare(i, 2, "/*") == 0) {
+                std::size_t end = std::min(out.find("*/", i + 2), out.size() - 2) + 2;
+                for (; i < end; i++) {
+                    if (out[i] != '\n') out[i] = ' ';
+                }
+                i--;
+                continue;
+            }
+
+            if (out[i] == '\n') line_start = true;
+            else if (out[i] != ' ' && out[i] != '\t' && out[i] != '\r') line_start = false;
+        }
+        return out;
+    }
+
+    // Picks up default-block uniforms ("layout(location = 2) uniform mat4 a, b[4];"). Block members are skipped since they are set
+    // through UniformBlock/StorageBlock instead.
+    static std::vector<Declaration> find_declarations(const std::string &source) {
+        static const std::regex declaration(
+            R"(^(\s*)(?:layout\s*\(([^)]*)\)\s*)?uniform\s+((?:(?:lowp|mediump|highp|coherent|volatile|restrict|readonly|writeonly)\s+)*)(\w+)\s+(.+?)\s*$)");
+        static const std::regex location(R"(\s*,?\s*\blocation\s*=\s*(\d+)\s*,?\s*)");
+        static const std::regex declarator(R"(^\s*(\w+)\s*((?:\[\s*(\w*)\s*\])?\s*(?:=.*)?)$)");
+
+        std::vector<Declaration> declarations;
+        std::string text = blank_non_code(source);
+
+        std::size_t start = 0;
+        while (start < text.size()) {
+            std::size_t end = text.find_first_of(";{}", start);
+            if (end == std::string::npos) break;
+            bool terminated = text[end] == ';';
+            std::string statement = text.substr(start, end - start);
+            std::size_t statement_start = start;
+            start = end + 1;
+
+            for (auto &c : statement) {
+                if (c == '\n' || c == '\r' || c == '\t') c = ' ';
+            }
+
+            std::smatch match;
+            if (!terminated || !std::regex_match(statement, match, declaration)) continue;
+
+            Declaration result;
+            result.begin = statement_start + match[1].length();
+            result.end = end;
+            result.modifiers = match[3].str();
+            result.type = match[4].str();
+            // Anything blanked out in the middle of the statement (a comment or an #ifdef) would be lost by rewriting it.
+            result.rewritable = source.compare(result.begin, result.end - result.begin, text, result.begin, result.end - result.begin) == 0;
+
+            std::optional<int> first_location;
+            std::string qualifiers = match[2].str();
+            std::smatch location_match;
+            if (std::regex_search(qualifiers, location_match, location)) {
+                first_location = std::stoi(location_match[1].str());
+                bool between = location_match.prefix().length() > 0 && location_match.suffix().length() > 0;
+                qualifiers = location_match.prefix().str() + (between ? ", " : "") + location_match.suffix().str();
+            }
+            auto first = qualifiers.find_first_not_of(' ');
+            result.qualifiers = first == std::string::npos ? "" : qualifiers.substr(first, qualifiers.find_last_not_of(' ') - first + 1);
+
+            std::istringstream declarators(match[5].str());
+            for (std::string item; std::getline(declarators, item, ',');) {
+                std::smatch name;
+                if (!std::regex_match(item, name, declarator)) {
+                    // Probably a comma inside an initializer; keep what was understood but leave the text alone.
+                    result.rewritable = false;
+                    continue;
+                }
+
+                Declarator d{name[1].str(), name[2].str(), 1, std::nullopt};
+                if (name[3].matched) {
+                    std::string size = name[3].str();
+                    d.count = !size.empty() && std::all_of(size.begin(), size.end(), ::isdigit) ? std::optional(std::stoi(size)) : std::nullopt;
+                }
+                if (result.declarators.empty()) d.location = first_location;
+                result.declarators.push_back(std::move(d));
+            }
+
+            declarations.push_back(std::move(result));
+        }
+        return declarations;
+    }
+
+    // C++ type for a GLSL uniform type, or empty if gc::Uniform can't set it (structs, mostly).
+    static std::string cpp_type(const std::string &glsl) {
+        static const std::map<std::string, std::string> scalars = {
+            {"float", "float"}, {"int", "int"}, {"uint", "unsigned int"}, {"double", "double"}, {"bool", "int"},
+        };
+        static const std::map<std::string, std::string> vectors = {
+            {"vec", "glm::vec"}, {"ivec", "glm::ivec"}, {"uvec", "glm::uvec"}, {"dvec", "glm::dvec"}, {"bvec", "glm::ivec"},
+            {"mat", "glm::mat"}, {"dmat", "glm::dmat"},
+        };
+
+        if (auto it = scalars.find(glsl); it != scalars.end()) return it->second;
+
+        static const std::regex sized(R"(^([a-z]+?)([234](?:x[234])?)$)");
+        std::smatch match;
+        if (std::regex_match(glsl, match, sized)) {
+            if (auto it = vectors.find(match[1].str()); it != vectors.end()) return it->second + match[2].str();
+        }
+
+        if (glsl.find("sampler") != std::string::npos || glsl.find("image") != std::string::npos) return "int";
+        return {};
+    }
+
+    // Gives every declarator without a location (and with a known size) the first free run of locations, reusing the location a
+    // uniform of the same name already has in another stage so programs stay consistent. Rewrites the sources to declare them.
+    static bool assign_locations(std::vector<Shader> &shaders) {
+        std::map<std::string, int> by_name;
+        std::vector<bool> used;
+        auto mark = [&](int location, int count) {
+            if (used.size() < static_cast<std::size_t>(location + count)) used.resize(location + count);
+            for (int i = 0; i < count; i++) used[location + i] = true;
+        };
+
+        for (const auto &shader : shaders) {
+            for (const auto &declaration : shader.declarations) {
+                for (const auto &d : declaration.declarators) {
+                    if (!d.location) continue;
+                    mark(*d.location, d.count.value_or(1));
+                    by_name.emplace(d.name, *d.location);
+                }
+            }
+        }
+
+        bool ok = true;
+        for (auto &shader : shaders) {
+            // Back to front, so the offsets of the declarations not rewritten yet stay valid.
+            for (auto it = shader.declarations.rbegin(); it != shader.declarations.rend(); ++it) {
+                auto &declaration = *it;
+                bool changed = false;
+
+                for (auto &d : declaration.declarators) {
+                    if (d.location) continue;
+                    if (!d.count) {
+                        spdlog::warn("{}: {} has an array size that isn't a literal; give it an explicit location", shader.path.string(), d.name);
+                        continue;
+                    }
+                    if (cpp_type(declaration.type).empty()) continue; // structs take one location per member
+
+                    if (auto known = by_name.find(d.name); known != by_name.end()) {
+                        d.location = known->second;
+                    } else {
+                        int location = 0;
+                        while (true) {
+                            bool free = true;
+                            for (int i = 0; i < *d.count && free; i++) {
+                                free = static_cast<std::size_t>(location + i) >= used.size() || !used[location + i];
+                            }
+                            if (free) break;
+                            location++;
+                        }
+                        d.location = location;
+                        by_name.emplace(d.name, location);
+                        mark(location, *d.count);
+                    }
+                    changed = true;
+                }
+
+                if (!changed) continue;
+                if (!declaration.rewritable) {
+                    spdlog::error("{}: can't rewrite the declaration of {} to add a location; give it one explicitly", shader.path.string(),
+                                  declaration.declarators.front().name);
+                    ok = false;
+                    continue;
+                }
+
+                // One declaration per declarator, since a location only applies to the first.
+                std::string rewritten;
+                for (const auto &d : declaration.declarators) {
+                    if (!rewritten.empty()) rewritten += "; ";
+
+                    std::string layout = declaration.qualifiers;
+                    if (d.location) layout += (layout.empty() ? "" : ", ") + ("location = " + std::to_string(*d.location));
+                    if (!layout.empty()) rewritten += "layout(" + layout + ") ";
+                    rewritten += "uniform " + declaration.modifiers + declaration.type + " " + d.name + d.suffix;
+                }
+                shader.source.replace(declaration.begin, declaration.end - declaration.begin, rewritten);
+            }
+        }
+
+        if (used.size() > 1024) spdlog::warn("Assigned uniform locations up to {}; GL only guarantees 1024", used.size() - 1);
+        return ok;
+    }
+
+    static bool validate(const std::string &validator, const std::filesystem::path &shader, const std::string &source,
+                         const std::filesystem::path &directory) {
+        // glslangValidator picks the stage from the extension, so the expanded copy keeps the original file name.
+        std::filesystem::path expanded = directory / shader.filename();
+        std::ofstream(expanded, std::ios::binary) << source;
+
+        std::string command = "\"" + validator + "\" \"" + expanded.string() + "\"";
+        if (std::system(command.c_str()) != 0) {
+            spdlog::error("{} failed validation", shader.string());
+            return false;
+        }
+        return true;
+    }
+
+    static std::string escape_depfile_path(const std::filesystem::path &path) {
+        std::string out;
+        for (char c : path.generic_string()) {
+            if (c == ' ' || c == '#') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    static void write_program(std::ostringstream &out, const std::string &name, const std::vector<std::string> &files,
+                              const std::vector<Shader> &shaders) {
+        struct Field {
+            std::string type;
+            std::string name;
+        };
+
+        std::vector<Field> fields;
+        std::vector<std::string> sources;
+
+        for (const auto &file : files) {
+            auto shader = std::find_if(shaders.begin(), shaders.end(), [&](const Shader &s) { return s.path.filename() == file; });
+            if (shader == shaders.end()) {
+                spdlog::error("Program {} uses {}, which isn't one of the shaders", name, file);
+                continue;
+            }
+            sources.push_back(identifier(shader->path));
+
+            for (const auto &declaration : shader->declarations) {
+                std::string type = cpp_type(declaration.type);
+                for (const auto &d : declaration.declarators) {
+                    if (std::any_of(fields.begin(), fields.end(), [&](const Field &f) { return f.name == d.name; })) continue;
+                    if (type.empty()) continue;
+                    if (!d.location) {
+                        spdlog::warn("{}: {} has no location, so program {} leaves it out", file, d.name, name);
+                        continue;
+                    }
+
+                    if (d.count && !d.suffix.starts_with("["))
+                        fields.push_back({"gc::Uniform<" + type + ", " + std::to_string(*d.location) + ">", d.name});
+                    else if (d.count)
+                        fields.push_back({"gc::UniformArray<" + type + ", " + std::to_string(*d.location) + ", " + std::to_string(*d.count) + ">", d.name});
+                }
+            }
+        }
+
+        out << "    struct " << name << " {\n";
+        for (const auto &field : fields) {
+            out << "        " << field.type << " " << field.name << ";\n";
+        }
+        if (!fields.empty()) out << "\n";
+
+        out << "        explicit " << name << "(const gc::Shader &shader)";
+        for (std::size_t i = 0; i < fields.size(); i++) {
+            out << (i == 0 ? "\n            : " : ", ") << fields[i].name << "(shader)";
+        }
+        out << " {\n"
+            << (fields.empty() ? "            (void) shader;\n" : "")
+            << "        }\n\n";
+
+        out << "        static std::vector<gc::ShaderSource> sources() {\n"
+            << "            return {";
+        for (std::size_t i = 0; i < sources.size(); i++) {
+            out << (i == 0 ? "" : ", ") << sources[i];
+        }
+        out << "};\n"
+            << "        }\n"
+            << "    };\n\n";
+    }
+
+    static int run(const Options &options) {
+        ShaderPreprocessor preprocessor(options.include_directories);
+
+        std::filesystem::path directory = options.output.parent_path();
+        if (!directory.empty()) std::filesystem::create_directories(directory);
+
+        std::vector<std::filesystem::path> dependencies;
+        std::vector<Shader> shaders;
+        bool ok = true;
+
+        for (const auto &path : options.shaders) {
+            auto stage = stage_extensions.find(path.extension().string());
+            if (stage == stage_extensions.end()) {
+                spdlog::error("Can't tell the stage of {} from its extension", path.string());
+                ok = false;
+                continue;
+            }
+
+            auto processed = preprocessor.process(path, options.defines);
+            if (!processed) {
+                ok = false;
+                continue;
+            }
+            dependencies.insert(dependencies.end(), processed->dependencies.begin(), processed->dependencies.end());
+
+            Shader shader{path, stage->second, std::move(processed->source), {}};
+            shader.declarations = find_declarations(shader.source);
+            shaders.push_back(std::move(shader));
+        }
+
+        if (options.assign_locations && !assign_locations(shaders)) ok = false;
+
+        std::ostringstream out;
+        out << "// Generated by graphicat_shader_embed. Do not edit.\n"
+            << "#pragma once\n\n"
+            << "#include \"graphicat/graphics/shader.hpp\"\n";
+        if (!options.programs.empty()) out << "#include \"graphicat/graphics/uniform.hpp\"\n";
+        out << "#include <vector>\n\n"
+            << "namespace " << options.name_space << " {\n\n";
+
+        for (const auto &shader : shaders) {
+            if (!options.validator.empty() && !validate(options.validator, shader.path, shader.source, directory)) ok = false;
+
+            std::string id = identifier(shader.path);
+            out << "    inline constexpr char " << id << "_source[] = {";
+            for (std::size_t i = 0; i < shader.source.size(); i++) {
+                if (i % 24 == 0) out << "\n        ";
+                out << static_cast<int>(static_cast<unsigned char>(shader.source[i])) << ",";
+            }
+            out << "\n    };\n\n";
+
+            // Hashed after any locations were assigned, since this is the text that gets compiled.
+            out << "    inline constexpr gc::EmbeddedShader " << id << " = {gc::ShaderType::" << shader.stage << ", \""
+                << shader.path.filename().generic_string() << "\", std::string_view(" << id << "_source, sizeof(" << id << "_source)), 0x"
+                << std::hex << hash_shader_source(shader.source) << std::dec << "ull};\n\n";
+        }
+
+        std::map<std::string, std::optional<int>> merged;
+        for (const auto &shader : shaders) {
+            for (const auto &declaration : shader.declarations) {
+                for (const auto &d : declaration.declarators) {
+                    auto [it, inserted] = merged.emplace(d.name, d.location);
+                    if (inserted || !d.location) continue;
+                    if (!it->second) it->second = d.location;
+                    else if (*it->second != *d.location)
+                        spdlog::warn("{} declares {} at location {}, but another shader uses {}", shader.path.string(), d.name, *d.location,
+                                     *it->second);
+                }
+            }
+        }
+
+        out << "    namespace uniforms {\n";
+        for (const auto &[name, location] : merged) {
+            out << "        inline constexpr gc::UniformName " << name << " = \"" << name << "\";\n";
+        }
+        out << "    } // uniforms\n\n";
+
+        out << "    // Only uniforms with an explicit (or assigned) layout(location = N) are known before link.\n"
+            << "    namespace locations {\n";
+        for (const auto &[name, location] : merged) {
+            if (location) out << "        inline constexpr int " << name << " = " << *location << ";\n";
+        }
+        out << "    } // locations\n\n";
+
+        for (const auto &[name, files] : options.programs) {
+            write_program(out, name, files, shaders);
+        }
+
+        out << "} // " << options.name_space << "\n";
+
+        if (!ok) return 1;
+
+        std::ofstream(options.output, std::ios::binary) << out.str();
+
+        if (!options.depfile.empty()) {
+            std::ofstream depfile(options.depfile);
+            depfile << escape_depfile_path(options.output) << ":";
+            for (const auto &dependency : dependencies) {
+                depfile << " \\\n  " << escape_depfile_path(std::filesystem::absolute(dependency));
+            }
+            depfile << "\n";
+        }
+
+        return 0;
+    }
+
+} // gc::tools
+
+int main(int argc, char **argv) {
+    auto options = gc::tools::parse_arguments(argc, argv);
+    if (!options) return 2;
+    return gc::tools::run(*options);
+}